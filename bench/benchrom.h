@@ -0,0 +1,106 @@
+#pragma once
+
+#include "cartridge.h"
+#include <memory>
+#include <vector>
+
+// Mix of loads, stores, read-modify-write and arithmetic over zero page and absolute
+// indexed, with a pad read every loop like most game main loops. Jumps back to start.
+inline std::vector<uint8_t> BenchLoop(uint16_t start)
+{
+    return {
+        0xA9, 0x01,       // LDA #1
+        0x8D, 0x16, 0x40, // STA $4016
+        0xA9, 0x00,       // LDA #0
+        0x8D, 0x16, 0x40, // STA $4016
+        0xAD, 0x16, 0x40, // LDA $4016
+        0xA2, 0x10,       // LDX #$10
+        0x7D, 0x00, 0x03, // ADC $0300,X
+        0x9D, 0x00, 0x03, // STA $0300,X
+        0xE6, 0x20,       // INC $20
+        0xA5, 0x20,       // LDA $20
+        0x0A,             // ASL A
+        0x85, 0x21,       // STA $21
+        0xE9, 0x03,       // SBC #3
+        0xAA,             // TAX
+        0xFE, 0x00, 0x04, // INC $0400,X
+        0x4C, static_cast<uint8_t>(start), static_cast<uint8_t>(start >> 8), // JMP start
+    };
+}
+
+// 16K NROM, program at $C000 and, if there is one, an NMI handler at $F000.
+inline std::shared_ptr<nes::Cartridge const> MakeBenchCartridge(std::vector<uint8_t> const& program,
+                                                                std::vector<uint8_t> const& handler = {})
+{
+    nes::Cartridge cartridge = {};
+    cartridge.header = { { 'N', 'E', 'S', 0x1A }, 1, 0, 0, 0, 0, 0, 0, { 0 } };
+    cartridge.prgRom.assign(nes::ProgRomBankSize, 0xEA);
+    std::copy(program.begin(), program.end(), cartridge.prgRom.begin());
+    std::copy(handler.begin(), handler.end(), cartridge.prgRom.begin() + 0x3000);
+    cartridge.prgRom[0x3FFA] = 0x00;
+    cartridge.prgRom[0x3FFB] = 0xF0;
+    cartridge.prgRom[0x3FFC] = 0x00;
+    cartridge.prgRom[0x3FFD] = 0xC0;
+
+    return std::make_shared<nes::Cartridge const>(std::move(cartridge));
+}
+
+// Stand-in for a game until we have a bundle of homebrew to run. Never touches the PPU.
+inline std::shared_ptr<nes::Cartridge const> MakeBenchCartridge()
+{
+    return MakeBenchCartridge(BenchLoop(0xC000));
+}
+
+// LDA #value, STA address
+inline void BenchStore(std::vector<uint8_t>& program, uint16_t address, uint8_t value)
+{
+    program.insert(program.end(), { 0xA9, value, 0x8D, static_cast<uint8_t>(address), static_cast<uint8_t>(address >> 8) });
+}
+
+// The same loop with a screen full of tiles and all 64 sprites up, and an NMI
+// handler that scrolls and does OAM DMA every frame like a game would. The setup
+// is straight line code, there are no branches yet.
+inline std::shared_ptr<nes::Cartridge const> MakeRenderingBenchCartridge()
+{
+    std::vector<uint8_t> program;
+    BenchStore(program, 0x2006, 0x3F);
+    BenchStore(program, 0x2006, 0x00);
+    for (uint8_t i = 0; i < 32; i++)
+        BenchStore(program, 0x2007, static_cast<uint8_t>(0x01 + i * 7 % 0x3C));
+
+    // Four tiles of CHR RAM, something different in every row of both planes
+    BenchStore(program, 0x2006, 0x00);
+    BenchStore(program, 0x2006, 0x00);
+    for (uint8_t i = 0; i < 64; i++)
+        BenchStore(program, 0x2007, static_cast<uint8_t>((i * 0x35) ^ 0xA5));
+
+    // Nametable and then attributes
+    BenchStore(program, 0x2006, 0x20);
+    BenchStore(program, 0x2006, 0x00);
+    for (unsigned i = 0; i < 0x400; i++)
+        BenchStore(program, 0x2007, static_cast<uint8_t>(i < 0x3C0 ? i % 4 : i * 0x1B));
+
+    // Sprites in a diagonal band so lines have anywhere from none to too many
+    for (unsigned i = 0; i < 0x100; i++)
+    {
+        uint8_t const sprite[] = { static_cast<uint8_t>(i / 4 * 3), static_cast<uint8_t>(i / 4 % 4),
+                                   static_cast<uint8_t>(i / 4 % 4), static_cast<uint8_t>(i / 4 * 13) };
+        BenchStore(program, static_cast<uint16_t>(0x0200 + i), sprite[i % 4]);
+    }
+
+    BenchStore(program, 0x2000, 0x80);
+    BenchStore(program, 0x2001, 0x1E);
+
+    auto const loop = BenchLoop(static_cast<uint16_t>(0xC000 + program.size()));
+    program.insert(program.end(), loop.begin(), loop.end());
+
+    return MakeBenchCartridge(program, {
+        0xE6, 0x30,       // INC $30
+        0xA5, 0x30,       // LDA $30
+        0x8D, 0x05, 0x20, // STA $2005
+        0x8D, 0x05, 0x20, // STA $2005
+        0xA9, 0x02,       // LDA #2
+        0x8D, 0x14, 0x40, // STA $4014
+        0x40,             // RTI
+    });
+}
@@ -0,0 +1,105 @@
+// Bus reads and writes through CPUMemory, region by region, against a flat array
+// to show what the address decoding costs, and what watchpoints cost on and off
+// the page being watched.
+
+#include "cpumemory.h"
+#include "flatmemory.h"
+#include "heatmap.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+static void BM_FlatRead(benchmark::State& state)
+{
+    auto memory = std::make_unique<nes::FlatMemory>();
+    uint16_t address = 0;
+    uint8_t sum = 0;
+    for (auto _ : state)
+    {
+        sum += memory->Read(address++);
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlatRead);
+
+// range(0) is the start of the region, range(1) the size.
+static void BM_BusRead(benchmark::State& state)
+{
+    std::vector<uint8_t> ram(0x800);
+    std::vector<uint8_t> rom(0x8000, 0xEA);
+    nes::CPUMemory memory(ram);
+    memory.SetPrgRom(rom);
+
+    nes::Memory& bus = memory;
+    auto const start = static_cast<uint16_t>(state.range(0));
+    auto const mask = static_cast<uint16_t>(state.range(1) - 1);
+    uint16_t offset = 0;
+    uint8_t sum = 0;
+    for (auto _ : state)
+    {
+        sum += bus.Read(start + (offset++ & mask));
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BusRead)
+    ->ArgNames({ "start", "size" })
+    ->Args({ 0x0000, 0x0800 })  // RAM
+    ->Args({ 0x0800, 0x1000 })  // RAM mirrors
+    ->Args({ 0x2000, 0x0008 })  // PPU registers
+    ->Args({ 0x4016, 0x0002 })  // Pads
+    ->Args({ 0x8000, 0x8000 }); // PRG
+
+static void BM_BusWrite(benchmark::State& state)
+{
+    std::vector<uint8_t> ram(0x800);
+    nes::CPUMemory memory(ram);
+
+    nes::Memory& bus = memory;
+    auto const start = static_cast<uint16_t>(state.range(0));
+    auto const mask = static_cast<uint16_t>(state.range(1) - 1);
+    uint16_t offset = 0;
+    for (auto _ : state)
+    {
+        bus.Write(start + (offset & mask), static_cast<uint8_t>(offset));
+        offset++;
+    }
+    benchmark::DoNotOptimize(ram.data());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BusWrite)
+    ->ArgNames({ "start", "size" })
+    ->Args({ 0x0000, 0x0800 })
+    ->Args({ 0x2000, 0x0008 })
+    ->Args({ 0x4016, 0x0001 });
+
+// RAM reads with a watchpoint at $6000 (range(0) == 0, shouldn't cost anything),
+// one on the page being read (1), or the heatmap on (2).
+static void BM_BusReadWatched(benchmark::State& state)
+{
+    std::vector<uint8_t> ram(0x800);
+    nes::CPUMemory memory(ram);
+    nes::Heatmap heatmap;
+    uint64_t hits = 0;
+    memory.onWatch = [&](nes::WatchHit const&) { hits++; };
+
+    if (state.range(0) == 0)
+        memory.AddWatchpoint(0x6000, 0x6000, nes::WatchRead);
+    else if (state.range(0) == 1)
+        memory.AddWatchpoint(0x00FF, 0x00FF, nes::WatchRead);
+    else
+        memory.SetHeatmap(&heatmap);
+
+    nes::Memory& bus = memory;
+    uint16_t offset = 0;
+    uint8_t sum = 0;
+    for (auto _ : state)
+    {
+        sum += bus.Read(offset++ & 0xFF);
+    }
+    benchmark::DoNotOptimize(sum);
+    benchmark::DoNotOptimize(hits);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BusReadWatched)->ArgName("mode")->DenseRange(0, 2);
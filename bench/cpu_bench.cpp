@@ -0,0 +1,142 @@
+// CPU core on its own, one benchmark per implemented opcode. Memory is the same
+// instruction over and over from $1000, so what's measured is fetch, decode and
+// execute with a bus that costs as little as possible.
+//
+// Run with --benchmark_format=json (or --benchmark_out=file.json) to track over time.
+
+#include "cpu.h"
+#include "flatmemory.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+static char const* ModeName(nes::AddressMode mode)
+{
+    switch (mode)
+    {
+        case nes::AddressMode::Implicit: return "Implicit";
+        case nes::AddressMode::Accumulator: return "Accumulator";
+        case nes::AddressMode::Immediate: return "Immediate";
+        case nes::AddressMode::ZeroPage: return "ZeroPage";
+        case nes::AddressMode::ZeroPageX: return "ZeroPageX";
+        case nes::AddressMode::ZeroPageY: return "ZeroPageY";
+        case nes::AddressMode::Relative: return "Relative";
+        case nes::AddressMode::Absolute: return "Absolute";
+        case nes::AddressMode::AbsoluteX: return "AbsoluteX";
+        case nes::AddressMode::AbsoluteY: return "AbsoluteY";
+        case nes::AddressMode::Indirect: return "Indirect";
+        case nes::AddressMode::IndexedIndirect: return "IndexedIndirect";
+        case nes::AddressMode::IndirectIndexed: return "IndirectIndexed";
+    }
+    return "?";
+}
+
+constexpr uint16_t ProgramStart = 0x1000;
+constexpr uint16_t ProgramEnd = 0x8000;
+
+static void FillProgram(nes::FlatMemory& memory, uint8_t opcode)
+{
+    auto const& info = nes::CPU::Info(opcode);
+
+    // Operands point at $0200 or zero page $10, well away from the code. Jumps go
+    // back to the start so they loop on themselves.
+    uint8_t low = 0x00, high = 0x02;
+    if (opcode == 0x4C)
+    {
+        high = ProgramStart >> 8;
+    }
+    else if (opcode == 0x6C)
+    {
+        memory.data[0x0200] = ProgramStart & 0xFF;
+        memory.data[0x0201] = ProgramStart >> 8;
+    }
+    else if (info.instructionSize == 2)
+    {
+        low = 0x10;
+    }
+
+    for (uint32_t address = ProgramStart; address + info.instructionSize <= ProgramEnd; address += info.instructionSize)
+    {
+        memory.data[address] = opcode;
+        if (info.instructionSize > 1)
+            memory.data[address + 1] = low;
+        if (info.instructionSize > 2)
+            memory.data[address + 2] = high;
+    }
+
+    memory.data[0xFFFC] = ProgramStart & 0xFF;
+    memory.data[0xFFFD] = ProgramStart >> 8;
+}
+
+static void BM_Opcode(benchmark::State& state, uint8_t opcode)
+{
+    auto const& info = nes::CPU::Info(opcode);
+    auto memory = std::make_unique<nes::FlatMemory>();
+    FillProgram(*memory, opcode);
+
+    nes::CPU cpu(memory.get());
+    cpu.Reset();
+
+    uint64_t cycles = 0;
+    uint16_t const wrap = ProgramEnd - info.instructionSize;
+    for (auto _ : state)
+    {
+        cycles += cpu.Step();
+        if (cpu.pc > wrap)
+            cpu.pc = ProgramStart;
+    }
+
+    benchmark::DoNotOptimize(cpu.a);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["cycles/instr"] = static_cast<double>(cycles) / state.iterations();
+}
+
+static void BM_StepMixed(benchmark::State& state)
+{
+    // Every implemented opcode in turn, so the dispatch branch can't just learn one target.
+    auto memory = std::make_unique<nes::FlatMemory>();
+    uint32_t address = ProgramStart;
+    for (int opcode = 0; opcode < 256; opcode++)
+    {
+        auto const& info = nes::CPU::Info(static_cast<uint8_t>(opcode));
+        if (!info.instruction || opcode == 0x4C || opcode == 0x6C)
+            continue;
+
+        memory->data[address] = static_cast<uint8_t>(opcode);
+        memory->data[address + 1] = 0x10;
+        memory->data[address + 2] = 0x02;
+        address += info.instructionSize;
+    }
+    uint16_t const end = static_cast<uint16_t>(address);
+    memory->data[0xFFFD] = ProgramStart >> 8;
+
+    nes::CPU cpu(memory.get());
+    cpu.Reset();
+    for (auto _ : state)
+    {
+        cpu.Step();
+        if (cpu.pc >= end)
+            cpu.pc = ProgramStart;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StepMixed);
+
+static bool RegisterOpcodeBenchmarks()
+{
+    for (int opcode = 0; opcode < 256; opcode++)
+    {
+        auto const& info = nes::CPU::Info(static_cast<uint8_t>(opcode));
+        if (!info.instruction)
+            continue;
+
+        char name[64];
+        snprintf(name, sizeof(name), "BM_Opcode/%02X/%s", opcode, ModeName(info.addressMode));
+        benchmark::RegisterBenchmark(name, BM_Opcode, static_cast<uint8_t>(opcode));
+    }
+    return true;
+}
+
+static bool const opcodeBenchmarks = RegisterOpcodeBenchmarks();
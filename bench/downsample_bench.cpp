@@ -0,0 +1,57 @@
+// 84x84 grayscale observations from palette indices, one frame and a batch of them
+// the way an RL trainer would ask for a step's worth.
+
+#include "downsample.h"
+#include "scheduler.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+static std::unique_ptr<nes::FrameBuffer> BenchFrame()
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (size_t i = 0; i < frame->size(); i++)
+        (*frame)[i] = static_cast<nes::Pixel>((i / 8 * 13 + i / nes::FrameWidth) & nes::PixelIndexMask);
+    return frame;
+}
+
+// range(0) is 0 for area, 1 for max, range(1) 1 for the SIMD path.
+static void BM_Downsample(benchmark::State& state)
+{
+    nes::Downsampler downsampler({ .mode = state.range(0) ? nes::DownsampleMode::Max : nes::DownsampleMode::Area });
+    auto const frame = BenchFrame();
+    std::vector<uint8_t> out(downsampler.Bytes());
+    for (auto _ : state)
+    {
+        if (state.range(1))
+            downsampler.Apply(*frame, out.data());
+        else
+            downsampler.ApplyScalar(*frame, out.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Downsample)->ArgNames({ "max", "simd" })->Args({ 0, 1 })->Args({ 0, 0 })->Args({ 1, 1 })->Args({ 1, 0 });
+
+// range(0) frames, range(1) workers, 0 for this thread only.
+static void BM_DownsampleBatch(benchmark::State& state)
+{
+    nes::Downsampler downsampler;
+    auto const frame = BenchFrame();
+    std::vector<nes::FrameBuffer const*> frames(static_cast<size_t>(state.range(0)), frame.get());
+    std::vector<uint8_t> out(downsampler.Bytes() * frames.size());
+
+    std::unique_ptr<nes::JobScheduler> scheduler;
+    if (state.range(1) > 0)
+        scheduler = std::make_unique<nes::JobScheduler>(static_cast<unsigned>(state.range(1)), false);
+
+    for (auto _ : state)
+    {
+        downsampler.ApplyBatch(frames, out.data(), scheduler.get());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DownsampleBatch)->ArgNames({ "frames", "workers" })->Args({ 64, 0 })->Args({ 64, 4 })->UseRealTime();
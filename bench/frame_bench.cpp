@@ -0,0 +1,88 @@
+// Whole frames on a full console. Always runs the built in bench program, plus
+// every .nes in $NES_BENCH_ROMS if that's set, one benchmark per ROM.
+
+#include "benchrom.h"
+#include "console.h"
+#include "host.h"
+#include "scheduler.h"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <filesystem>
+
+static void BM_Frame(benchmark::State& state, std::shared_ptr<nes::Cartridge const> cartridge)
+{
+    nes::Console console(cartridge);
+    console.Reset();
+
+    for (auto _ : state)
+    {
+        console.RunFrame();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["instr/s"] = benchmark::Counter(static_cast<double>(console.instructions), benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_Frame, builtin, MakeBenchCartridge());
+
+// A frame with the PPU drawing every renderEvery'th of them, 0 for none.
+static void BM_FrameRenderEvery(benchmark::State& state)
+{
+    nes::Console console(MakeRenderingBenchCartridge());
+    console.renderEvery = static_cast<uint32_t>(state.range(0));
+    console.Reset();
+    console.RunFrame(); // Setup
+
+    for (auto _ : state)
+    {
+        console.RunFrame();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FrameRenderEvery)->ArgName("every")->Arg(1)->Arg(2)->Arg(4)->Arg(0);
+
+// Frames across lots of instances on every core, through the Host and scheduler.
+static void BM_HostFrames(benchmark::State& state)
+{
+    nes::JobScheduler scheduler(0, true);
+    nes::Host host(scheduler);
+    auto cartridge = MakeBenchCartridge();
+    for (int64_t i = 0; i < state.range(0); i++)
+    {
+        auto console = std::make_unique<nes::Console>(cartridge);
+        console->Reset();
+        host.Add(std::move(console));
+    }
+
+    for (auto _ : state)
+    {
+        host.RunFrames(1);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HostFrames)->ArgName("instances")->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+static bool RegisterRomBenchmarks()
+{
+    auto const* directory = std::getenv("NES_BENCH_ROMS");
+    if (!directory)
+        return false;
+
+    std::error_code error;
+    for (auto const& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() != ".nes")
+            continue;
+
+        auto cartridge = nes::Cartridge::Load(entry.path().string());
+        if (!cartridge || cartridge->Unsupported())
+            continue;
+
+        auto name = "BM_Frame/" + entry.path().stem().string();
+        benchmark::RegisterBenchmark(name.c_str(), BM_Frame, std::make_shared<nes::Cartridge const>(std::move(*cartridge)));
+    }
+    return true;
+}
+
+static bool const romBenchmarks = RegisterRomBenchmarks();
@@ -0,0 +1,29 @@
+// Tile hashes and dirty tiles for a whole frame, what FramePacingOptions::digest
+// adds to every frame on the emulation thread.
+
+#include "framehash.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+
+using Hasher = void (*)(nes::FrameBuffer const&, nes::TileHashes&);
+
+static void BM_HashTiles(benchmark::State& state, Hasher hash)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (size_t i = 0; i < frame->size(); i++)
+        (*frame)[i] = static_cast<nes::Pixel>((i / 8 * 13) & nes::PixelIndexMask);
+
+    nes::TileHashes before, after;
+    hash(*frame, before);
+    for (auto _ : state)
+    {
+        (*frame)[state.iterations() % frame->size()]++;
+        hash(*frame, after);
+        benchmark::DoNotOptimize(nes::HashFrame(after));
+        benchmark::DoNotOptimize(nes::CompareTiles(before, after));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_HashTiles, simd, nes::HashTiles);
+BENCHMARK_CAPTURE(BM_HashTiles, scalar, nes::HashTilesScalar);
@@ -0,0 +1,41 @@
+// NTSC filter on a whole frame, on this thread and banded across a scheduler.
+// 60 fps needs a frame in under 16.7ms.
+
+#include "ntsc.h"
+#include "scheduler.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// range(0) is the scale, range(1) the worker count, 0 for this thread only.
+static void BM_NtscFrame(benchmark::State& state)
+{
+    nes::NtscFilter filter({ .scale = static_cast<unsigned>(state.range(0)) });
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (size_t i = 0; i < frame->size(); i++)
+        (*frame)[i] = static_cast<nes::Pixel>((i / 8 * 13) & nes::PixelIndexMask);
+
+    std::unique_ptr<nes::JobScheduler> scheduler;
+    if (state.range(1) > 0)
+        scheduler = std::make_unique<nes::JobScheduler>(static_cast<unsigned>(state.range(1)), false);
+
+    size_t const stride = filter.OutputWidth() * 4;
+    std::vector<uint8_t> out(stride * filter.OutputHeight());
+    uint64_t frameNumber = 0;
+    for (auto _ : state)
+    {
+        filter.Apply(*frame, frameNumber++, out.data(), stride, scheduler.get());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["pixels/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * filter.OutputWidth() * filter.OutputHeight(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_NtscFrame)
+    ->ArgNames({ "scale", "workers" })
+    ->Args({ 2, 0 })
+    ->Args({ 8, 0 })
+    ->Args({ 8, 2 })
+    ->Args({ 8, 4 })
+    ->UseRealTime();
@@ -0,0 +1,41 @@
+// Palette index to display pixels for a whole frame, scalar against AVX2, in every
+// output format. Pixels per second is the number to watch.
+
+#include "frame.h"
+#include "palette.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using Converter = void (*)(std::span<nes::Pixel const>, unsigned, nes::PaletteLut const&, uint8_t*, size_t);
+
+// range(0) is the PixelFormat.
+static void BM_ConvertFrame(benchmark::State& state, Converter convert)
+{
+    auto const format = static_cast<nes::PixelFormat>(state.range(0));
+    nes::PaletteLut const lut(nes::Palette::Default(), format);
+
+    // Something frame like, runs of the same colour with some emphasis here and there
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    uint32_t seed = 1;
+    for (size_t i = 0; i < frame->size(); i++)
+    {
+        if (i % 8 == 0)
+            seed = seed * 1664525 + 1013904223;
+        (*frame)[i] = static_cast<nes::Pixel>((seed >> 16) & nes::PixelMask);
+    }
+
+    size_t const stride = nes::FrameWidth * nes::BytesPerPixel(format);
+    std::vector<uint8_t> out(stride * nes::FrameHeight);
+    for (auto _ : state)
+    {
+        convert(*frame, nes::FrameWidth, lut, out.data(), stride);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["pixels/s"] = benchmark::Counter(static_cast<double>(state.iterations() * frame->size()),
+                                                    benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_ConvertFrame, scalar, nes::ConvertPixelsScalar)->ArgName("format")->DenseRange(0, 3);
+BENCHMARK_CAPTURE(BM_ConvertFrame, best, nes::ConvertPixels)->ArgName("format")->DenseRange(0, 3);
@@ -0,0 +1,47 @@
+// PNG encoding of a whole frame, and what a request costs the thread asking for one,
+// which is the number that matters for emulation.
+
+#include "screenshot.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+
+static std::unique_ptr<nes::FrameBuffer> BenchFrame()
+{
+    // Tile sized blocks of colour, a bit like a real screen
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (unsigned y = 0; y < nes::FrameHeight; y++)
+        for (unsigned x = 0; x < nes::FrameWidth; x++)
+            (*frame)[y * nes::FrameWidth + x] = static_cast<nes::Pixel>(((x / 8) * 7 + (y / 8) * 13 + (x ^ y) % 3) & nes::PixelIndexMask);
+    return frame;
+}
+
+// range(0) is the shrink, 2 for thumbnails.
+static void BM_EncodePng(benchmark::State& state)
+{
+    auto const frame = BenchFrame();
+    auto const palette = nes::Palette::Default();
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        auto const png = nes::EncodePng(*frame, palette, { .shrink = static_cast<unsigned>(state.range(0)) });
+        bytes = png.size();
+        benchmark::DoNotOptimize(png.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["png_bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_EncodePng)->ArgName("shrink")->Arg(1)->Arg(2);
+
+// Same key every time, so once the encoder's behind it's all coalescing.
+static void BM_ScreenshotRequest(benchmark::State& state)
+{
+    auto const frame = BenchFrame();
+    nes::ScreenshotWriter writer;
+    for (auto _ : state)
+        writer.Encode("thumbnail", *frame, { .shrink = 2 }, [](std::vector<uint8_t> const&) {});
+
+    state.SetItemsProcessed(state.iterations());
+    writer.Flush();
+}
+BENCHMARK(BM_ScreenshotRequest);
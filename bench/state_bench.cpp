@@ -0,0 +1,102 @@
+// Snapshot, restore and re-simulation costs, which decide how far run-ahead and
+// rollback can go inside one 16.6ms host frame.
+
+#include "benchrom.h"
+#include "console.h"
+#include "rollback.h"
+#include "runahead.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+
+static void BM_SaveState(benchmark::State& state)
+{
+    nes::Console console(MakeBenchCartridge());
+    console.Reset();
+    console.RunFrame();
+
+    nes::ConsoleState snapshot;
+    for (auto _ : state)
+    {
+        console.Save(snapshot);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(snapshot));
+}
+BENCHMARK(BM_SaveState);
+
+static void BM_LoadState(benchmark::State& state)
+{
+    nes::Console console(MakeBenchCartridge());
+    console.Reset();
+    console.RunFrame();
+
+    nes::ConsoleState snapshot;
+    console.Save(snapshot);
+    for (auto _ : state)
+    {
+        console.Load(snapshot);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(snapshot));
+}
+BENCHMARK(BM_LoadState);
+
+// What a rollback of range(0) frames costs: restore then run them all again.
+static void BM_RollbackResimulate(benchmark::State& state)
+{
+    nes::Console console(MakeBenchCartridge());
+    console.Reset();
+    console.RunFrame();
+
+    nes::ConsoleState snapshot;
+    console.Save(snapshot);
+    for (auto _ : state)
+    {
+        console.Load(snapshot);
+        for (int64_t i = 0; i < state.range(0); i++)
+            console.RunFrame();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RollbackResimulate)->ArgName("frames")->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+
+// A full session against a loopback peer with latency range(0), counting only our side.
+static void BM_RollbackSession(benchmark::State& state)
+{
+    auto cartridge = MakeBenchCartridge();
+    nes::LoopbackLink link(static_cast<uint32_t>(state.range(0)));
+    nes::Console consoles[2] = { nes::Console(cartridge), nes::Console(cartridge) };
+    nes::RollbackSession local(consoles[0], link.End(0), 0, 16);
+    nes::RollbackSession remote(consoles[1], link.End(1), 1, 16);
+    consoles[0].Reset();
+    consoles[1].Reset();
+
+    uint64_t frame = 0;
+    for (auto _ : state)
+    {
+        // Remote player changes input every 4 frames, so predictions go wrong often.
+        local.AdvanceFrame(0);
+        state.PauseTiming();
+        remote.AdvanceFrame((frame++ / 4) % 2 ? nes::Controller::A : 0);
+        link.Advance();
+        state.ResumeTiming();
+    }
+
+    auto const& stats = local.GetStats();
+    state.counters["rollbacks"] = static_cast<double>(stats.rollbacks);
+    state.counters["resim/frame"] = static_cast<double>(stats.resimulatedFrames) / std::max<uint64_t>(1, stats.frames);
+}
+BENCHMARK(BM_RollbackSession)->ArgName("latency")->Arg(2)->Arg(6);
+
+static void BM_RunAhead(benchmark::State& state)
+{
+    nes::RunAhead runAhead(MakeBenchCartridge(), static_cast<uint32_t>(state.range(0)), state.range(1) != 0);
+    runAhead.Reset();
+
+    for (auto _ : state)
+    {
+        runAhead.RunFrame({ 0, 0 });
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RunAhead)->ArgNames({ "ahead", "second" })->Args({ 1, 0 })->Args({ 2, 0 })->Args({ 2, 1 });
@@ -0,0 +1,60 @@
+// What tracing costs the emulation thread. BM_TracePush is the ring on its own
+// with the writer draining it, BM_Frame/traced (NES_TRACER=ON builds) is the whole
+// thing against BM_Frame/builtin.
+
+#include "benchrom.h"
+#include "console.h"
+#include "trace.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+
+static std::string BenchTracePath()
+{
+    return (std::filesystem::temp_directory_path() / "nes_trace_bench.bin").string();
+}
+
+static void BM_TracePush(benchmark::State& state)
+{
+    auto const path = BenchTracePath();
+    {
+        nes::Tracer tracer(path);
+        nes::TraceRecord record {};
+        for (auto _ : state)
+        {
+            record.pc++;
+            record.cycle += 3;
+            tracer.Push(record);
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["stalls"] = static_cast<double>(tracer.Stalls());
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_TracePush);
+
+#if NES_TRACER
+static void BM_FrameTraced(benchmark::State& state)
+{
+    auto const path = BenchTracePath();
+    {
+        nes::Console console(MakeBenchCartridge());
+        console.Reset();
+        nes::Tracer tracer(path);
+        console.cpu.tracer = &tracer;
+
+        for (auto _ : state)
+        {
+            console.RunFrame();
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.counters["instr/s"] = benchmark::Counter(static_cast<double>(console.instructions), benchmark::Counter::kIsRate);
+        state.counters["stalls"] = static_cast<double>(tracer.Stalls());
+        state.counters["bytes/instr"] = static_cast<double>(tracer.BytesWritten()) / console.instructions;
+        console.cpu.tracer = nullptr;
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(BM_FrameTraced)->Name("BM_Frame/traced");
+#endif
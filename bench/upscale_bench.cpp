@@ -0,0 +1,42 @@
+// Scale2x/3x/4x on a whole frame, on this thread and banded across a scheduler. Time
+// is per frame in ms, 60 fps needs under 16.7.
+
+#include "scheduler.h"
+#include "upscale.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+// range(0) is the scale, range(1) the worker count, 0 for this thread only.
+static void BM_Upscale(benchmark::State& state)
+{
+    nes::Upscaler upscaler({ .scale = static_cast<unsigned>(state.range(0)) });
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (unsigned y = 0; y < nes::FrameHeight; y++)
+        for (unsigned x = 0; x < nes::FrameWidth; x++)
+            (*frame)[y * nes::FrameWidth + x] = static_cast<nes::Pixel>(((x + y) / 8 % 5 == 0 || (x / 16 + y / 16) % 3 == 0) ? 0x30 : 0x0F);
+
+    std::unique_ptr<nes::JobScheduler> scheduler;
+    if (state.range(1) > 0)
+        scheduler = std::make_unique<nes::JobScheduler>(static_cast<unsigned>(state.range(1)), false);
+
+    size_t const stride = upscaler.OutputWidth() * 4;
+    std::vector<uint8_t> out(stride * upscaler.OutputHeight());
+    for (auto _ : state)
+    {
+        upscaler.Apply(*frame, out.data(), stride, scheduler.get());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["pixels/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * upscaler.OutputWidth() * upscaler.OutputHeight(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Upscale)
+    ->ArgNames({ "scale", "workers" })
+    ->Args({ 2, 0 })
+    ->Args({ 3, 0 })
+    ->Args({ 4, 0 })
+    ->Args({ 4, 4 })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,206 @@
+#include "downsample.h"
+#include "scheduler.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace nes
+{
+
+Downsampler::Downsampler(DownsampleOptions const& options, Palette const& palette)
+    : mode(options.mode)
+    , luma(PaletteSize)
+{
+    unsigned const cropped = std::min(options.cropTop + options.cropBottom, FrameHeight - 1);
+    unsigned const top = std::min(options.cropTop, cropped);
+    unsigned const lines = FrameHeight - cropped;
+    width = std::clamp(options.width, 1u, FrameWidth);
+    height = std::clamp(options.height, 1u, lines);
+    across = MakeTaps(FrameWidth, width, 0);
+    down = MakeTaps(lines, height, top);
+
+    // Same weights as PixelFormat::Gray8, without the rounding
+    for (size_t i = 0; i < PaletteSize; i++)
+    {
+        uint32_t const color = palette.colors[i];
+        luma[i] = (77.0f * (color >> 16 & 0xFF) + 150.0f * (color >> 8 & 0xFF) + 29.0f * (color & 0xFF)) / 256.0f;
+    }
+}
+
+// Everything in units of 1/outputs of an input pixel, so which pixels touch an
+// output and by how much comes out exact, and Max never picks up a pixel that's
+// only in by rounding error.
+Downsampler::Taps Downsampler::MakeTaps(unsigned inputs, unsigned outputs, unsigned offset)
+{
+    Taps taps;
+    for (unsigned o = 0; o < outputs; o++)
+    {
+        unsigned const first = o * inputs / outputs;
+        unsigned const last = ((o + 1) * inputs - 1) / outputs;
+        taps.count = std::max(taps.count, last - first + 1);
+    }
+
+    taps.index.resize(size_t { taps.count } * outputs);
+    taps.weight.resize(size_t { taps.count } * outputs);
+    for (unsigned o = 0; o < outputs; o++)
+    {
+        unsigned const start = o * inputs;
+        unsigned const end = (o + 1) * inputs;
+        unsigned const first = start / outputs;
+        unsigned const last = (end - 1) / outputs;
+        for (unsigned k = 0; k < taps.count; k++)
+        {
+            unsigned const p = std::min(first + k, last);
+            unsigned const overlap = first + k > last ? 0
+                                                      : std::min((p + 1) * outputs, end) - std::max(p * outputs, start);
+            taps.index[size_t { k } * outputs + o] = static_cast<int32_t>(p + offset);
+            taps.weight[size_t { k } * outputs + o] = static_cast<float>(overlap) / static_cast<float>(inputs);
+        }
+    }
+    return taps;
+}
+
+static void LumaLine(Pixel const* pixels, float const* luma, float* line)
+{
+    for (unsigned x = 0; x < FrameWidth; x++)
+        line[x] = luma[pixels[x] & PixelMask];
+}
+
+#if NES_AVX2
+
+__attribute__((target("avx2"))) static void LumaLineAvx2(Pixel const* pixels, float const* luma, float* line)
+{
+    auto const mask = _mm256_set1_epi32(PixelMask);
+    for (unsigned x = 0; x < FrameWidth; x += 8)
+    {
+        auto const indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels + x)));
+        _mm256_storeu_ps(line + x, _mm256_i32gather_ps(luma, _mm256_and_si256(indices, mask), 4));
+    }
+}
+
+// 8 outputs at a time, each gathering its k'th tap from the line. Returns how many
+// it did, the rest are left for the scalar loop.
+__attribute__((target("avx2,fma"))) static unsigned AcrossAvx2(float const* line, int32_t const* index,
+                                                               float const* weight, unsigned taps, unsigned width,
+                                                               bool max, float* row)
+{
+    unsigned j = 0;
+    for (; j + 8 <= width; j += 8)
+    {
+        auto sum = _mm256_setzero_ps();
+        for (unsigned k = 0; k < taps; k++)
+        {
+            auto const v = _mm256_i32gather_ps(line, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(index + k * width + j)), 4);
+            sum = max ? _mm256_max_ps(sum, v) : _mm256_fmadd_ps(_mm256_loadu_ps(weight + k * width + j), v, sum);
+        }
+        _mm256_storeu_ps(row + j, sum);
+    }
+    return j;
+}
+
+__attribute__((target("avx2,fma"))) static unsigned DownAvx2(float const* row, float w, unsigned width, bool max,
+                                                             float* sums)
+{
+    auto const weight = _mm256_set1_ps(w);
+    unsigned j = 0;
+    for (; j + 8 <= width; j += 8)
+    {
+        auto const v = _mm256_loadu_ps(row + j);
+        auto const sum = _mm256_loadu_ps(sums + j);
+        _mm256_storeu_ps(sums + j, max ? _mm256_max_ps(sum, v) : _mm256_fmadd_ps(weight, v, sum));
+    }
+    return j;
+}
+
+#endif
+
+// Scalar loops use std::fma in the same order as the AVX2 ones, so both give the
+// same bytes.
+void Downsampler::Run(FrameBuffer const& pixels, uint8_t* out, [[maybe_unused]] bool simd) const
+{
+    bool const max = mode == DownsampleMode::Max;
+    alignas(32) float line[FrameWidth];
+    alignas(32) float rows[2][FrameWidth];
+    alignas(32) float sums[FrameWidth];
+
+    // Neighbouring outputs share the line on their edge, last tap of one and first
+    // of the next, so the last line done is kept round
+    float* last = rows[0];
+    float* spare = rows[1];
+    int32_t lastLine = -1;
+
+    for (unsigned i = 0; i < height; i++)
+    {
+        std::fill_n(sums, width, 0.0f);
+        for (unsigned k = 0; k < down.count; k++)
+        {
+            int32_t const y = down.index[size_t { k } * height + i];
+            float const w = down.weight[size_t { k } * height + i];
+            if (w == 0.0f)
+                continue;
+
+            if (y != lastLine)
+            {
+                Pixel const* source = pixels.data() + size_t { FrameWidth } * static_cast<unsigned>(y);
+                unsigned j = 0;
+#if NES_AVX2
+                if (simd && HasAvx2Fma())
+                {
+                    LumaLineAvx2(source, luma.data(), line);
+                    j = AcrossAvx2(line, across.index.data(), across.weight.data(), across.count, width, max, spare);
+                }
+                else
+#endif
+                    LumaLine(source, luma.data(), line);
+
+                for (; j < width; j++)
+                {
+                    float sum = 0.0f;
+                    for (unsigned t = 0; t < across.count; t++)
+                    {
+                        float const v = line[across.index[size_t { t } * width + j]];
+                        sum = max ? std::max(sum, v) : std::fma(across.weight[size_t { t } * width + j], v, sum);
+                    }
+                    spare[j] = sum;
+                }
+
+                std::swap(last, spare);
+                lastLine = y;
+            }
+
+            unsigned j = 0;
+#if NES_AVX2
+            if (simd && HasAvx2Fma())
+                j = DownAvx2(last, w, width, max, sums);
+#endif
+            for (; j < width; j++)
+                sums[j] = max ? std::max(sums[j], last[j]) : std::fma(w, last[j], sums[j]);
+        }
+
+        uint8_t* row = out + size_t { width } * i;
+        for (unsigned j = 0; j < width; j++)
+            row[j] = static_cast<uint8_t>(std::min(sums[j] + 0.5f, 255.0f));
+    }
+}
+
+void Downsampler::Apply(FrameBuffer const& pixels, uint8_t* out) const
+{
+    Run(pixels, out, true);
+}
+
+void Downsampler::ApplyScalar(FrameBuffer const& pixels, uint8_t* out) const
+{
+    Run(pixels, out, false);
+}
+
+void Downsampler::ApplyBatch(std::span<FrameBuffer const* const> frames, uint8_t* out, JobScheduler* scheduler) const
+{
+    // Bands of whole frames, one frame is too little work to split
+    ParallelFor(scheduler, static_cast<unsigned>(frames.size()), [&](unsigned, unsigned first, unsigned last) {
+        for (unsigned i = first; i < last; i++)
+            Run(*frames[i], out + Bytes() * i, true);
+    });
+}
+
+} // nes
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "frame.h"
+#include "palette.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace nes
+{
+
+class JobScheduler;
+
+enum class DownsampleMode
+{
+    Area, // Average over each output pixel's box, edge pixels weighted by how much of them is inside
+    Max,  // Brightest pixel that touches the box at all, so single pixel bullets don't vanish
+};
+
+struct DownsampleOptions
+{
+    unsigned width = 84;  // Up to FrameWidth, it only ever shrinks
+    unsigned height = 84; // Up to what's left after cropping
+    unsigned cropTop = 0; // Lines dropped before scaling, 8 top and bottom is the usual NTSC overscan
+    unsigned cropBottom = 0;
+    DownsampleMode mode = DownsampleMode::Area;
+};
+
+// Small grayscale observations straight from palette indices, for agents that want
+// 84x84 and not 256x240 RGBA. Each pixel goes to its luma through a 512 entry table
+// on the way in, so there's never a full size RGB frame, and the scaling is two
+// passes of fixed taps, across then down.
+//
+// Apply is const and keeps its working space on the stack, so any number of threads
+// can share one Downsampler.
+class Downsampler
+{
+public:
+    explicit Downsampler(DownsampleOptions const& options = {}, Palette const& palette = Palette::Default());
+
+    unsigned Width() const { return width; }
+    unsigned Height() const { return height; }
+    size_t Bytes() const { return size_t { width } * height; }
+
+    // Width() x Height() bytes, rows packed.
+    void Apply(FrameBuffer const& pixels, uint8_t* out) const;
+
+    // Just the plain loops. They round the same way, so the tests hold Apply's
+    // bytes to these.
+    void ApplyScalar(FrameBuffer const& pixels, uint8_t* out) const;
+
+    // One observation per frame, back to back in out like a batch of tensors, so all
+    // the instances in a process can go in one call. With a scheduler the frames are
+    // shared out over its workers; don't pass one from one of its workers.
+    void ApplyBatch(std::span<FrameBuffer const* const> frames, uint8_t* out, JobScheduler* scheduler = nullptr) const;
+
+private:
+    // Taps are stored tap major, tap k of every output column together, so SIMD can
+    // load 8 columns' worth at once. Columns with fewer taps than the most any has
+    // repeat their last pixel with no weight, which is harmless to both modes.
+    struct Taps
+    {
+        unsigned count = 0; // Per output
+        std::vector<int32_t> index;
+        std::vector<float> weight;
+    };
+
+    static Taps MakeTaps(unsigned inputs, unsigned outputs, unsigned offset);
+    void Run(FrameBuffer const& pixels, uint8_t* out, bool simd) const;
+
+    unsigned width;
+    unsigned height;
+    DownsampleMode mode;
+    Taps across;
+    Taps down;
+    std::vector<float> luma; // By Pixel, 0-255
+};
+
+} // nes
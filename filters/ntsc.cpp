@@ -0,0 +1,242 @@
+#include "ntsc.h"
+#include "scheduler.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+namespace nes
+{
+
+// Signal levels in volts, from the nesdev wiki's NTSC video page. Four luma levels,
+// each with the low and high half of the colour square wave.
+static constexpr float LowLevels[4] = { 0.350f, 0.518f, 0.962f, 1.550f };
+static constexpr float HighLevels[4] = { 1.094f, 1.506f, 1.962f, 1.962f };
+static constexpr float Black = 0.518f;
+static constexpr float White = 1.962f;
+static constexpr float Attenuation = 0.746f; // What an emphasis bit does to the signal while it's active
+
+static constexpr unsigned SubcarrierSamples = 12;
+static constexpr unsigned LumaWindow = 12; // One whole subcarrier cycle, so the colour cancels out of luma
+static constexpr unsigned ChromaWindow = 24;
+
+// Hue of colour n is the 6 samples starting at phase 12 - n being high. Lines the
+// decoded colours up with the usual palette, worked out by fitting against it.
+static constexpr float HueOffset = 4.0f;
+
+// YIQ to RGB, FCC
+static constexpr float IToR = 0.946882f, QToR = 0.623557f;
+static constexpr float IToG = -0.274788f, QToG = -0.635691f;
+static constexpr float IToB = -1.108545f, QToB = 1.709007f;
+
+static bool InColorPhase(unsigned color, unsigned phase)
+{
+    return (color + phase) % SubcarrierSamples < 6;
+}
+
+// 0 is black, 1 is white
+static float Sample(Pixel pixel, unsigned phase)
+{
+    unsigned const hue = pixel & 0x0F;
+    unsigned const luma = (pixel >> 4) & 0x03;
+
+    float level;
+    if (hue >= 0x0E)
+        level = Black;
+    else if (hue == 0x00)
+        level = HighLevels[luma];
+    else if (hue == 0x0D)
+        level = LowLevels[luma];
+    else
+        level = InColorPhase(hue, phase) ? HighLevels[luma] : LowLevels[luma];
+
+    // Red, green and blue emphasis each dim the signal while it's in phase with their colour
+    unsigned const emphasis = pixel >> 6;
+    if (((emphasis & 1) && InColorPhase(0x0C, phase)) || ((emphasis & 2) && InColorPhase(0x04, phase)) ||
+        ((emphasis & 4) && InColorPhase(0x08, phase)))
+    {
+        level *= Attenuation;
+    }
+
+    return (level - Black) / (White - Black);
+}
+
+NtscFilter::NtscFilter(NtscOptions const& options) : options(options)
+{
+    if (this->options.scale != 1 && this->options.scale != 2 && this->options.scale != 4)
+        this->options.scale = 8;
+    if (BytesPerPixel(this->options.format) != 4)
+        this->options.format = PixelFormat::RGBA8888;
+
+    // A pixel is 8 samples and the subcarrier 12, so pixels only ever start on 0, 4 or 8
+    size_t const entries = 3 * PaletteSize * SamplesPerPixel;
+    signal.resize(entries);
+    signalCos.resize(entries);
+    signalSin.resize(entries);
+    for (unsigned start = 0; start < 3; start++)
+    {
+        for (unsigned pixel = 0; pixel < PaletteSize; pixel++)
+        {
+            for (unsigned i = 0; i < SamplesPerPixel; i++)
+            {
+                unsigned const phase = (start * 4 + i) % SubcarrierSamples;
+                float const value = Sample(static_cast<Pixel>(pixel), phase);
+                float const angle = std::numbers::pi_v<float> * (phase + HueOffset) / 6;
+                size_t const index = (start * PaletteSize + pixel) * SamplesPerPixel + i;
+                signal[index] = value;
+                signalCos[index] = value * std::cos(angle);
+                signalSin[index] = value * std::sin(angle);
+            }
+        }
+    }
+}
+
+void NtscFilter::BuildLine(Pixel const* row, unsigned phase, Scratch& scratch) const
+{
+    // Sized once, after that only the black before the line needs setting
+    for (auto* sums : { &scratch.luma, &scratch.inPhase, &scratch.quadrature })
+    {
+        sums->resize(LineSamples + 1);
+        std::fill_n(sums->begin(), Padding + 1, 0.0f);
+    }
+
+    float luma = 0, inPhase = 0, quadrature = 0;
+    size_t n = Padding + 1;
+    for (unsigned x = 0; x < FrameWidth; x++)
+    {
+        unsigned const start = (phase + x * SamplesPerPixel) % SubcarrierSamples / 4;
+        size_t const index = (start * PaletteSize + (row[x] & PixelMask)) * SamplesPerPixel;
+        for (unsigned i = 0; i < SamplesPerPixel; i++, n++)
+        {
+            luma += signal[index + i];
+            inPhase += signalCos[index + i];
+            quadrature += signalSin[index + i];
+            scratch.luma[n] = luma;
+            scratch.inPhase[n] = inPhase;
+            scratch.quadrature[n] = quadrature;
+        }
+    }
+
+    // Black after the line, the sums just stay where they got to
+    for (; n <= LineSamples; n++)
+    {
+        scratch.luma[n] = luma;
+        scratch.inPhase[n] = inPhase;
+        scratch.quadrature[n] = quadrature;
+    }
+}
+
+static uint32_t Pack(float r, float g, float b, bool bgra)
+{
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    uint32_t const red = channel(r), green = channel(g), blue = channel(b);
+    return 0xFF000000 | (bgra ? red << 16 | green << 8 | blue : blue << 16 | green << 8 | red);
+}
+
+#if NES_AVX2
+
+// Running sum after the window round each centre minus the one before it.
+__attribute__((target("avx2"))) static inline __m256 Window(float const* sums, __m256i centre, unsigned width)
+{
+    auto const after = _mm256_add_epi32(centre, _mm256_set1_epi32(static_cast<int>(width / 2)));
+    auto const before = _mm256_sub_epi32(centre, _mm256_set1_epi32(static_cast<int>(width / 2)));
+    return _mm256_sub_ps(_mm256_i32gather_ps(sums, after, 4), _mm256_i32gather_ps(sums, before, 4));
+}
+
+__attribute__((target("avx2,fma"))) static inline __m256i Channel(__m256 y, __m256 i, __m256 q, float iWeight,
+                                                                  float qWeight)
+{
+    auto value = _mm256_fmadd_ps(i, _mm256_set1_ps(iWeight), y);
+    value = _mm256_fmadd_ps(q, _mm256_set1_ps(qWeight), value);
+    value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_fmadd_ps(value, _mm256_set1_ps(255.0f), _mm256_set1_ps(0.5f)));
+}
+
+// 8 output pixels at a time, gathering the running sums either side of each centre.
+__attribute__((target("avx2,fma"))) static unsigned DecodeAvx2(float const* luma, float const* inPhase,
+                                                               float const* quadrature, unsigned first,
+                                                               unsigned step, unsigned count, float saturation,
+                                                               bool bgra, uint32_t* out)
+{
+    auto const offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                            _mm256_set1_epi32(static_cast<int>(step)));
+    auto const lumaScale = _mm256_set1_ps(1.0f / LumaWindow);
+    auto const chromaScale = _mm256_set1_ps(2.0f * saturation / ChromaWindow);
+    auto const alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+    unsigned j = 0;
+    for (; j + 8 <= count; j += 8)
+    {
+        auto const centre = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(first + j * step)), offsets);
+        auto const y = _mm256_mul_ps(Window(luma, centre, LumaWindow), lumaScale);
+        auto const i = _mm256_mul_ps(Window(inPhase, centre, ChromaWindow), chromaScale);
+        auto const q = _mm256_mul_ps(Window(quadrature, centre, ChromaWindow), chromaScale);
+
+        auto const r = Channel(y, i, q, IToR, QToR);
+        auto const g = Channel(y, i, q, IToG, QToG);
+        auto const b = Channel(y, i, q, IToB, QToB);
+
+        auto pixels = _mm256_or_si256(bgra ? b : r, _mm256_slli_epi32(g, 8));
+        pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(bgra ? r : b, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), _mm256_or_si256(pixels, alpha));
+    }
+    return j;
+}
+
+#endif
+
+void NtscFilter::Rows(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride, unsigned first,
+                      unsigned last, Scratch& scratch, [[maybe_unused]] bool simd) const
+{
+    unsigned const width = OutputWidth();
+    unsigned const step = SamplesPerPixel / options.scale;
+    unsigned const centre = Padding + step / 2;
+    bool const bgra = options.format == PixelFormat::BGRA8888;
+
+    for (unsigned y = first; y < last; y++)
+    {
+        // 341 dots of 8 samples a line is 4 more than a whole number of cycles
+        unsigned const phase = static_cast<unsigned>((y * 4 + (frame & 1) * 4) % SubcarrierSamples);
+        BuildLine(pixels.data() + y * FrameWidth, phase, scratch);
+
+        float const* luma = scratch.luma.data();
+        float const* inPhase = scratch.inPhase.data();
+        float const* quadrature = scratch.quadrature.data();
+        auto* row = reinterpret_cast<uint32_t*>(out + y * stride);
+        unsigned done = 0;
+
+#if NES_AVX2
+        if (simd && HasAvx2Fma())
+            done = DecodeAvx2(luma, inPhase, quadrature, centre, step, width, options.saturation, bgra, row);
+#endif
+
+        float const chromaScale = 2.0f * options.saturation / ChromaWindow;
+        for (unsigned j = done; j < width; j++)
+        {
+            unsigned const n = centre + j * step;
+            float const Y = (luma[n + LumaWindow / 2] - luma[n - LumaWindow / 2]) / LumaWindow;
+            float const I = (inPhase[n + ChromaWindow / 2] - inPhase[n - ChromaWindow / 2]) * chromaScale;
+            float const Q = (quadrature[n + ChromaWindow / 2] - quadrature[n - ChromaWindow / 2]) * chromaScale;
+            row[j] = Pack(Y + IToR * I + QToR * Q, Y + IToG * I + QToG * Q, Y + IToB * I + QToB * Q, bgra);
+        }
+    }
+}
+
+void NtscFilter::Apply(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride, JobScheduler* scheduler)
+{
+    scratch.resize(std::max<size_t>(scratch.size(), ParallelBands(scheduler, FrameHeight)));
+    ParallelFor(scheduler, FrameHeight, [&](unsigned band, unsigned first, unsigned last) {
+        Rows(pixels, frame, out, stride, first, last, scratch[band], true);
+    });
+}
+
+void NtscFilter::ApplyScalar(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride)
+{
+    scratch.resize(std::max<size_t>(scratch.size(), 1));
+    Rows(pixels, frame, out, stride, 0, FrameHeight, scratch[0], false);
+}
+
+} // nes
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "frame.h"
+#include "palette.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nes
+{
+
+class JobScheduler;
+
+struct NtscOptions
+{
+    unsigned scale = 2; // Output pixels per NES pixel across, 1, 2, 4 or 8. Rows stay one to one.
+    PixelFormat format = PixelFormat::RGBA8888; // 32 bit formats only
+    float saturation = 1.0f;
+};
+
+// Composite video filter. Rebuilds the signal the PPU would put on the wire from
+// each pixel's palette index and emphasis bits, 8 samples a pixel at 12 samples a
+// colour subcarrier cycle, then decodes it back to RGB with box filters the way a
+// cheap TV would. Colour bleeds between neighbours and the dot crawl pattern moves
+// from line to line and frame to frame, which is the whole point.
+//
+// Rows are independent, so with a scheduler the frame is split into bands of rows
+// and each band is a job. Sits after the emulator, it only ever sees finished frames.
+class NtscFilter
+{
+public:
+    explicit NtscFilter(NtscOptions const& options = {});
+
+    unsigned OutputWidth() const { return FrameWidth * options.scale; }
+    unsigned OutputHeight() const { return FrameHeight; }
+
+    // frame picks the phase, odd frames start 4 samples later because of the
+    // skipped dot. Don't pass a scheduler when calling from one of its workers.
+    void Apply(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride,
+               JobScheduler* scheduler = nullptr);
+
+    // Same again a sample at a time, for testing the SIMD path against.
+    void ApplyScalar(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride);
+
+private:
+    static constexpr unsigned SamplesPerPixel = 8;
+    static constexpr unsigned Padding = 16; // Black either side so the filters never run off the ends
+    static constexpr unsigned LineSamples = Padding + FrameWidth * SamplesPerPixel + Padding;
+
+    // Per band, so bands never share anything they write
+    struct Scratch
+    {
+        std::vector<float> luma;   // Running sums, the filters are differences of two
+        std::vector<float> inPhase;
+        std::vector<float> quadrature;
+    };
+
+    void Rows(FrameBuffer const& pixels, uint64_t frame, uint8_t* out, size_t stride, unsigned first, unsigned last,
+              Scratch& scratch, bool simd) const;
+    void BuildLine(Pixel const* row, unsigned phase, Scratch& scratch) const;
+
+    NtscOptions options;
+    // The 8 samples of every pixel at each of the three phases a pixel can start
+    // on, and the same times the subcarrier's cos and sin at each sample.
+    std::vector<float> signal;
+    std::vector<float> signalCos;
+    std::vector<float> signalSin;
+    std::vector<Scratch> scratch;
+};
+
+} // nes
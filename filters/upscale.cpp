@@ -0,0 +1,285 @@
+#include "upscale.h"
+#include "scheduler.h"
+#include "simd.h"
+#include <algorithm>
+#include <array>
+#include <span>
+
+namespace nes
+{
+
+Upscaler::Upscaler(UpscaleOptions const& options, Palette const& palette)
+    : options(options), lut(palette, options.format)
+{
+    this->options.scale = std::clamp(this->options.scale, 2u, 4u);
+    if (this->options.scale == 4)
+        doubled.resize(size_t { FrameWidth } * 2 * FrameHeight * 2);
+}
+
+// Neighbours are named the usual way:
+//
+//   A B C
+//   D E F
+//   G H I
+//
+// and off the edge of the picture is the edge pixel again.
+
+static void Scale2xPixels(Pixel const* above, Pixel const* row, Pixel const* below, unsigned width, unsigned first,
+                          unsigned last, Pixel* top, Pixel* bottom)
+{
+    for (unsigned x = first; x < last; x++)
+    {
+        Pixel const B = above[x], H = below[x], E = row[x];
+        Pixel const D = row[x > 0 ? x - 1 : 0];
+        Pixel const F = row[x + 1 < width ? x + 1 : x];
+        top[x * 2] = D == B && B != F && D != H ? D : E;
+        top[x * 2 + 1] = B == F && B != D && F != H ? F : E;
+        bottom[x * 2] = D == H && D != B && H != F ? D : E;
+        bottom[x * 2 + 1] = H == F && D != H && B != F ? F : E;
+    }
+}
+
+static void Scale3xPixels(Pixel const* above, Pixel const* row, Pixel const* below, unsigned width, unsigned first,
+                          unsigned last, Pixel* lines[3])
+{
+    for (unsigned x = first; x < last; x++)
+    {
+        unsigned const left = x > 0 ? x - 1 : 0;
+        unsigned const right = x + 1 < width ? x + 1 : x;
+        Pixel const A = above[left], B = above[x], C = above[right];
+        Pixel const D = row[left], E = row[x], F = row[right];
+        Pixel const G = below[left], H = below[x], I = below[right];
+
+        Pixel* out0 = lines[0] + x * 3;
+        Pixel* out1 = lines[1] + x * 3;
+        Pixel* out2 = lines[2] + x * 3;
+        std::fill_n(out0, 3, E);
+        std::fill_n(out1, 3, E);
+        std::fill_n(out2, 3, E);
+        if (B == H || D == F)
+            continue;
+
+        out0[0] = D == B ? D : E;
+        out0[1] = (D == B && E != C) || (B == F && E != A) ? B : E;
+        out0[2] = B == F ? F : E;
+        out1[0] = (D == B && E != G) || (D == H && E != A) ? D : E;
+        out1[2] = (B == F && E != I) || (H == F && E != C) ? F : E;
+        out2[0] = D == H ? D : E;
+        out2[1] = (D == H && E != I) || (H == F && E != G) ? H : E;
+        out2[2] = H == F ? F : E;
+    }
+}
+
+#if NES_AVX2
+
+__attribute__((target("avx2"))) static inline __m256i Load16(Pixel const* pixels)
+{
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels));
+}
+
+__attribute__((target("avx2"))) static inline __m256i Equal(__m256i a, __m256i b)
+{
+    return _mm256_cmpeq_epi16(a, b);
+}
+
+__attribute__((target("avx2"))) static inline void Store16(Pixel* out, __m256i pixels)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), pixels);
+}
+
+// 32 pixels, a and b taking turns.
+__attribute__((target("avx2"))) static inline void StoreInterleaved(Pixel* out, __m256i a, __m256i b)
+{
+    // Unpacks work within 128 bit halves, so the halves need putting back in order
+    auto const low = _mm256_unpacklo_epi16(a, b);
+    auto const high = _mm256_unpackhi_epi16(a, b);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_permute2x128_si256(low, high, 0x31));
+}
+
+// Everything but the first pixel and whatever's left at the end, which need the
+// edge handling. Returns where it got to.
+__attribute__((target("avx2"))) static unsigned Scale2xAvx2(Pixel const* above, Pixel const* row, Pixel const* below,
+                                                            unsigned width, Pixel* top, Pixel* bottom)
+{
+    unsigned x = 1;
+    for (; x + 17 <= width; x += 16)
+    {
+        auto const B = Load16(above + x), H = Load16(below + x);
+        auto const D = Load16(row + x - 1), E = Load16(row + x), F = Load16(row + x + 1);
+        auto const db = Equal(D, B), bf = Equal(B, F), dh = Equal(D, H), hf = Equal(H, F);
+
+        auto const e0 = _mm256_blendv_epi8(E, D, _mm256_andnot_si256(_mm256_or_si256(bf, dh), db));
+        auto const e1 = _mm256_blendv_epi8(E, F, _mm256_andnot_si256(_mm256_or_si256(db, hf), bf));
+        auto const e2 = _mm256_blendv_epi8(E, D, _mm256_andnot_si256(_mm256_or_si256(db, hf), dh));
+        auto const e3 = _mm256_blendv_epi8(E, F, _mm256_andnot_si256(_mm256_or_si256(dh, bf), hf));
+        StoreInterleaved(top + x * 2, e0, e1);
+        StoreInterleaved(bottom + x * 2, e2, e3);
+    }
+    return x;
+}
+
+// Byte shuffles for spreading three registers of 8 pixels out into 24, a b c a b c
+// and so on. Output register k takes pixel p from source s with mask [k][s].
+static constexpr std::array<std::array<std::array<int8_t, 16>, 3>, 3> MakeInterleave3()
+{
+    std::array<std::array<std::array<int8_t, 16>, 3>, 3> masks {};
+    for (unsigned k = 0; k < 3; k++)
+    {
+        for (unsigned j = 0; j < 8; j++)
+        {
+            unsigned const position = k * 8 + j;
+            for (unsigned source = 0; source < 3; source++)
+            {
+                bool const mine = position % 3 == source;
+                masks[k][source][j * 2] = mine ? static_cast<int8_t>(position / 3 * 2) : -1;
+                masks[k][source][j * 2 + 1] = mine ? static_cast<int8_t>(position / 3 * 2 + 1) : -1;
+            }
+        }
+    }
+    return masks;
+}
+
+static constexpr auto Interleave3 = MakeInterleave3();
+
+// Same shuffle in both halves
+__attribute__((target("avx2"))) static inline __m256i LoadMask(int8_t const* mask)
+{
+    return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(mask)));
+}
+
+// 48 pixels, a, b and c taking turns. Each 128 bit half does its own 8 pixels.
+__attribute__((target("avx2"))) static inline void StoreInterleaved3(Pixel* out, __m256i a, __m256i b, __m256i c)
+{
+    __m256i spread[3];
+    for (unsigned k = 0; k < 3; k++)
+    {
+        auto const& masks = Interleave3[k];
+        spread[k] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(a, LoadMask(masks[0].data())),
+                                                    _mm256_shuffle_epi8(b, LoadMask(masks[1].data()))),
+                                    _mm256_shuffle_epi8(c, LoadMask(masks[2].data())));
+    }
+
+    // Low halves are the first 24 pixels, high halves the next
+    Store16(out, _mm256_permute2x128_si256(spread[0], spread[1], 0x20));
+    Store16(out + 16, _mm256_permute2x128_si256(spread[2], spread[0], 0x30));
+    Store16(out + 32, _mm256_permute2x128_si256(spread[1], spread[2], 0x31));
+}
+
+__attribute__((target("avx2"))) static unsigned Scale3xAvx2(Pixel const* above, Pixel const* row, Pixel const* below,
+                                                            unsigned width, Pixel* lines[3])
+{
+    unsigned x = 1;
+    for (; x + 17 <= width; x += 16)
+    {
+        auto const A = Load16(above + x - 1), B = Load16(above + x), C = Load16(above + x + 1);
+        auto const D = Load16(row + x - 1), E = Load16(row + x), F = Load16(row + x + 1);
+        auto const G = Load16(below + x - 1), H = Load16(below + x), I = Load16(below + x + 1);
+
+        auto const corner = _mm256_or_si256(Equal(B, H), Equal(D, F)); // Set where nothing changes
+        auto const db = _mm256_andnot_si256(corner, Equal(D, B));
+        auto const bf = _mm256_andnot_si256(corner, Equal(B, F));
+        auto const dh = _mm256_andnot_si256(corner, Equal(D, H));
+        auto const hf = _mm256_andnot_si256(corner, Equal(H, F));
+        auto const ea = Equal(E, A), ec = Equal(E, C), eg = Equal(E, G), ei = Equal(E, I);
+
+        StoreInterleaved3(lines[0] + x * 3, _mm256_blendv_epi8(E, D, db),
+                          _mm256_blendv_epi8(E, B, _mm256_or_si256(_mm256_andnot_si256(ec, db), _mm256_andnot_si256(ea, bf))),
+                          _mm256_blendv_epi8(E, F, bf));
+        StoreInterleaved3(lines[1] + x * 3,
+                          _mm256_blendv_epi8(E, D, _mm256_or_si256(_mm256_andnot_si256(eg, db), _mm256_andnot_si256(ea, dh))),
+                          E,
+                          _mm256_blendv_epi8(E, F, _mm256_or_si256(_mm256_andnot_si256(ei, bf), _mm256_andnot_si256(ec, hf))));
+        StoreInterleaved3(lines[2] + x * 3, _mm256_blendv_epi8(E, D, dh),
+                          _mm256_blendv_epi8(E, H, _mm256_or_si256(_mm256_andnot_si256(ei, dh), _mm256_andnot_si256(eg, hf))),
+                          _mm256_blendv_epi8(E, F, hf));
+    }
+    return x;
+}
+
+#endif
+
+// Source row y of a width x height picture into factor output rows of factor * width.
+static void ScaleRow(Pixel const* source, unsigned width, unsigned height, unsigned y, unsigned factor, Pixel* lines[3],
+                     [[maybe_unused]] bool simd)
+{
+    Pixel const* row = source + size_t { y } * width;
+    Pixel const* above = y > 0 ? row - width : row;
+    Pixel const* below = y + 1 < height ? row + width : row;
+
+    if (factor == 2)
+    {
+        unsigned done = 0;
+#if NES_AVX2
+        if (simd && HasAvx2())
+        {
+            Scale2xPixels(above, row, below, width, 0, 1, lines[0], lines[1]);
+            done = Scale2xAvx2(above, row, below, width, lines[0], lines[1]);
+        }
+#endif
+        Scale2xPixels(above, row, below, width, done, width, lines[0], lines[1]);
+        return;
+    }
+
+    unsigned done = 0;
+#if NES_AVX2
+    if (simd && HasAvx2())
+    {
+        Scale3xPixels(above, row, below, width, 0, 1, lines);
+        done = Scale3xAvx2(above, row, below, width, lines);
+    }
+#endif
+    Scale3xPixels(above, row, below, width, done, width, lines);
+}
+
+void Upscaler::Run(FrameBuffer const& pixels, uint8_t* out, size_t stride, JobScheduler* scheduler, bool simd)
+{
+    Pixel const* source = pixels.data();
+    unsigned width = FrameWidth;
+    unsigned height = FrameHeight;
+    unsigned const factor = options.scale == 3 ? 3 : 2;
+
+    if (options.scale == 4)
+    {
+        ParallelFor(scheduler, FrameHeight, [&](unsigned, unsigned first, unsigned last) {
+            for (unsigned y = first; y < last; y++)
+            {
+                Pixel* lines[3] = { doubled.data() + size_t { y } * 2 * width * 2,
+                                    doubled.data() + (size_t { y } * 2 + 1) * width * 2, nullptr };
+                ScaleRow(source, width, height, y, 2, lines, simd);
+            }
+        });
+        source = doubled.data();
+        width *= 2;
+        height *= 2;
+    }
+
+    unsigned const outWidth = width * factor;
+    ParallelFor(scheduler, height, [&](unsigned, unsigned first, unsigned last) {
+        // A source row's worth of output at a time, converted while it's still in cache
+        std::array<Pixel, 3 * 3 * FrameWidth> scaled;
+        Pixel* lines[3] = { scaled.data(), scaled.data() + outWidth, scaled.data() + outWidth * 2 };
+        for (unsigned y = first; y < last; y++)
+        {
+            ScaleRow(source, width, height, y, factor, lines, simd);
+            std::span<Pixel const> const rows(scaled.data(), size_t { outWidth } * factor);
+            uint8_t* destination = out + size_t { y } * factor * stride;
+            if (simd)
+                ConvertPixels(rows, outWidth, lut, destination, stride);
+            else
+                ConvertPixelsScalar(rows, outWidth, lut, destination, stride);
+        }
+    });
+}
+
+void Upscaler::Apply(FrameBuffer const& pixels, uint8_t* out, size_t stride, JobScheduler* scheduler)
+{
+    Run(pixels, out, stride, scheduler, true);
+}
+
+void Upscaler::ApplyScalar(FrameBuffer const& pixels, uint8_t* out, size_t stride)
+{
+    Run(pixels, out, stride, nullptr, false);
+}
+
+} // nes
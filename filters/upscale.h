@@ -0,0 +1,51 @@
+#pragma once
+
+#include "frame.h"
+#include "palette.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nes
+{
+
+class JobScheduler;
+
+struct UpscaleOptions
+{
+    unsigned scale = 2; // 2, 3 or 4
+    PixelFormat format = PixelFormat::RGBA8888;
+};
+
+// Scale2x and Scale3x (AdvMAME), and Scale4x as Scale2x twice. Each pixel looks at
+// its neighbours and rounds off the corner where two of them match and the others
+// don't, which keeps pixel art sharp but takes the stairs off diagonals. Matching
+// is on palette index and emphasis rather than colour distance, exact and cheap,
+// and only the finished picture goes through the palette. AVX2 does 16 pixels a
+// go when the CPU has it.
+//
+// With a scheduler the frame is split into bands of rows with ParallelFor.
+// Don't pass one when calling from one of its workers.
+class Upscaler
+{
+public:
+    explicit Upscaler(UpscaleOptions const& options = {}, Palette const& palette = Palette::Default());
+
+    unsigned OutputWidth() const { return FrameWidth * options.scale; }
+    unsigned OutputHeight() const { return FrameHeight * options.scale; }
+
+    void Apply(FrameBuffer const& pixels, uint8_t* out, size_t stride, JobScheduler* scheduler = nullptr);
+
+    // One thread and no AVX2, palette conversion included. Apply has to give
+    // exactly this.
+    void ApplyScalar(FrameBuffer const& pixels, uint8_t* out, size_t stride);
+
+private:
+    void Run(FrameBuffer const& pixels, uint8_t* out, size_t stride, JobScheduler* scheduler, bool simd);
+
+    UpscaleOptions options;
+    PaletteLut lut;
+    std::vector<Pixel> doubled; // Scale4x's first pass
+};
+
+} // nes
@@ -0,0 +1,87 @@
+// Differential fuzzer, CPU::Step against the candidate core below.
+//
+//   NES_Fuzz [--seconds N] [--seed S] [--steps N]
+//
+// runs random images until a divergence or the time runs out. Configure with
+// -DNES_LIBFUZZER=ON (clang only) to get a libFuzzer binary instead, then run it
+// the usual way, NES_Fuzz corpus_dir.
+//
+// There's only the one core so far, so the candidate is CPU as well. That still
+// catches anything that depends on more than the registers and memory. Point
+// Candidate at a new fast path to check it.
+
+#include "differential.h"
+#include <chrono>
+#include <cstdlib>
+
+using Candidate = nes::CPU;
+using Runner = DifferentialRunner<nes::CPU, Candidate>;
+
+static void Report(Divergence const& divergence)
+{
+    printf("Diverged after %llu instructions at $%04X, opcode %02X:%s\n",
+           static_cast<unsigned long long>(divergence.instruction), divergence.pc, divergence.opcode,
+           divergence.what.c_str());
+}
+
+#if NES_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* data, size_t size)
+{
+    static Runner runner;
+    if (auto divergence = runner.Run(std::span<uint8_t const>(data, size), 64))
+    {
+        Report(*divergence);
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    double seconds = 10;
+    uint64_t seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    uint32_t steps = 1000;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc)
+            seconds = std::strtod(argv[++i], nullptr);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--steps" && i + 1 < argc)
+            steps = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else
+        {
+            printf("usage: NES_Fuzz [--seconds N] [--seed S] [--steps N]\n");
+            return 1;
+        }
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto const start = Clock::now();
+    auto const end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    // One runner, its two 64K images get reused for every seed
+    auto runner = std::make_unique<Runner>();
+    uint64_t images = 0;
+    for (; Clock::now() < end; seed++, images++)
+    {
+        if (auto divergence = runner->Run(seed, steps))
+        {
+            printf("seed %llu: ", static_cast<unsigned long long>(seed));
+            Report(*divergence);
+            return 1;
+        }
+    }
+
+    double const elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("%llu images, %llu instructions, %.1fM instructions/s, no divergence\n",
+           static_cast<unsigned long long>(images), static_cast<unsigned long long>(runner->Instructions()),
+           runner->Instructions() / elapsed / 1e6);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef NES_DIFFERENTIAL_H
+#define NES_DIFFERENTIAL_H
+
+// Runs two CPU cores side by side on the same random memory image and stops at the
+// first instruction where they disagree on registers, flags, cycles or the bus
+// accesses they made, as seen by a BusRecorder on each. The reference is CPU::Step;
+// the candidate is whatever fast path is being checked against it.
+
+#include "../src/busrecorder.h"
+#include "../src/cpu.h"
+#include "../src/flatmemory.h"
+#include "../src/hash.h"
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// What the harness needs from a core. nes::CPU fits already, anything new (special
+// cased dispatch, caching, a JIT) wants the same public members.
+template<typename Core>
+concept DifferentialCore = std::constructible_from<Core, nes::Memory*> && requires(Core core)
+{
+    core.pc;
+    core.a;
+    core.x;
+    core.y;
+    core.s;
+    core.sp;
+    { core.Step() } -> std::convertible_to<uint8_t>;
+};
+
+struct Divergence
+{
+    uint64_t instruction; // How many ran fine before this one
+    uint16_t pc;
+    uint8_t opcode;
+    std::string what;
+};
+
+template<DifferentialCore Reference, DifferentialCore Candidate>
+class DifferentialRunner
+{
+public:
+    DifferentialRunner()
+        : referenceMemory(std::make_unique<nes::FlatMemory>()), candidateMemory(std::make_unique<nes::FlatMemory>()),
+          referenceBus(*referenceMemory), candidateBus(*candidateMemory), reference(&referenceBus), candidate(&candidateBus)
+    {
+        // Opcodes either core does, so random programs aren't mostly unimplemented ones
+        for (unsigned opcode = 0; opcode < 256; opcode++)
+        {
+            if (nes::CPU::Info(static_cast<uint8_t>(opcode)).instruction)
+                implemented.push_back(static_cast<uint8_t>(opcode));
+        }
+    }
+
+    // Random image and registers from seed, then up to steps instructions.
+    std::optional<Divergence> Run(uint64_t seed, uint32_t steps)
+    {
+        Fill(seed);
+        return Compare(steps);
+    }
+
+    // For libFuzzer. The first 7 bytes are registers, the rest is the program, put
+    // at pc over a random image seeded from the whole input.
+    std::optional<Divergence> Run(std::span<uint8_t const> input, uint32_t steps)
+    {
+        Fill(nes::Hash64(input));
+
+        uint8_t registers[7] = { 0 };
+        std::memcpy(registers, input.data(), std::min(input.size(), sizeof(registers)));
+        uint16_t const pc = static_cast<uint16_t>(registers[0] | registers[1] << 8);
+        SetRegisters(pc, registers[2], registers[3], registers[4], registers[5], registers[6]);
+
+        for (size_t i = sizeof(registers); i < input.size(); i++)
+            referenceMemory->data[static_cast<uint16_t>(pc + i - sizeof(registers))] = input[i];
+        std::memcpy(candidateMemory->data, referenceMemory->data, sizeof(referenceMemory->data));
+
+        return Compare(steps);
+    }
+
+    uint64_t Instructions() const { return instructions; }
+
+    Candidate& CandidateCore() { return candidate; }
+
+private:
+    static uint64_t Next(uint64_t& state)
+    {
+        // xorshift64*
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+    }
+
+    void Fill(uint64_t seed)
+    {
+        uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+        auto& data = referenceMemory->data;
+
+        // Half the bytes are opcodes we do, the rest anything at all. Code and data are
+        // the same memory so there's no telling which a byte will end up as.
+        for (size_t i = 0; i < sizeof(data); i += 8)
+        {
+            uint64_t bits = Next(state);
+            uint64_t const picks = Next(state);
+            for (size_t b = 0; b < 8; b++, bits >>= 8)
+            {
+                bool const opcode = (picks >> b) & 1;
+                data[i + b] = opcode && !implemented.empty() ? implemented[(picks >> (8 + b * 7)) % implemented.size()]
+                                                             : static_cast<uint8_t>(bits);
+            }
+        }
+        std::memcpy(candidateMemory->data, data, sizeof(data));
+
+        uint64_t const registers = Next(state);
+        SetRegisters(static_cast<uint16_t>(registers), static_cast<uint8_t>(registers >> 16),
+                     static_cast<uint8_t>(registers >> 24), static_cast<uint8_t>(registers >> 32),
+                     static_cast<uint8_t>(registers >> 40), static_cast<uint8_t>(registers >> 48));
+    }
+
+    void SetRegisters(uint16_t pc, uint8_t a, uint8_t x, uint8_t y, uint8_t s, uint8_t sp)
+    {
+        reference.pc = candidate.pc = pc;
+        reference.a = candidate.a = a;
+        reference.x = candidate.x = x;
+        reference.y = candidate.y = y;
+        reference.s = candidate.s = s;
+        reference.sp = candidate.sp = sp;
+    }
+
+    std::optional<Divergence> Compare(uint32_t steps)
+    {
+        for (uint32_t i = 0; i < steps; i++)
+        {
+            uint16_t const pc = reference.pc;
+            uint8_t const opcode = referenceMemory->data[pc];
+
+            referenceBus.Clear();
+            candidateBus.Clear();
+            unsigned const referenceCycles = reference.Step();
+            unsigned const candidateCycles = candidate.Step();
+
+            std::string what;
+            Check(what, "pc", reference.pc, candidate.pc);
+            Check(what, "a", reference.a, candidate.a);
+            Check(what, "x", reference.x, candidate.x);
+            Check(what, "y", reference.y, candidate.y);
+            Check(what, "p", reference.s, candidate.s);
+            Check(what, "sp", reference.sp, candidate.sp);
+            Check(what, "cycles", referenceCycles, candidateCycles);
+            if (referenceBus.Compare(candidateBus.Events()))
+                what += " bus " + Describe(referenceBus.Events()) + "vs " + Describe(candidateBus.Events());
+
+            if (!what.empty())
+                return Divergence { instructions, pc, opcode, what };
+
+            instructions++;
+        }
+
+        return std::nullopt;
+    }
+
+    static void Check(std::string& what, char const* name, unsigned expected, unsigned got)
+    {
+        if (expected == got)
+            return;
+
+        char text[48];
+        snprintf(text, sizeof(text), " %s %02X vs %02X", name, expected, got);
+        what += text;
+    }
+
+    static std::string Describe(std::span<nes::BusEvent const> accesses)
+    {
+        static char const Kinds[] = { 'r', 'w', 'f' };
+        std::string text;
+        for (auto const& access : accesses)
+        {
+            char entry[24];
+            snprintf(entry, sizeof(entry), "%c%04X=%02X ", Kinds[static_cast<int>(access.kind)], access.address, access.value);
+            text += entry;
+        }
+        return text;
+    }
+
+    std::unique_ptr<nes::FlatMemory> referenceMemory;
+    std::unique_ptr<nes::FlatMemory> candidateMemory;
+    nes::BusRecorder referenceBus;
+    nes::BusRecorder candidateBus;
+    Reference reference;
+    Candidate candidate;
+    std::vector<uint8_t> implemented;
+    uint64_t instructions = 0;
+};
+
+#endif //NES_DIFFERENTIAL_H
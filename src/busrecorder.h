@@ -0,0 +1,110 @@
+#pragma once
+
+#include "memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace nes
+{
+
+enum class BusKind : uint8_t
+{
+    Read,
+    Write,
+    Fetch, // Opcode fetch, a read as far as the bus is concerned
+};
+
+struct BusEvent
+{
+    uint64_t cycle;
+    uint16_t address;
+    uint8_t value;
+    BusKind kind;
+
+    // Fetches and reads look the same on the wire
+    bool Matches(BusEvent const& other) const
+    {
+        auto const wire = [](BusKind kind) { return kind == BusKind::Write ? BusKind::Write : BusKind::Read; };
+        return cycle == other.cycle && address == other.address && value == other.value && wire(kind) == wire(other.kind);
+    }
+};
+
+// Sits between the CPU and its real bus and writes down every access in order.
+// A 6502 does exactly one access a cycle, so the cycle is just the count of
+// accesses since Clear(). The buffer is allocated up front, when it's full further
+// accesses still go through but only get counted in Dropped().
+class BusRecorder : public Memory
+{
+public:
+    explicit BusRecorder(Memory& bus, size_t capacity = 64) : bus(bus), events(capacity) {}
+
+    uint8_t Read(uint16_t address) override
+    {
+        auto const value = bus.Read(address);
+        Record(address, value, BusKind::Read);
+        return value;
+    }
+
+    uint8_t Fetch(uint16_t address) override
+    {
+        auto const value = bus.Fetch(address);
+        Record(address, value, BusKind::Fetch);
+        return value;
+    }
+
+    void Write(uint16_t address, uint8_t value) override
+    {
+        bus.Write(address, value);
+        Record(address, value, BusKind::Write);
+    }
+
+    // Not on the wire, so not recorded
+    uint8_t Peek(uint16_t address) override { return bus.Peek(address); }
+
+    void Clear()
+    {
+        count = 0;
+        cycle = 0;
+        dropped = 0;
+    }
+
+    std::span<BusEvent const> Events() const { return { events.data(), count }; }
+    uint64_t Dropped() const { return dropped; }
+
+    // Index of the first access that isn't what expected says, including one side
+    // running out before the other. Nothing if they match.
+    std::optional<size_t> Compare(std::span<BusEvent const> expected) const
+    {
+        auto const recorded = Events();
+        for (size_t i = 0; i < recorded.size() && i < expected.size(); i++)
+        {
+            if (!recorded[i].Matches(expected[i]))
+                return i;
+        }
+
+        if (recorded.size() != expected.size() || dropped > 0)
+            return std::min(recorded.size(), expected.size());
+        return std::nullopt;
+    }
+
+private:
+    void Record(uint16_t address, uint8_t value, BusKind kind)
+    {
+        if (count < events.size())
+            events[count++] = { cycle, address, value, kind };
+        else
+            dropped++;
+        cycle++;
+    }
+
+    Memory& bus;
+    std::vector<BusEvent> events;
+    size_t count = 0;
+    uint64_t cycle = 0;
+    uint64_t dropped = 0;
+};
+
+} // nes
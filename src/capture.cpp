@@ -0,0 +1,324 @@
+#include "capture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#define NES_WRITEV 1
+#endif
+
+namespace nes
+{
+
+std::unique_ptr<StreamWriter> StreamWriter::Open(std::string const& path, size_t depth)
+{
+    std::FILE* file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+    if (!file)
+        return nullptr;
+    return std::make_unique<StreamWriter>(file, depth);
+}
+
+StreamWriter::StreamWriter(std::FILE* file, size_t depth) : file(file)
+{
+    free.resize(std::max<size_t>(depth, 1));
+    thread = std::thread([this] { Run(); });
+}
+
+StreamWriter::~StreamWriter()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    queuedChanged.notify_one();
+    thread.join();
+
+    if (file == stdout)
+        std::fflush(file);
+    else
+        std::fclose(file);
+}
+
+std::vector<uint8_t> StreamWriter::Acquire()
+{
+    std::unique_lock lock(mutex);
+    if (free.empty())
+    {
+        stalls++;
+        freeChanged.wait(lock, [this] { return !free.empty(); });
+    }
+
+    auto buffer = std::move(free.back());
+    free.pop_back();
+    buffer.clear();
+    return buffer;
+}
+
+void StreamWriter::Submit(std::vector<uint8_t> buffer, Encoder encoder)
+{
+    {
+        std::lock_guard lock(mutex);
+        queued.push_back({ std::move(buffer), std::move(encoder) });
+    }
+    queuedChanged.notify_one();
+}
+
+void StreamWriter::Flush()
+{
+    std::unique_lock lock(mutex);
+    freeChanged.wait(lock, [this] { return queued.empty() && writing == 0; });
+}
+
+bool StreamWriter::WriteAt(uint64_t offset, std::span<uint8_t const> bytes)
+{
+    std::lock_guard lock(mutex);
+#if NES_WRITEV
+    // Fails with ESPIPE on a pipe, which is the answer we want anyway
+    auto const written = ::pwrite(fileno(file), bytes.data(), bytes.size(), static_cast<off_t>(offset));
+    return written == static_cast<ssize_t>(bytes.size());
+#else
+    if (file == stdout || std::fflush(file) != 0)
+        return false;
+
+    auto const end = std::ftell(file);
+    bool const ok = end >= 0 && std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0 &&
+                    std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    std::fflush(file);
+    std::fseek(file, end, SEEK_SET);
+    return ok;
+#endif
+}
+
+bool StreamWriter::Failed() const
+{
+    std::lock_guard lock(mutex);
+    return failed;
+}
+
+uint64_t StreamWriter::BytesWritten() const
+{
+    std::lock_guard lock(mutex);
+    return bytesWritten;
+}
+
+uint64_t StreamWriter::Stalls() const
+{
+    std::lock_guard lock(mutex);
+    return stalls;
+}
+
+void StreamWriter::Run()
+{
+    std::vector<Queued> batch;
+    std::vector<std::vector<uint8_t>*> outgoing;
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        queuedChanged.wait(lock, [this] { return stopping || !queued.empty(); });
+        if (queued.empty())
+            break; // Stopping, and everything's out
+
+        while (!queued.empty())
+        {
+            batch.push_back(std::move(queued.front()));
+            queued.pop_front();
+        }
+        writing = batch.size();
+
+        lock.unlock();
+        if (encoded.size() < batch.size())
+            encoded.resize(batch.size());
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            auto& entry = batch[i];
+            if (entry.encoder)
+            {
+                encoded[i].clear();
+                entry.encoder(entry.buffer, encoded[i]);
+            }
+            outgoing.push_back(entry.encoder ? &encoded[i] : &entry.buffer);
+        }
+        bool const ok = WriteAll(outgoing);
+        lock.lock();
+
+        failed |= !ok;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (ok)
+                bytesWritten += outgoing[i]->size();
+            free.push_back(std::move(batch[i].buffer));
+        }
+        batch.clear();
+        outgoing.clear();
+        writing = 0;
+        freeChanged.notify_all();
+    }
+}
+
+bool StreamWriter::WriteAll(std::vector<std::vector<uint8_t>*>& buffers)
+{
+#if NES_WRITEV
+    // Whatever stdio has buffered goes first, then straight to the descriptor
+    std::fflush(file);
+    int const fd = fileno(file);
+
+    std::vector<iovec> vectors;
+    for (auto* buffer : buffers)
+    {
+        if (!buffer->empty())
+            vectors.push_back({ buffer->data(), buffer->size() });
+    }
+
+    size_t next = 0;
+    while (next < vectors.size())
+    {
+        int const count = static_cast<int>(std::min<size_t>(vectors.size() - next, IOV_MAX));
+        ssize_t written = ::writev(fd, vectors.data() + next, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue; // A signal before anything went, just go again
+            return false;
+        }
+
+        // Short writes happen on pipes, carry on from wherever it got to
+        while (next < vectors.size() && static_cast<size_t>(written) >= vectors[next].iov_len)
+            written -= static_cast<ssize_t>(vectors[next++].iov_len);
+        if (next < vectors.size())
+        {
+            vectors[next].iov_base = static_cast<uint8_t*>(vectors[next].iov_base) + written;
+            vectors[next].iov_len -= static_cast<size_t>(written);
+        }
+    }
+    return true;
+#else
+    for (auto const* buffer : buffers)
+    {
+        if (std::fwrite(buffer->data(), 1, buffer->size(), file) != buffer->size())
+            return false;
+    }
+    return std::fflush(file) == 0;
+#endif
+}
+
+Y4mWriter::Y4mWriter(StreamWriter& out, Palette const& palette) : out(out)
+{
+    // BT.601, studio range, which is what Y4M means unless it says otherwise
+    for (size_t i = 0; i < PaletteSize; i++)
+    {
+        double const r = (palette.colors[i] >> 16) & 0xFF;
+        double const g = (palette.colors[i] >> 8) & 0xFF;
+        double const b = palette.colors[i] & 0xFF;
+        y[i] = static_cast<uint8_t>(std::lround(16 + (65.481 * r + 128.553 * g + 24.966 * b) / 255));
+        u[i] = static_cast<uint8_t>(std::lround(128 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255));
+        v[i] = static_cast<uint8_t>(std::lround(128 + (112.0 * r - 93.786 * g - 18.214 * b) / 255));
+    }
+}
+
+Y4mWriter::~Y4mWriter()
+{
+    out.Flush();
+}
+
+void Y4mWriter::WriteFrame(FrameBuffer const& pixels)
+{
+    // 2 bytes a pixel to copy instead of 3 to look up
+    auto buffer = out.Acquire();
+    auto const bytes = reinterpret_cast<uint8_t const*>(pixels.data());
+    buffer.assign(bytes, bytes + sizeof(FrameBuffer));
+    out.Submit(std::move(buffer), [this](std::span<uint8_t const> in, std::vector<uint8_t>& encoded) { Encode(in, encoded); });
+}
+
+void Y4mWriter::Encode(std::span<uint8_t const> in, std::vector<uint8_t>& encoded)
+{
+    static char const Header[] = "YUV4MPEG2 W256 H240 F39375000:655171 Ip A1:1 C444\n";
+    static char const Frame[] = "FRAME\n";
+
+    if (!wroteHeader)
+    {
+        encoded.insert(encoded.end(), Header, Header + sizeof(Header) - 1);
+        wroteHeader = true;
+    }
+    encoded.insert(encoded.end(), Frame, Frame + sizeof(Frame) - 1);
+
+    size_t const count = in.size() / sizeof(Pixel);
+    size_t const start = encoded.size();
+    encoded.resize(start + count * 3);
+    uint8_t* planeY = encoded.data() + start;
+    uint8_t* planeU = planeY + count;
+    uint8_t* planeV = planeU + count;
+    for (size_t i = 0; i < count; i++)
+    {
+        Pixel pixel;
+        std::memcpy(&pixel, in.data() + i * sizeof(Pixel), sizeof(Pixel));
+        pixel &= PixelMask;
+        planeY[i] = y[pixel];
+        planeU[i] = u[pixel];
+        planeV[i] = v[pixel];
+    }
+}
+
+static void Put16(std::vector<uint8_t>& buffer, uint16_t value)
+{
+    buffer.push_back(static_cast<uint8_t>(value));
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void Put32(std::vector<uint8_t>& buffer, uint32_t value)
+{
+    Put16(buffer, static_cast<uint16_t>(value));
+    Put16(buffer, static_cast<uint16_t>(value >> 16));
+}
+
+WavWriter::WavWriter(StreamWriter& out, uint32_t sampleRate) : out(out), sampleRate(sampleRate)
+{
+}
+
+void WavWriter::WriteSamples(std::span<int16_t const> samples)
+{
+    auto buffer = out.Acquire();
+    if (!wroteHeader)
+    {
+        buffer.insert(buffer.end(), { 'R', 'I', 'F', 'F' });
+        Put32(buffer, 0xFFFFFFFF);
+        buffer.insert(buffer.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+        Put32(buffer, 16);
+        Put16(buffer, 1); // PCM
+        Put16(buffer, 1); // Mono
+        Put32(buffer, sampleRate);
+        Put32(buffer, sampleRate * 2);
+        Put16(buffer, 2);
+        Put16(buffer, 16);
+        buffer.insert(buffer.end(), { 'd', 'a', 't', 'a' });
+        Put32(buffer, 0xFFFFFFFF);
+        wroteHeader = true;
+    }
+
+    for (auto sample : samples)
+        Put16(buffer, static_cast<uint16_t>(sample));
+    dataBytes += samples.size() * 2;
+
+    out.Submit(std::move(buffer));
+}
+
+void WavWriter::Finish()
+{
+    if (!wroteHeader)
+        WriteSamples({});
+    out.Flush();
+
+    if (dataBytes + 36 > 0xFFFFFFFF)
+        return; // Too big to say, leave it streaming style
+
+    std::vector<uint8_t> riffSize, dataSize;
+    Put32(riffSize, static_cast<uint32_t>(36 + dataBytes));
+    Put32(dataSize, static_cast<uint32_t>(dataBytes));
+    out.WriteAt(4, riffSize);
+    out.WriteAt(40, dataSize);
+}
+
+} // nes
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "frame.h"
+#include "palette.h"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+
+// Streams buffers to a file or pipe from a background thread. There are only ever
+// depth buffers, handed out by Acquire and recycled once written, so a slow disk or
+// a slow reader on the other end of the pipe holds up Acquire rather than piling
+// frames up in memory. Whatever's queued when the writer thread wakes goes out in
+// one writev.
+class StreamWriter
+{
+public:
+    // Turns a submitted buffer into the bytes that get written, on the writer
+    // thread, so conversions don't hold up whoever's submitting. Appends to out,
+    // which starts empty and keeps its capacity from last time.
+    using Encoder = std::function<void(std::span<uint8_t const> in, std::vector<uint8_t>& out)>;
+
+    // Takes the file. "-" is stdout.
+    static std::unique_ptr<StreamWriter> Open(std::string const& path, size_t depth = 8);
+
+    StreamWriter(std::FILE* file, size_t depth = 8);
+    ~StreamWriter();
+    StreamWriter(StreamWriter const&) = delete;
+    StreamWriter& operator=(StreamWriter const&) = delete;
+
+    // An empty buffer, with whatever capacity it had last time round.
+    std::vector<uint8_t> Acquire();
+    void Submit(std::vector<uint8_t> buffer, Encoder encoder = {});
+
+    // Waits for everything submitted to be written.
+    void Flush();
+
+    // Overwrites bytes already written, after a Flush. False on pipes.
+    bool WriteAt(uint64_t offset, std::span<uint8_t const> bytes);
+
+    bool Failed() const;
+    uint64_t BytesWritten() const;
+    uint64_t Stalls() const; // Times Acquire had to wait for the writer
+
+private:
+    struct Queued
+    {
+        std::vector<uint8_t> buffer;
+        Encoder encoder;
+    };
+
+    void Run();
+    bool WriteAll(std::vector<std::vector<uint8_t>*>& buffers);
+
+    std::FILE* file;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable queuedChanged;
+    std::condition_variable freeChanged;
+    std::deque<Queued> queued;
+    std::vector<std::vector<uint8_t>> free;
+    std::vector<std::vector<uint8_t>> encoded; // Writer thread only
+    size_t writing = 0;
+    bool stopping = false;
+    bool failed = false;
+    uint64_t bytesWritten = 0;
+    uint64_t stalls = 0;
+};
+
+// YUV4MPEG2, what ffmpeg, mpv and friends read straight off a pipe. 4:4:4 so the
+// pixels stay sharp, at the NTSC frame rate. WriteFrame only copies the palette
+// indices, the YUV lookups happen on the writer thread.
+class Y4mWriter
+{
+public:
+    explicit Y4mWriter(StreamWriter& out, Palette const& palette = Palette::Default());
+    ~Y4mWriter(); // Waits for the writer thread to finish with it
+    Y4mWriter(Y4mWriter const&) = delete;
+    Y4mWriter& operator=(Y4mWriter const&) = delete;
+
+    void WriteFrame(FrameBuffer const& pixels);
+
+private:
+    void Encode(std::span<uint8_t const> in, std::vector<uint8_t>& encoded);
+
+    StreamWriter& out;
+    bool wroteHeader = false; // Writer thread only
+    std::array<uint8_t, PaletteSize> y;
+    std::array<uint8_t, PaletteSize> u;
+    std::array<uint8_t, PaletteSize> v;
+};
+
+// 16 bit mono PCM. The sizes in the header aren't known until the end, so they're
+// left at the maximum, which everything reading from a pipe expects, and filled in
+// by Finish if the output is a file.
+class WavWriter
+{
+public:
+    explicit WavWriter(StreamWriter& out, uint32_t sampleRate = 44100);
+
+    void WriteSamples(std::span<int16_t const> samples);
+    void Finish();
+
+    uint32_t SampleRate() const { return sampleRate; }
+
+private:
+    StreamWriter& out;
+    uint32_t sampleRate;
+    uint64_t dataBytes = 0;
+    bool wroteHeader = false;
+};
+
+} // nes
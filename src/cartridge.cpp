@@ -0,0 +1,61 @@
+#include "cartridge.h"
+#include "hash.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace nes
+{
+
+std::optional<Cartridge> Cartridge::Parse(std::span<uint8_t const> bytes)
+{
+    Cartridge cartridge = {};
+    if (bytes.size() < sizeof(Header))
+        return std::nullopt;
+
+    std::memcpy(&cartridge.header, bytes.data(), sizeof(Header));
+    if (std::memcmp(cartridge.header.Magic, "NES\x1A", 4) != 0)
+        return std::nullopt;
+
+    size_t offset = sizeof(Header);
+    if (cartridge.header.Flags6 & 0x04)
+        offset += TrainerSize;
+
+    size_t const romSize = cartridge.header.ProgRomCount * ProgRomBankSize;
+    size_t const vromSize = cartridge.header.ChrRomCount * ChrRomBankSize;
+    if (romSize == 0 || bytes.size() < offset + romSize + vromSize)
+        return std::nullopt;
+
+    auto const rom = bytes.subspan(offset, romSize);
+    auto const vrom = bytes.subspan(offset + romSize, vromSize);
+    cartridge.prgRom.assign(rom.begin(), rom.end());
+    cartridge.chrRom.assign(vrom.begin(), vrom.end());
+
+    return cartridge;
+}
+
+char const* Cartridge::Unsupported() const
+{
+    if (Mapper() != 0)
+        return "only mapper 0 (NROM) is supported";
+    if (prgRom.size() != ProgRomBankSize && prgRom.size() != 2 * ProgRomBankSize)
+        return "NROM needs 16K or 32K of PRG ROM";
+    return nullptr;
+}
+
+uint64_t Cartridge::Hash() const
+{
+    return Hash64(prgRom, Hash64(chrRom));
+}
+
+std::optional<Cartridge> Cartridge::Load(std::string const& filename)
+{
+    auto fileStream = std::ifstream(filename, std::ifstream::binary);
+    if (!fileStream)
+        return std::nullopt;
+
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+    return Parse(bytes);
+}
+
+} // nes
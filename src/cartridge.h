@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace nes
+{
+
+// iNES header https://wiki.nesdev.com/w/index.php/INES
+struct Header
+{
+    char Magic[4];
+    uint8_t ProgRomCount;
+    uint8_t ChrRomCount;
+    uint8_t Flags6;
+    uint8_t Flags7;
+    uint8_t Flags8;
+    uint8_t Flags9;
+    uint8_t Flags10;
+    uint8_t Padding[5];
+};
+
+static_assert(sizeof(Header) == 16, "Header should be 16 bytes!");
+constexpr size_t ProgRomBankSize = 16 * 1024;
+constexpr size_t ChrRomBankSize = 8 * 1024;
+constexpr size_t TrainerSize = 512;
+
+struct Cartridge
+{
+    Header header;
+    std::vector<uint8_t> prgRom;
+    std::vector<uint8_t> chrRom;
+
+    uint8_t Mapper() const { return (header.Flags7 & 0xF0) | (header.Flags6 >> 4); }
+
+    // Why the console can't run it, or null if it can. Only NROM so far, mapper 0
+    // with 16K or 32K of PRG, anything else would run from the wrong banks.
+    char const* Unsupported() const;
+
+    // Identifies the ROM contents, ignoring whatever's in the header.
+    uint64_t Hash() const;
+
+    // Both return nothing if it isn't an iNES file or it's been cut short.
+    static std::optional<Cartridge> Parse(std::span<uint8_t const> bytes);
+    static std::optional<Cartridge> Load(std::string const& filename);
+};
+
+} // nes
@@ -0,0 +1,172 @@
+#include "console.h"
+#include "hash.h"
+#include "trace.h"
+#include "zones.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace nes
+{
+
+Console::Console(std::shared_ptr<Cartridge const> cartridge)
+    : cartridge(std::move(cartridge)), ram(0x800), memory(ram), cpu(&memory), inputScript(nullptr),
+      observations(nullptr), cycles(0), instructions(0), frame(0), ppu(cycles)
+{
+    if (this->cartridge)
+    {
+        memory.SetPrgRom(this->cartridge->prgRom);
+        ppu.SetChrRom(this->cartridge->chrRom, this->cartridge->header.Flags6 & 0x01);
+    }
+    else
+    {
+        // Nothing to run, so same trick as main used to do, RAM full of NOPs.
+        std::fill(ram.begin(), ram.end(), 0xEA);
+    }
+    memory.ppu = &ppu;
+}
+
+void Console::Reset()
+{
+    cpu.Reset();
+    ppu.Reset();
+    cycles = 0;
+    instructions = 0;
+    frame = 0;
+}
+
+void Console::Save(ConsoleState& state) const
+{
+    state.pc = cpu.pc;
+    state.a = cpu.a;
+    state.x = cpu.x;
+    state.y = cpu.y;
+    state.s = cpu.s;
+    state.sp = cpu.sp;
+    state.controllers[0] = memory.controllers[0];
+    state.controllers[1] = memory.controllers[1];
+    std::memcpy(state.ram.data(), ram.data(), state.ram.size());
+    state.cycles = cycles;
+    state.instructions = instructions;
+    state.frame = frame;
+    state.ppu = ppu.state;
+}
+
+void Console::Load(ConsoleState const& state)
+{
+    cpu.pc = state.pc;
+    cpu.a = state.a;
+    cpu.x = state.x;
+    cpu.y = state.y;
+    cpu.s = state.s;
+    cpu.sp = state.sp;
+    memory.controllers[0] = state.controllers[0];
+    memory.controllers[1] = state.controllers[1];
+    std::memcpy(ram.data(), state.ram.data(), state.ram.size());
+    cycles = state.cycles;
+    instructions = state.instructions;
+    frame = state.frame;
+    ppu.state = state.ppu;
+}
+
+uint64_t Console::Hash(uint64_t seed) const
+{
+    uint8_t const registers[] = {
+        static_cast<uint8_t>(cpu.pc), static_cast<uint8_t>(cpu.pc >> 8),
+        cpu.a, cpu.x, cpu.y, cpu.s, cpu.sp,
+    };
+
+    std::span<uint8_t const> const ppuState(reinterpret_cast<uint8_t const*>(&ppu.state), sizeof(ppu.state));
+    return Hash64(ppuState, Hash64(ram, Hash64(registers, seed)));
+}
+
+// Runs whole instructions until cycles gets to until, taking NMIs and DMA stalls
+// as they come up.
+static void RunUntil(Console& console, uint64_t until)
+{
+    while (console.cycles < until)
+    {
+        // One test on the way round for both, they hardly ever happen
+        if (console.ppu.state.nmi | console.memory.stallCycles) [[unlikely]]
+        {
+            uint32_t stalled = console.memory.stallCycles;
+            console.memory.stallCycles = 0;
+            if (console.ppu.state.nmi)
+            {
+                console.ppu.state.nmi = 0;
+                stalled += console.cpu.Nmi();
+            }
+            console.cycles += stalled;
+
+#if NES_TRACER
+            // No instruction to record, but the trace's cycle count has to keep up
+            if (console.cpu.tracer)
+                console.cpu.tracer->AddCycles(stalled);
+#endif
+            continue;
+        }
+
+        console.cycles += console.cpu.Step();
+        console.instructions++;
+    }
+}
+
+void Console::RunFrame()
+{
+    uint64_t const frameStart = frame * CyclesPerFrame;
+    uint64_t const frameEnd = frameStart + CyclesPerFrame;
+
+    if (inputScript)
+    {
+        auto const pads = inputScript->At(frame);
+        memory.controllers[0].buttons = pads[0];
+        memory.controllers[1].buttons = pads[1];
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    uint64_t const startCycles = cycles;
+    uint64_t const startInstructions = instructions;
+
+    ppu.render = renderEvery != 0 && frame % renderEvery == 0;
+    ppu.BeginFrame(frameStart);
+    {
+        NES_ZONE("cpu");
+        RunUntil(*this, frameStart + VblankCycle);
+        ppu.CatchUp(); // Into vblank, which might be an NMI
+        RunUntil(*this, frameEnd);
+    }
+    {
+        NES_ZONE("ppu");
+        ppu.EndFrame();
+    }
+
+    frame++;
+
+    // cycles and instructions are machine state and go backwards when a snapshot
+    // loads, the totals only ever add what this frame did
+    auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    totals.frames++;
+    totals.cycles += cycles - startCycles;
+    totals.instructions += instructions - startInstructions;
+    totals.pageCrossings = cpu.pageCrossings;
+    totals.reads = memory.readCounts;
+    totals.writes = memory.writeCounts;
+    totals.slowAccesses = memory.slowAccesses;
+    totals.dmaStallCycles = memory.dmaStallCycles;
+#if NES_BUS_COUNTERS
+    uint64_t accesses = 0;
+    for (size_t region = 0; region < BusRegionCount; region++)
+        accesses += memory.readCounts[region] + memory.writeCounts[region];
+    totals.fastAccesses = accesses - memory.slowAccesses;
+#endif
+    totals.lastFrameNanoseconds = static_cast<uint64_t>(nanoseconds.count());
+    totals.totalFrameNanoseconds += totals.lastFrameNanoseconds;
+    counters.Publish(totals);
+
+    // Frames that weren't drawn still have the last drawn picture in ppu.frame.
+    // It has to go out again, each publish is a different slot.
+    if (observations)
+        observations->Publish(frame, ram, ppu.frame);
+}
+
+} // nes
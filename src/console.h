@@ -0,0 +1,93 @@
+#pragma once
+
+#include "cartridge.h"
+#include "counters.h"
+#include "cpu.h"
+#include "cpumemory.h"
+#include "inputscript.h"
+#include "observations.h"
+#include "ppu.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nes
+{
+
+// NTSC timing. 341 PPU dots * 262 scanlines, 3 PPU dots per CPU cycle, rounded up.
+constexpr uint32_t CyclesPerFrame = 29781;
+
+// First CPU cycle of a frame that's in vblank.
+constexpr uint32_t VblankCycle = (VblankLine * DotsPerLine + 2) / 3;
+
+// Everything that changes while a console runs, as one flat copyable block, so
+// taking or restoring a snapshot is a memcpy and never allocates.
+struct ConsoleState
+{
+    uint16_t pc;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t s;
+    uint8_t sp;
+    Controller controllers[2];
+    std::array<uint8_t, 0x800> ram;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t frame;
+    PPUState ppu;
+};
+
+// Everything one emulated machine needs. Hosts run lots of these side by side,
+// so nothing in here that changes is shared or static.
+struct Console
+{
+    std::shared_ptr<Cartridge const> cartridge; // Shared, lots of instances tend to run the same ROM
+    std::vector<uint8_t> ram;
+    CPUMemory memory;
+    CPU cpu;
+
+    // Optional. Pads get set from this at the start of every frame.
+    InputScript const* inputScript;
+
+    // Optional. Gets RAM and the picture at the end of every frame.
+    ObservationExport* observations;
+
+    // Draw every Nth frame, 0 for never. Frames that aren't drawn skip the pixels
+    // and nothing else, the CPU and RAM come out exactly the same either way.
+    uint32_t renderEvery = 1;
+
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t frame;
+
+    // Totals for monitoring, safe to read from any thread. RunFrame counts into
+    // totals and publishes them here at the end of every frame.
+    PerfCounters counters;
+    PerfCounterValues totals;
+
+    // Last, it's mostly picture, and keeping it out of the way keeps everything
+    // above in the same few cache lines.
+    PPU ppu;
+
+    explicit Console(std::shared_ptr<Cartridge const> cartridge = nullptr);
+    Console(Console const&) = delete;
+    Console& operator=(Console const&) = delete;
+
+    void Reset();
+
+    void Save(ConsoleState& state) const;
+    void Load(ConsoleState const& state);
+
+    // Hash of RAM, CPU registers and PPU state, chained onto seed. Not the picture,
+    // so it's the same whether frames are drawn or not. Feed each frame's result
+    // into the next and you get a rolling hash of the whole run.
+    uint64_t Hash(uint64_t seed = 0) const;
+
+    // Step the CPU until the next frame boundary. Instructions that straddle the
+    // boundary finish, and the overshoot is carried into the next frame.
+    void RunFrame();
+};
+
+} // nes
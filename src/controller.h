@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+namespace nes
+{
+
+// Standard pad on $4016/$4017. Writing 1 then 0 to $4016 latches the buttons,
+// then each read shifts one out, A first.
+// https://wiki.nesdev.com/w/index.php/Standard_controller
+struct Controller
+{
+    enum Button : uint8_t
+    {
+        A = (1 << 0),
+        B = (1 << 1),
+        Select = (1 << 2),
+        Start = (1 << 3),
+        Up = (1 << 4),
+        Down = (1 << 5),
+        Left = (1 << 6),
+        Right = (1 << 7),
+    };
+
+    uint8_t buttons = 0;
+    uint8_t shift = 0;
+    bool strobe = false;
+
+    void Write(uint8_t value)
+    {
+        strobe = value & 0x01;
+        if (strobe)
+            shift = buttons;
+    }
+
+    uint8_t Read()
+    {
+        // Upper bits are open bus, which is nearly always $40 from the address high byte.
+        if (strobe)
+            return 0x40 | (buttons & 0x01);
+
+        uint8_t bit = shift & 0x01;
+        shift = (shift >> 1) | 0x80; // Official pads return 1s once all 8 are out
+        return 0x40 | bit;
+    }
+};
+
+} // nes
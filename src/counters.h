@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace nes
+{
+
+// Where on the CPU bus an access went, by page.
+enum BusRegion : uint8_t
+{
+    RegionRam,       // $0000-$1FFF
+    RegionPpu,       // $2000-$3FFF
+    RegionIo,        // $4000-$40FF, APU, pads and DMA
+    RegionCartridge, // $4100-$7FFF, expansion and SRAM
+    RegionPrgRom,    // $8000-$FFFF
+    BusRegionCount,
+};
+
+// Plain copy of PerfCounters at one moment.
+struct PerfCounterValues
+{
+    uint64_t frames = 0;
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    uint64_t pageCrossings = 0; // Instructions that paid the extra cycle for crossing a page
+    // Counting every access costs about 15% of frame time, so these three stay zero
+    // unless the build has NES_BUS_COUNTERS=ON.
+    std::array<uint64_t, BusRegionCount> reads {}; // Opcode fetches included
+    std::array<uint64_t, BusRegionCount> writes {};
+    uint64_t fastAccesses = 0; // Straight through the page table
+    uint64_t dmaStallCycles = 0; // CPU cycles lost to OAM DMA
+    uint64_t slowAccesses = 0; // Devices, unmapped and instrumented pages
+    uint64_t lastFrameNanoseconds = 0;
+    uint64_t totalFrameNanoseconds = 0;
+};
+
+// Running totals for one console, for monitoring to scrape from any thread while
+// it runs. The console counts into plain members and only publishes here once a
+// frame, so the hot loop never touches an atomic. There's one writer, so publishing
+// is relaxed stores and no read-modify-writes, and a reader might see one frame's
+// numbers next to the previous frame's, which is fine for graphs. Totals only ever
+// go up, loading a snapshot or rolling back doesn't take anything off.
+struct alignas(64) PerfCounters
+{
+    std::atomic<uint64_t> frames { 0 };
+    std::atomic<uint64_t> instructions { 0 };
+    std::atomic<uint64_t> cycles { 0 };
+    std::atomic<uint64_t> pageCrossings { 0 };
+    std::array<std::atomic<uint64_t>, BusRegionCount> reads {};
+    std::array<std::atomic<uint64_t>, BusRegionCount> writes {};
+    std::atomic<uint64_t> fastAccesses { 0 };
+    std::atomic<uint64_t> dmaStallCycles { 0 };
+    std::atomic<uint64_t> slowAccesses { 0 };
+    std::atomic<uint64_t> lastFrameNanoseconds { 0 };
+    std::atomic<uint64_t> totalFrameNanoseconds { 0 };
+
+    // Writer side.
+    void Publish(PerfCounterValues const& values)
+    {
+        Store(frames, values.frames);
+        Store(instructions, values.instructions);
+        Store(cycles, values.cycles);
+        Store(pageCrossings, values.pageCrossings);
+        for (size_t region = 0; region < BusRegionCount; region++)
+        {
+            Store(reads[region], values.reads[region]);
+            Store(writes[region], values.writes[region]);
+        }
+        Store(fastAccesses, values.fastAccesses);
+        Store(dmaStallCycles, values.dmaStallCycles);
+        Store(slowAccesses, values.slowAccesses);
+        Store(lastFrameNanoseconds, values.lastFrameNanoseconds);
+        Store(totalFrameNanoseconds, values.totalFrameNanoseconds);
+    }
+
+    // Any thread.
+    PerfCounterValues Snapshot() const
+    {
+        PerfCounterValues values;
+        values.frames = frames.load(std::memory_order_relaxed);
+        values.instructions = instructions.load(std::memory_order_relaxed);
+        values.cycles = cycles.load(std::memory_order_relaxed);
+        values.pageCrossings = pageCrossings.load(std::memory_order_relaxed);
+        for (size_t region = 0; region < BusRegionCount; region++)
+        {
+            values.reads[region] = reads[region].load(std::memory_order_relaxed);
+            values.writes[region] = writes[region].load(std::memory_order_relaxed);
+        }
+        values.fastAccesses = fastAccesses.load(std::memory_order_relaxed);
+        values.dmaStallCycles = dmaStallCycles.load(std::memory_order_relaxed);
+        values.slowAccesses = slowAccesses.load(std::memory_order_relaxed);
+        values.lastFrameNanoseconds = lastFrameNanoseconds.load(std::memory_order_relaxed);
+        values.totalFrameNanoseconds = totalFrameNanoseconds.load(std::memory_order_relaxed);
+        return values;
+    }
+
+private:
+    static void Store(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(value, std::memory_order_relaxed);
+    }
+};
+
+} // nes
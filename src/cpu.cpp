@@ -1,5 +1,11 @@
 #include "cpu.h"
 #include "memory.h"
+#if NES_PROFILER
+#include "profiler.h"
+#endif
+#if NES_TRACER
+#include "trace.h"
+#endif
 #include <functional>
 #include <cassert>
 
@@ -49,13 +55,47 @@ uint8_t CPU::Step()
 {
     // Interrupt?
 
+#if NES_PROFILER
+    uint16_t const instructionPc = pc;
+#endif
+
+#if NES_TRACER
+    if (tracer)
+        tracer->Record(*this);
+#endif
+
     auto instruction = Fetch();
     auto instructionInfo = InstructionInfo[instruction];
-    auto operand = Decode(instructionInfo.addressMode);
-    pc += instructionInfo.instructionSize;
-    std::invoke(instructionInfo.instruction, this, operand);
+    uint8_t cycles = 2;
+
+    // Opcodes that aren't in the table yet get treated as a 1 byte NOP. Invoking
+    // the null member pointer would just take the whole host down with it.
+    if (instructionInfo.instruction == nullptr)
+    {
+        pc += 1;
+    }
+    else
+    {
+        auto operand = Decode(instructionInfo.addressMode);
+        pc += instructionInfo.instructionSize;
+        std::invoke(instructionInfo.instruction, this, operand);
 
-    return instructionInfo.cycles + (operand.pageCrossed ? instructionInfo.pageCycles : 0);
+        bool const pagePenalty = operand.pageCrossed && instructionInfo.pageCycles;
+        cycles = instructionInfo.cycles + (pagePenalty ? instructionInfo.pageCycles : 0);
+        pageCrossings += pagePenalty;
+    }
+
+#if NES_PROFILER
+    if (profiler)
+        profiler->Record(instructionPc, instruction, cycles, pc);
+#endif
+
+#if NES_TRACER
+    if (tracer)
+        tracer->AddCycles(cycles);
+#endif
+
+    return cycles;
 }
 
 void CPU::Reset()
@@ -72,9 +112,19 @@ void CPU::Reset()
     sp = 0xFD;
 }
 
+uint8_t CPU::Nmi()
+{
+    Push(static_cast<uint8_t>(pc >> 8));
+    Push(static_cast<uint8_t>(pc));
+    Push(static_cast<uint8_t>((s | U) & ~B));
+    s |= I;
+    pc = Read16(0xFFFA);
+    return 7;
+}
+
 uint8_t CPU::Fetch()
 {
-    return memoryBus->Read(pc);
+    return memoryBus->Fetch(pc);
 }
 
 // Some docs on addressing modes
@@ -220,7 +270,7 @@ InstructionInfo CPU::InstructionInfo[256] =
     /* 0x1E */ { &CPU::ASL, AddressMode::AbsoluteX, 3, 7, 0 },
     /* 0x1F */ {},
 
-    /* 0x20 */ {},
+    /* 0x20 */ { &CPU::JSR, AddressMode::Absolute, 3, 6, 0 },
     /* 0x21 */ {},
     /* 0x22 */ {},
     /* 0x23 */ {},
@@ -254,7 +304,7 @@ InstructionInfo CPU::InstructionInfo[256] =
     /* 0x3E */ { &CPU::ROL, AddressMode::AbsoluteX, 2, 7, 0 },
     /* 0x3F */ {},
 
-    /* 0x40 */ {},
+    /* 0x40 */ { &CPU::RTI, AddressMode::Implicit, 1, 6, 0 },
     /* 0x41 */ {},
     /* 0x42 */ {},
     /* 0x43 */ {},
@@ -288,7 +338,7 @@ InstructionInfo CPU::InstructionInfo[256] =
     /* 0x5E */ {},
     /* 0x5F */ {},
 
-    /* 0x60 */ {},
+    /* 0x60 */ { &CPU::RTS, AddressMode::Implicit, 1, 6, 0 },
     /* 0x61 */ { &CPU::ADC, AddressMode::IndexedIndirect, 2, 6, 0 },
     /* 0x62 */ {},
     /* 0x63 */ {},
@@ -746,12 +796,20 @@ void CPU::JMP(Operand const& operand)
     pc = operand.address;
 }
 
-void CPU::JSR(Operand const&)
+void CPU::JSR(Operand const& operand)
 {
+    // pc is already past the operand, the 6502 pushes the address of its last byte
+    uint16_t const returnAddress = pc - 1;
+    Push(returnAddress >> 8);
+    Push(returnAddress & 0xFF);
+    pc = operand.address;
 }
 
 void CPU::RTS(Operand const&)
 {
+    uint16_t const low = Pop();
+    uint16_t const high = Pop();
+    pc = (high << 8 | low) + 1;
 }
 
 // Branches
@@ -833,6 +891,9 @@ void CPU::NOP(Operand const&)
 
 void CPU::RTI(Operand const&)
 {
+    s = static_cast<uint8_t>((Pop() | U) & ~B);
+    uint8_t const low = Pop();
+    pc = static_cast<uint16_t>(low | (Pop() << 8));
 }
 
 } // nes
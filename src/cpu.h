@@ -31,6 +31,8 @@ struct Operand
 };
 
 struct CPU;
+class Profiler;
+class Tracer;
 typedef void (CPU::*Instruction)(Operand const&);
 
 struct InstructionInfo
@@ -53,6 +55,20 @@ struct CPU
 
     Memory* const memoryBus;
 
+    // Instructions that took the extra cycle for an index crossing a page. Only
+    // ever goes up, it's for the perf counters, not machine state.
+    uint64_t pageCrossings = 0;
+
+#if NES_PROFILER
+    // Only exists in profiling builds so the normal hot path doesn't even have the branch.
+    Profiler* profiler = nullptr;
+#endif
+
+#if NES_TRACER
+    // Same deal, tracing builds only.
+    Tracer* tracer = nullptr;
+#endif
+
 	explicit CPU(Memory* const memory);
 	~CPU() = default;
 	// Rule of 5 here?
@@ -60,6 +76,12 @@ struct CPU
     uint8_t Step();
 	void Reset();
 
+    // Takes an NMI, for the console to call between instructions. Returns the cycles it took.
+    uint8_t Nmi();
+
+    // Table entry for an opcode. instruction is null for ones we don't do yet.
+    static nes::InstructionInfo const& Info(uint8_t opcode) { return InstructionInfo[opcode]; }
+
 private:
 	uint8_t Fetch(); // Read current opcode from PC, right now, does NOT inc PC, step does all that.
 	Operand Decode(AddressMode addressMode) const;
@@ -71,7 +93,7 @@ public:
     uint8_t Pop();
 private:
 	// Instructions from http://www.obelisk.me.uk/6502/instructions.html
-    static InstructionInfo InstructionInfo[256];
+    static nes::InstructionInfo InstructionInfo[256];
     
 	// Load/Store Operations
 	void LDA(Operand const&);
@@ -1,13 +1,178 @@
 #include "cpumemory.h"
+#include "heatmap.h"
+#include "ppu.h"
+#include "zones.h"
 
 namespace nes
 {
 
-CPUMemory::CPUMemory(std::vector<uint8_t>& ram) : ram(ram)
+CPUMemory::CPUMemory(std::vector<uint8_t>& ram) : pages(), ram(ram), prgMask(0), heatmap(nullptr)
 {
+    Remap();
+}
+
+void CPUMemory::SetPrgRom(std::span<uint8_t const> rom)
+{
+    // NROM is 16K or 32K (Cartridge::Unsupported turns away anything else) so
+    // mirroring is just a mask
+    prgRom = rom;
+    prgMask = rom.empty() ? 0 : static_cast<uint16_t>(rom.size() - 1);
+    Remap();
+}
+
+size_t CPUMemory::AddWatchpoint(uint16_t first, uint16_t last, uint8_t access)
+{
+    watchpoints.push_back({ first, last, access });
+    Remap();
+    return watchpoints.size() - 1;
+}
+
+void CPUMemory::RemoveWatchpoint(size_t id)
+{
+    // Slot stays so the other ids don't move
+    watchpoints[id].access = 0;
+    Remap();
+}
+
+void CPUMemory::ClearWatchpoints()
+{
+    watchpoints.clear();
+    Remap();
+}
+
+void CPUMemory::SetHeatmap(Heatmap* heatmap)
+{
+    this->heatmap = heatmap;
+    Remap();
+}
+
+void CPUMemory::Remap()
+{
+    for (unsigned page = 0; page < pages.size(); page++)
+    {
+        uint16_t const start = static_cast<uint16_t>(page << 8);
+        auto& entry = pages[page];
+        entry = {};
+
+        entry.region = start < 0x2000 ? RegionRam : start < 0x4000 ? RegionPpu : start < 0x4100 ? RegionIo
+                     : start < 0x8000 ? RegionCartridge : RegionPrgRom;
+
+        entry.instrumented = heatmap != nullptr;
+        for (auto const& watchpoint : watchpoints)
+        {
+            if (watchpoint.access && watchpoint.first <= start + 0xFF && watchpoint.last >= start)
+                entry.instrumented = true;
+        }
+
+        if (entry.instrumented)
+            continue;
+
+        if (start < 0x2000)
+        {
+            entry.read = entry.write = ram.data() + (start & 0x7FF);
+        }
+        else if (start >= 0x8000 && prgRom.size() >= 0x100)
+        {
+            entry.read = prgRom.data() + ((start - 0x8000) & prgMask);
+        }
+    }
 }
 
 uint8_t CPUMemory::Read(uint16_t address)
+{
+    auto const& page = pages[address >> 8];
+#if NES_BUS_COUNTERS
+    readCounts[page.region]++;
+#endif
+    if (page.read)
+        return page.read[address & 0xFF];
+
+    return ReadSlow(address, WatchRead);
+}
+
+uint8_t CPUMemory::Fetch(uint16_t address)
+{
+    auto const& page = pages[address >> 8];
+#if NES_BUS_COUNTERS
+    readCounts[page.region]++;
+#endif
+    if (page.read)
+        return page.read[address & 0xFF];
+
+    return ReadSlow(address, WatchExecute);
+}
+
+uint8_t CPUMemory::Peek(uint16_t address)
+{
+    if (address < 0x2000)
+        return ram[address % 0x800];
+    if (address >= 0x8000 && !prgRom.empty())
+        return prgRom[(address - 0x8000) & prgMask];
+    return 0x00;
+}
+
+void CPUMemory::Write(uint16_t address, uint8_t value)
+{
+    auto const& page = pages[address >> 8];
+#if NES_BUS_COUNTERS
+    writeCounts[page.region]++;
+#endif
+    if (page.write)
+    {
+        page.write[address & 0xFF] = value;
+        return;
+    }
+
+    WriteSlow(address, value);
+}
+
+uint8_t CPUMemory::ReadSlow(uint16_t address, WatchAccess access)
+{
+    slowAccesses++;
+    auto const value = ReadDevice(address);
+    if (pages[address >> 8].instrumented)
+        Observe(address, value, access);
+    return value;
+}
+
+void CPUMemory::WriteSlow(uint16_t address, uint8_t value)
+{
+    slowAccesses++;
+    WriteDevice(address, value);
+    if (pages[address >> 8].instrumented)
+        Observe(address, value, WatchWrite);
+}
+
+void CPUMemory::Observe(uint16_t address, uint8_t value, WatchAccess access)
+{
+    if (heatmap)
+    {
+        auto& counts = access == WatchRead ? heatmap->reads : access == WatchWrite ? heatmap->writes : heatmap->executes;
+        counts[address]++;
+    }
+
+    for (size_t i = 0; i < watchpoints.size(); i++)
+    {
+        auto const& watchpoint = watchpoints[i];
+        if ((watchpoint.access & access) && address >= watchpoint.first && address <= watchpoint.last && onWatch)
+            onWatch({ address, value, access, i });
+    }
+}
+
+void CPUMemory::OamDma(uint8_t page)
+{
+    NES_ZONE("dma");
+    uint16_t const base = static_cast<uint16_t>(page << 8);
+    for (unsigned i = 0; i < 0x100; i++)
+        ppu->WriteOam(Read(static_cast<uint16_t>(base | i)));
+
+    // One more to line up when it starts on an odd cycle
+    uint32_t const stall = 513 + (ppu->Clock() & 1);
+    stallCycles += stall;
+    dmaStallCycles += stall;
+}
+
+uint8_t CPUMemory::ReadDevice(uint16_t address)
 {
     if (address < 0x2000)
     {
@@ -15,13 +180,20 @@ uint8_t CPUMemory::Read(uint16_t address)
     }
     else if (address < 0x4000)
     {
-        //auto ppuRegister = address % 8;
-        return 0x00;
+        return ppu ? ppu->ReadRegister(address) : 0x00;
+    }
+    else if (address == 0x4016 || address == 0x4017)
+    {
+        return controllers[address & 0x01].Read();
     }
     else if (address < 0x6000)
     {
         // Lots of more data mapping to do here
     }
+    else if (address >= 0x8000 && !prgRom.empty())
+    {
+        return prgRom[(address - 0x8000) & prgMask];
+    }
     else if (address >= 0x6000)
     {
         // Mapper
@@ -30,7 +202,7 @@ uint8_t CPUMemory::Read(uint16_t address)
     return 0x00;
 }
 
-void CPUMemory::Write(uint16_t address, uint8_t value)
+void CPUMemory::WriteDevice(uint16_t address, uint8_t value)
 {
     if (address < 0x2000)
     {
@@ -38,7 +210,19 @@ void CPUMemory::Write(uint16_t address, uint8_t value)
     }
     else if (address < 0x4000)
     {
-        // PPU register write
+        if (ppu)
+            ppu->WriteRegister(address, value);
+    }
+    else if (address == 0x4014)
+    {
+        if (ppu)
+            OamDma(value);
+    }
+    else if (address == 0x4016)
+    {
+        // One strobe line goes to both ports
+        controllers[0].Write(value);
+        controllers[1].Write(value);
     }
     else if (address < 0x6000)
     {
@@ -1,10 +1,41 @@
 #pragma once
 #include "memory.h"
+#include "controller.h"
+#include "counters.h"
+#include <array>
+#include <functional>
+#include <span>
 #include <vector>
 
 namespace nes
 {
 
+struct Heatmap;
+class PPU;
+
+enum WatchAccess : uint8_t
+{
+    WatchRead = 1,
+    WatchWrite = 2,
+    WatchExecute = 4, // Opcode fetches
+};
+
+// Stops on any access in [first, last] that matches the access mask.
+struct Watchpoint
+{
+    uint16_t first;
+    uint16_t last;
+    uint8_t access; // 0 once removed
+};
+
+struct WatchHit
+{
+    uint16_t address;
+    uint8_t value; // Read or written
+    WatchAccess access;
+    size_t watchpoint;
+};
+
 class CPUMemory : public Memory
 {
 public:
@@ -12,9 +43,67 @@ public:
     
     uint8_t Read(uint16_t address) override;
     void Write(uint16_t address, uint8_t value) override;
-    
+    uint8_t Fetch(uint16_t address) override;
+    uint8_t Peek(uint16_t address) override; // I/O reads 0, reading it for real would change it
+
+    // NROM only for now. 16K carts show up twice, at $8000 and $C000.
+    void SetPrgRom(std::span<uint8_t const> rom);
+
+    // Pages with a watchpoint in them go the slow way round, everything else keeps
+    // its direct pointer and doesn't know watchpoints exist. Returns an id for
+    // RemoveWatchpoint.
+    size_t AddWatchpoint(uint16_t first, uint16_t last, uint8_t access);
+    void RemoveWatchpoint(size_t id);
+    void ClearWatchpoints();
+
+    // Called on every hit, from inside the access.
+    std::function<void(WatchHit const&)> onWatch;
+
+    // Counts every access into heatmap until it's set back to null. That puts every
+    // page on the slow path, so it's for looking, not for speed.
+    void SetHeatmap(Heatmap* heatmap);
+
+    Controller controllers[2];
+
+    // Optional. Without one the PPU registers read 0 and OAM DMA goes nowhere.
+    PPU* ppu = nullptr;
+
+    // CPU cycles owed for OAM DMA, for the console to add on and zero after each
+    // instruction, and every one ever owed, for the perf counters.
+    uint32_t stallCycles = 0;
+    uint64_t dmaStallCycles = 0;
+
+    // How many accesses missed the page table, and with NES_BUS_COUNTERS every access
+    // by region. Only go up.
+    std::array<uint64_t, BusRegionCount> readCounts {};
+    std::array<uint64_t, BusRegionCount> writeCounts {};
+    uint64_t slowAccesses = 0;
+
 private:
+    // 256 byte pages. Null pointers mean go through the if chain below: I/O,
+    // unmapped, or instrumented.
+    struct Page
+    {
+        uint8_t const* read;
+        uint8_t* write;
+        BusRegion region;
+        bool instrumented;
+    };
+
+    void Remap();
+    uint8_t ReadSlow(uint16_t address, WatchAccess access);
+    void WriteSlow(uint16_t address, uint8_t value);
+    uint8_t ReadDevice(uint16_t address);
+    void WriteDevice(uint16_t address, uint8_t value);
+    void OamDma(uint8_t page);
+    void Observe(uint16_t address, uint8_t value, WatchAccess access);
+
+    std::array<Page, 256> pages;
     std::vector<uint8_t>& ram;
+    std::span<uint8_t const> prgRom;
+    uint16_t prgMask;
+    std::vector<Watchpoint> watchpoints;
+    Heatmap* heatmap;
 };
 
 } // nes
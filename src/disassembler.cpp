@@ -0,0 +1,309 @@
+#include "disassembler.h"
+#include <cstdio>
+
+namespace nes
+{
+
+// http://www.obelisk.me.uk/6502/reference.html
+static OpcodeName const Opcodes[256] =
+{
+    /* 0x00 */ { "BRK", 1, "" },
+    /* 0x01 */ { "ORA", 2, "($%02X,X)" },
+    /* 0x02 */ { "???", 1, "" },
+    /* 0x03 */ { "???", 1, "" },
+    /* 0x04 */ { "???", 1, "" },
+    /* 0x05 */ { "ORA", 2, "$%02X" },
+    /* 0x06 */ { "ASL", 2, "$%02X" },
+    /* 0x07 */ { "???", 1, "" },
+    /* 0x08 */ { "PHP", 1, "" },
+    /* 0x09 */ { "ORA", 2, "#$%02X" },
+    /* 0x0A */ { "ASL", 1, "A" },
+    /* 0x0B */ { "???", 1, "" },
+    /* 0x0C */ { "???", 1, "" },
+    /* 0x0D */ { "ORA", 3, "$%04X" },
+    /* 0x0E */ { "ASL", 3, "$%04X" },
+    /* 0x0F */ { "???", 1, "" },
+
+    /* 0x10 */ { "BPL", 2, "$%04X" },
+    /* 0x11 */ { "ORA", 2, "($%02X),Y" },
+    /* 0x12 */ { "???", 1, "" },
+    /* 0x13 */ { "???", 1, "" },
+    /* 0x14 */ { "???", 1, "" },
+    /* 0x15 */ { "ORA", 2, "$%02X,X" },
+    /* 0x16 */ { "ASL", 2, "$%02X,X" },
+    /* 0x17 */ { "???", 1, "" },
+    /* 0x18 */ { "CLC", 1, "" },
+    /* 0x19 */ { "ORA", 3, "$%04X,Y" },
+    /* 0x1A */ { "???", 1, "" },
+    /* 0x1B */ { "???", 1, "" },
+    /* 0x1C */ { "???", 1, "" },
+    /* 0x1D */ { "ORA", 3, "$%04X,X" },
+    /* 0x1E */ { "ASL", 3, "$%04X,X" },
+    /* 0x1F */ { "???", 1, "" },
+
+    /* 0x20 */ { "JSR", 3, "$%04X" },
+    /* 0x21 */ { "AND", 2, "($%02X,X)" },
+    /* 0x22 */ { "???", 1, "" },
+    /* 0x23 */ { "???", 1, "" },
+    /* 0x24 */ { "BIT", 2, "$%02X" },
+    /* 0x25 */ { "AND", 2, "$%02X" },
+    /* 0x26 */ { "ROL", 2, "$%02X" },
+    /* 0x27 */ { "???", 1, "" },
+    /* 0x28 */ { "PLP", 1, "" },
+    /* 0x29 */ { "AND", 2, "#$%02X" },
+    /* 0x2A */ { "ROL", 1, "A" },
+    /* 0x2B */ { "???", 1, "" },
+    /* 0x2C */ { "BIT", 3, "$%04X" },
+    /* 0x2D */ { "AND", 3, "$%04X" },
+    /* 0x2E */ { "ROL", 3, "$%04X" },
+    /* 0x2F */ { "???", 1, "" },
+
+    /* 0x30 */ { "BMI", 2, "$%04X" },
+    /* 0x31 */ { "AND", 2, "($%02X),Y" },
+    /* 0x32 */ { "???", 1, "" },
+    /* 0x33 */ { "???", 1, "" },
+    /* 0x34 */ { "???", 1, "" },
+    /* 0x35 */ { "AND", 2, "$%02X,X" },
+    /* 0x36 */ { "ROL", 2, "$%02X,X" },
+    /* 0x37 */ { "???", 1, "" },
+    /* 0x38 */ { "SEC", 1, "" },
+    /* 0x39 */ { "AND", 3, "$%04X,Y" },
+    /* 0x3A */ { "???", 1, "" },
+    /* 0x3B */ { "???", 1, "" },
+    /* 0x3C */ { "???", 1, "" },
+    /* 0x3D */ { "AND", 3, "$%04X,X" },
+    /* 0x3E */ { "ROL", 3, "$%04X,X" },
+    /* 0x3F */ { "???", 1, "" },
+
+    /* 0x40 */ { "RTI", 1, "" },
+    /* 0x41 */ { "EOR", 2, "($%02X,X)" },
+    /* 0x42 */ { "???", 1, "" },
+    /* 0x43 */ { "???", 1, "" },
+    /* 0x44 */ { "???", 1, "" },
+    /* 0x45 */ { "EOR", 2, "$%02X" },
+    /* 0x46 */ { "LSR", 2, "$%02X" },
+    /* 0x47 */ { "???", 1, "" },
+    /* 0x48 */ { "PHA", 1, "" },
+    /* 0x49 */ { "EOR", 2, "#$%02X" },
+    /* 0x4A */ { "LSR", 1, "A" },
+    /* 0x4B */ { "???", 1, "" },
+    /* 0x4C */ { "JMP", 3, "$%04X" },
+    /* 0x4D */ { "EOR", 3, "$%04X" },
+    /* 0x4E */ { "LSR", 3, "$%04X" },
+    /* 0x4F */ { "???", 1, "" },
+
+    /* 0x50 */ { "BVC", 2, "$%04X" },
+    /* 0x51 */ { "EOR", 2, "($%02X),Y" },
+    /* 0x52 */ { "???", 1, "" },
+    /* 0x53 */ { "???", 1, "" },
+    /* 0x54 */ { "???", 1, "" },
+    /* 0x55 */ { "EOR", 2, "$%02X,X" },
+    /* 0x56 */ { "LSR", 2, "$%02X,X" },
+    /* 0x57 */ { "???", 1, "" },
+    /* 0x58 */ { "CLI", 1, "" },
+    /* 0x59 */ { "EOR", 3, "$%04X,Y" },
+    /* 0x5A */ { "???", 1, "" },
+    /* 0x5B */ { "???", 1, "" },
+    /* 0x5C */ { "???", 1, "" },
+    /* 0x5D */ { "EOR", 3, "$%04X,X" },
+    /* 0x5E */ { "LSR", 3, "$%04X,X" },
+    /* 0x5F */ { "???", 1, "" },
+
+    /* 0x60 */ { "RTS", 1, "" },
+    /* 0x61 */ { "ADC", 2, "($%02X,X)" },
+    /* 0x62 */ { "???", 1, "" },
+    /* 0x63 */ { "???", 1, "" },
+    /* 0x64 */ { "???", 1, "" },
+    /* 0x65 */ { "ADC", 2, "$%02X" },
+    /* 0x66 */ { "ROR", 2, "$%02X" },
+    /* 0x67 */ { "???", 1, "" },
+    /* 0x68 */ { "PLA", 1, "" },
+    /* 0x69 */ { "ADC", 2, "#$%02X" },
+    /* 0x6A */ { "ROR", 1, "A" },
+    /* 0x6B */ { "???", 1, "" },
+    /* 0x6C */ { "JMP", 3, "($%04X)" },
+    /* 0x6D */ { "ADC", 3, "$%04X" },
+    /* 0x6E */ { "ROR", 3, "$%04X" },
+    /* 0x6F */ { "???", 1, "" },
+
+    /* 0x70 */ { "BVS", 2, "$%04X" },
+    /* 0x71 */ { "ADC", 2, "($%02X),Y" },
+    /* 0x72 */ { "???", 1, "" },
+    /* 0x73 */ { "???", 1, "" },
+    /* 0x74 */ { "???", 1, "" },
+    /* 0x75 */ { "ADC", 2, "$%02X,X" },
+    /* 0x76 */ { "ROR", 2, "$%02X,X" },
+    /* 0x77 */ { "???", 1, "" },
+    /* 0x78 */ { "SEI", 1, "" },
+    /* 0x79 */ { "ADC", 3, "$%04X,Y" },
+    /* 0x7A */ { "???", 1, "" },
+    /* 0x7B */ { "???", 1, "" },
+    /* 0x7C */ { "???", 1, "" },
+    /* 0x7D */ { "ADC", 3, "$%04X,X" },
+    /* 0x7E */ { "ROR", 3, "$%04X,X" },
+    /* 0x7F */ { "???", 1, "" },
+
+    /* 0x80 */ { "???", 1, "" },
+    /* 0x81 */ { "STA", 2, "($%02X,X)" },
+    /* 0x82 */ { "???", 1, "" },
+    /* 0x83 */ { "???", 1, "" },
+    /* 0x84 */ { "STY", 2, "$%02X" },
+    /* 0x85 */ { "STA", 2, "$%02X" },
+    /* 0x86 */ { "STX", 2, "$%02X" },
+    /* 0x87 */ { "???", 1, "" },
+    /* 0x88 */ { "DEY", 1, "" },
+    /* 0x89 */ { "???", 1, "" },
+    /* 0x8A */ { "TXA", 1, "" },
+    /* 0x8B */ { "???", 1, "" },
+    /* 0x8C */ { "STY", 3, "$%04X" },
+    /* 0x8D */ { "STA", 3, "$%04X" },
+    /* 0x8E */ { "STX", 3, "$%04X" },
+    /* 0x8F */ { "???", 1, "" },
+
+    /* 0x90 */ { "BCC", 2, "$%04X" },
+    /* 0x91 */ { "STA", 2, "($%02X),Y" },
+    /* 0x92 */ { "???", 1, "" },
+    /* 0x93 */ { "???", 1, "" },
+    /* 0x94 */ { "STY", 2, "$%02X,X" },
+    /* 0x95 */ { "STA", 2, "$%02X,X" },
+    /* 0x96 */ { "STX", 2, "$%02X,Y" },
+    /* 0x97 */ { "???", 1, "" },
+    /* 0x98 */ { "TYA", 1, "" },
+    /* 0x99 */ { "STA", 3, "$%04X,Y" },
+    /* 0x9A */ { "TXS", 1, "" },
+    /* 0x9B */ { "???", 1, "" },
+    /* 0x9C */ { "???", 1, "" },
+    /* 0x9D */ { "STA", 3, "$%04X,X" },
+    /* 0x9E */ { "???", 1, "" },
+    /* 0x9F */ { "???", 1, "" },
+
+    /* 0xA0 */ { "LDY", 2, "#$%02X" },
+    /* 0xA1 */ { "LDA", 2, "($%02X,X)" },
+    /* 0xA2 */ { "LDX", 2, "#$%02X" },
+    /* 0xA3 */ { "???", 1, "" },
+    /* 0xA4 */ { "LDY", 2, "$%02X" },
+    /* 0xA5 */ { "LDA", 2, "$%02X" },
+    /* 0xA6 */ { "LDX", 2, "$%02X" },
+    /* 0xA7 */ { "???", 1, "" },
+    /* 0xA8 */ { "TAY", 1, "" },
+    /* 0xA9 */ { "LDA", 2, "#$%02X" },
+    /* 0xAA */ { "TAX", 1, "" },
+    /* 0xAB */ { "???", 1, "" },
+    /* 0xAC */ { "LDY", 3, "$%04X" },
+    /* 0xAD */ { "LDA", 3, "$%04X" },
+    /* 0xAE */ { "LDX", 3, "$%04X" },
+    /* 0xAF */ { "???", 1, "" },
+
+    /* 0xB0 */ { "BCS", 2, "$%04X" },
+    /* 0xB1 */ { "LDA", 2, "($%02X),Y" },
+    /* 0xB2 */ { "???", 1, "" },
+    /* 0xB3 */ { "???", 1, "" },
+    /* 0xB4 */ { "LDY", 2, "$%02X,X" },
+    /* 0xB5 */ { "LDA", 2, "$%02X,X" },
+    /* 0xB6 */ { "LDX", 2, "$%02X,Y" },
+    /* 0xB7 */ { "???", 1, "" },
+    /* 0xB8 */ { "CLV", 1, "" },
+    /* 0xB9 */ { "LDA", 3, "$%04X,Y" },
+    /* 0xBA */ { "TSX", 1, "" },
+    /* 0xBB */ { "???", 1, "" },
+    /* 0xBC */ { "LDY", 3, "$%04X,X" },
+    /* 0xBD */ { "LDA", 3, "$%04X,X" },
+    /* 0xBE */ { "LDX", 3, "$%04X,Y" },
+    /* 0xBF */ { "???", 1, "" },
+
+    /* 0xC0 */ { "CPY", 2, "#$%02X" },
+    /* 0xC1 */ { "CMP", 2, "($%02X,X)" },
+    /* 0xC2 */ { "???", 1, "" },
+    /* 0xC3 */ { "???", 1, "" },
+    /* 0xC4 */ { "CPY", 2, "$%02X" },
+    /* 0xC5 */ { "CMP", 2, "$%02X" },
+    /* 0xC6 */ { "DEC", 2, "$%02X" },
+    /* 0xC7 */ { "???", 1, "" },
+    /* 0xC8 */ { "INY", 1, "" },
+    /* 0xC9 */ { "CMP", 2, "#$%02X" },
+    /* 0xCA */ { "DEX", 1, "" },
+    /* 0xCB */ { "???", 1, "" },
+    /* 0xCC */ { "CPY", 3, "$%04X" },
+    /* 0xCD */ { "CMP", 3, "$%04X" },
+    /* 0xCE */ { "DEC", 3, "$%04X" },
+    /* 0xCF */ { "???", 1, "" },
+
+    /* 0xD0 */ { "BNE", 2, "$%04X" },
+    /* 0xD1 */ { "CMP", 2, "($%02X),Y" },
+    /* 0xD2 */ { "???", 1, "" },
+    /* 0xD3 */ { "???", 1, "" },
+    /* 0xD4 */ { "???", 1, "" },
+    /* 0xD5 */ { "CMP", 2, "$%02X,X" },
+    /* 0xD6 */ { "DEC", 2, "$%02X,X" },
+    /* 0xD7 */ { "???", 1, "" },
+    /* 0xD8 */ { "CLD", 1, "" },
+    /* 0xD9 */ { "CMP", 3, "$%04X,Y" },
+    /* 0xDA */ { "???", 1, "" },
+    /* 0xDB */ { "???", 1, "" },
+    /* 0xDC */ { "???", 1, "" },
+    /* 0xDD */ { "CMP", 3, "$%04X,X" },
+    /* 0xDE */ { "DEC", 3, "$%04X,X" },
+    /* 0xDF */ { "???", 1, "" },
+
+    /* 0xE0 */ { "CPX", 2, "#$%02X" },
+    /* 0xE1 */ { "SBC", 2, "($%02X,X)" },
+    /* 0xE2 */ { "???", 1, "" },
+    /* 0xE3 */ { "???", 1, "" },
+    /* 0xE4 */ { "CPX", 2, "$%02X" },
+    /* 0xE5 */ { "SBC", 2, "$%02X" },
+    /* 0xE6 */ { "INC", 2, "$%02X" },
+    /* 0xE7 */ { "???", 1, "" },
+    /* 0xE8 */ { "INX", 1, "" },
+    /* 0xE9 */ { "SBC", 2, "#$%02X" },
+    /* 0xEA */ { "NOP", 1, "" },
+    /* 0xEB */ { "???", 1, "" },
+    /* 0xEC */ { "CPX", 3, "$%04X" },
+    /* 0xED */ { "SBC", 3, "$%04X" },
+    /* 0xEE */ { "INC", 3, "$%04X" },
+    /* 0xEF */ { "???", 1, "" },
+
+    /* 0xF0 */ { "BEQ", 2, "$%04X" },
+    /* 0xF1 */ { "SBC", 2, "($%02X),Y" },
+    /* 0xF2 */ { "???", 1, "" },
+    /* 0xF3 */ { "???", 1, "" },
+    /* 0xF4 */ { "???", 1, "" },
+    /* 0xF5 */ { "SBC", 2, "$%02X,X" },
+    /* 0xF6 */ { "INC", 2, "$%02X,X" },
+    /* 0xF7 */ { "???", 1, "" },
+    /* 0xF8 */ { "SED", 1, "" },
+    /* 0xF9 */ { "SBC", 3, "$%04X,Y" },
+    /* 0xFA */ { "???", 1, "" },
+    /* 0xFB */ { "???", 1, "" },
+    /* 0xFC */ { "???", 1, "" },
+    /* 0xFD */ { "SBC", 3, "$%04X,X" },
+    /* 0xFE */ { "INC", 3, "$%04X,X" },
+    /* 0xFF */ { "???", 1, "" },
+};
+
+OpcodeName const& Opcode(uint8_t opcode)
+{
+    return Opcodes[opcode];
+}
+
+std::string Disassemble(uint16_t pc, uint8_t opcode, uint8_t operand1, uint8_t operand2)
+{
+    auto const& name = Opcodes[opcode];
+    char text[32];
+
+    int length = snprintf(text, sizeof(text), "%s", name.mnemonic);
+    if (name.format[0] == '\0')
+        return std::string(text, length);
+
+    text[length++] = ' ';
+    unsigned value = operand1;
+    bool const branch = name.mnemonic[0] == 'B' && name.mnemonic[1] != 'I' && name.mnemonic[1] != 'R'; // Not BIT or BRK
+    if (branch)
+        value = static_cast<uint16_t>(pc + 2 + static_cast<int8_t>(operand1));
+    else if (name.size == 3)
+        value = operand2 << 8 | operand1;
+
+    length += snprintf(text + length, sizeof(text) - length, name.format, value);
+    return std::string(text, length);
+}
+
+} // nes
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace nes
+{
+
+// Official 6502 opcodes, independent of what CPU::InstructionInfo has got round to,
+// so traces and tools can name everything. Anything else comes out as "???".
+struct OpcodeName
+{
+    char const* mnemonic;
+    uint8_t size;
+    char const* format; // printf style, operands as %02X / %04X
+};
+
+OpcodeName const& Opcode(uint8_t opcode);
+
+// e.g. "LDA ($80),Y" or "JMP $C5F5". Relative branches show the target, which is
+// why it needs pc.
+std::string Disassemble(uint16_t pc, uint8_t opcode, uint8_t operand1, uint8_t operand2);
+
+} // nes
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "memory.h"
+#include <cstdint>
+
+namespace nes
+{
+
+// Plain 64K of RAM, no mirroring or I/O. For driving the CPU on its own in
+// benchmarks and conformance runs, where the bus shouldn't get in the way.
+class FlatMemory : public Memory
+{
+public:
+    uint8_t data[0x10000] = { 0 };
+
+    uint8_t Read(uint16_t address) override
+    {
+        return data[address];
+    }
+
+    void Write(uint16_t address, uint8_t value) override
+    {
+        data[address] = value;
+    }
+};
+
+} // nes
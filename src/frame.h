@@ -0,0 +1,25 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace nes
+{
+
+constexpr unsigned FrameWidth = 256;
+constexpr unsigned FrameHeight = 240;
+
+// NTSC, 1.789773MHz CPU over 29780.5 cycles a frame.
+constexpr double NtscFrameRate = 60.0988;
+
+// One pixel the way the PPU puts it out: palette index in the low 6 bits and the
+// PPUMASK emphasis bits (red, green, blue) in bits 6-8. Turning that into a colour
+// is the palette's job, see palette.h.
+using Pixel = uint16_t;
+
+constexpr Pixel PixelIndexMask = 0x3F;
+constexpr Pixel PixelMask = 0x1FF;
+
+using FrameBuffer = std::array<Pixel, FrameWidth * FrameHeight>;
+
+} // nes
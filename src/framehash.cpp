@@ -0,0 +1,187 @@
+#include "framehash.h"
+#include "hash.h"
+#include "simd.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace nes
+{
+
+DirtyTiles DirtyTiles::All()
+{
+    DirtyTiles dirty;
+    dirty.rows.fill(UINT32_MAX);
+    return dirty;
+}
+
+bool DirtyTiles::Any() const
+{
+    for (auto row : rows)
+    {
+        if (row)
+            return true;
+    }
+    return false;
+}
+
+unsigned DirtyTiles::Count() const
+{
+    unsigned count = 0;
+    for (auto row : rows)
+        count += static_cast<unsigned>(std::popcount(row));
+    return count;
+}
+
+std::vector<TileRect> DirtyTiles::Rects() const
+{
+    std::vector<TileRect> rects;
+    std::vector<size_t> above; // Rects that reach down to the row before this one
+    std::vector<size_t> reaching;
+    for (unsigned row = 0; row < TileRows; row++)
+    {
+        reaching.clear();
+        uint32_t bits = rows[row];
+        while (bits)
+        {
+            unsigned const column = static_cast<unsigned>(std::countr_zero(bits));
+            unsigned const length = static_cast<unsigned>(std::countr_one(bits >> column));
+            bits = column + length >= 32 ? 0 : bits & (UINT32_MAX << (column + length));
+
+            auto const x = static_cast<uint16_t>(column * TileSize);
+            auto const width = static_cast<uint16_t>(length * TileSize);
+            auto const join = std::find_if(above.begin(), above.end(),
+                                           [&](size_t i) { return rects[i].x == x && rects[i].width == width; });
+            if (join != above.end())
+            {
+                rects[*join].height += TileSize;
+                reaching.push_back(*join);
+            }
+            else
+            {
+                reaching.push_back(rects.size());
+                rects.push_back({ x, static_cast<uint16_t>(row * TileSize), width, TileSize });
+            }
+        }
+        std::swap(above, reaching);
+    }
+    return rects;
+}
+
+static constexpr uint32_t LanePrime = 0x9E3779B1u;
+static constexpr unsigned Lanes = 4; // 32 bit lanes a tile line, 8 pixels of 16 bits
+
+// Different per lane, so the same pixels in a different lane hash differently
+static constexpr uint32_t LaneSeeds[Lanes] = { 0x85EBCA77u, 0xC2B2AE3Du, 0x27D4EB2Fu, 0x165667B1u };
+
+// Folds the four lanes into 64 bits. Each lane is already well mixed, this only
+// has to keep them from cancelling out.
+static uint64_t FinishTile(uint32_t const* lanes)
+{
+    uint64_t low, high;
+    std::memcpy(&low, lanes, 8);
+    std::memcpy(&high, lanes + 2, 8);
+    uint64_t h = (low * 0x9E3779B97F4A7C15ull) ^ high;
+    h *= 0xC2B2AE3D27D4EB4Full;
+    return h ^ (h >> 29);
+}
+
+static void HashTileRowScalar(Pixel const* pixels, uint64_t* tiles)
+{
+    for (unsigned column = 0; column < TileColumns; column++)
+    {
+        uint32_t lanes[Lanes];
+        std::memcpy(lanes, LaneSeeds, sizeof(lanes));
+        for (unsigned line = 0; line < TileSize; line++)
+        {
+            uint32_t data[Lanes];
+            std::memcpy(data, pixels + line * FrameWidth + column * TileSize, sizeof(data));
+            for (unsigned lane = 0; lane < Lanes; lane++)
+            {
+                uint32_t const h = (lanes[lane] ^ data[lane]) * LanePrime;
+                lanes[lane] = h ^ (h >> 15);
+            }
+        }
+        tiles[column] = FinishTile(lanes);
+    }
+}
+
+#if NES_AVX2
+
+// Two tiles a register, the same sums as the scalar loop lane for lane.
+__attribute__((target("avx2"))) static void HashTileRowAvx2(Pixel const* pixels, uint64_t* tiles)
+{
+    auto const seeds = _mm256_loadu2_m128i(reinterpret_cast<__m128i const*>(LaneSeeds),
+                                           reinterpret_cast<__m128i const*>(LaneSeeds));
+    auto const prime = _mm256_set1_epi32(static_cast<int>(LanePrime));
+    for (unsigned column = 0; column < TileColumns; column += 2)
+    {
+        auto lanes = seeds;
+        for (unsigned line = 0; line < TileSize; line++)
+        {
+            auto const data = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pixels + line * FrameWidth + column * TileSize));
+            auto const h = _mm256_mullo_epi32(_mm256_xor_si256(lanes, data), prime);
+            lanes = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+        }
+
+        alignas(32) uint32_t out[Lanes * 2];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out), lanes);
+        tiles[column] = FinishTile(out);
+        tiles[column + 1] = FinishTile(out + Lanes);
+    }
+}
+
+#endif
+
+static void Hash(FrameBuffer const& pixels, TileHashes& tiles, [[maybe_unused]] bool simd)
+{
+    for (unsigned row = 0; row < TileRows; row++)
+    {
+        Pixel const* source = pixels.data() + row * TileSize * FrameWidth;
+        uint64_t* out = tiles.data() + row * TileColumns;
+#if NES_AVX2
+        if (simd && HasAvx2())
+        {
+            HashTileRowAvx2(source, out);
+            continue;
+        }
+#endif
+        HashTileRowScalar(source, out);
+    }
+}
+
+void HashTiles(FrameBuffer const& pixels, TileHashes& tiles)
+{
+    Hash(pixels, tiles, true);
+}
+
+void HashTilesScalar(FrameBuffer const& pixels, TileHashes& tiles)
+{
+    Hash(pixels, tiles, false);
+}
+
+bool HashTilesUsesAvx2()
+{
+    return HasAvx2();
+}
+
+uint64_t HashFrame(TileHashes const& tiles)
+{
+    return Hash64({ reinterpret_cast<uint8_t const*>(tiles.data()), sizeof(tiles) });
+}
+
+DirtyTiles CompareTiles(TileHashes const& before, TileHashes const& after)
+{
+    DirtyTiles dirty;
+    for (unsigned row = 0; row < TileRows; row++)
+    {
+        uint32_t bits = 0;
+        for (unsigned column = 0; column < TileColumns; column++)
+            bits |= uint32_t { before[row * TileColumns + column] != after[row * TileColumns + column] } << column;
+        dirty.rows[row] = bits;
+    }
+    return dirty;
+}
+
+} // nes
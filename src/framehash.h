@@ -0,0 +1,63 @@
+#pragma once
+
+#include "frame.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace nes
+{
+
+// The PPU's own tile size, so a scrolling background or a sprite moving dirties
+// about as many tiles as it covers.
+constexpr unsigned TileSize = 8;
+constexpr unsigned TileColumns = FrameWidth / TileSize;
+constexpr unsigned TileRows = FrameHeight / TileSize;
+constexpr unsigned TileCount = TileColumns * TileRows;
+
+// One hash per tile, a row of tiles at a time from the top left.
+using TileHashes = std::array<uint64_t, TileCount>;
+
+// In pixels.
+struct TileRect
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+
+    bool operator==(TileRect const&) const = default;
+};
+
+// Which tiles changed, a word per row of tiles with bit n for column n.
+struct DirtyTiles
+{
+    std::array<uint32_t, TileRows> rows {};
+
+    static DirtyTiles All();
+
+    bool Test(unsigned column, unsigned row) const { return (rows[row] >> column) & 1; }
+    void Mark(unsigned column, unsigned row) { rows[row] |= 1u << column; }
+    bool Any() const;
+    unsigned Count() const;
+
+    // The dirty tiles as few-ish rectangles: runs along each row, with a run the
+    // same as one on the row above joined onto it. Not the fewest possible, but
+    // never any clean tiles.
+    std::vector<TileRect> Rects() const;
+};
+
+// Hashes every tile of a frame of palette indices, 8 rows of pixels at a time. A
+// handful of independent 32 bit multiply/xorshift lanes per tile, so AVX2 does two
+// tiles a register, and the scalar path gives the same numbers. Like Hash64,
+// for spotting changes, nothing cryptographic.
+void HashTiles(FrameBuffer const& pixels, TileHashes& tiles);
+void HashTilesScalar(FrameBuffer const& pixels, TileHashes& tiles);
+bool HashTilesUsesAvx2();
+
+// Whole frame from its tile hashes.
+uint64_t HashFrame(TileHashes const& tiles);
+
+DirtyTiles CompareTiles(TileHashes const& before, TileHashes const& after);
+
+} // nes
@@ -0,0 +1,212 @@
+#include "framepipeline.h"
+#include "zones.h"
+#include <algorithm>
+
+namespace nes
+{
+
+static std::chrono::steady_clock::duration Period(double hz)
+{
+    using namespace std::chrono;
+    return hz > 0 ? duration_cast<steady_clock::duration>(duration<double>(1.0 / hz)) : steady_clock::duration::zero();
+}
+
+FramePipeline::FramePipeline(Produce produce, Present present, FramePacingOptions const& options)
+    : produce(std::move(produce)), present(std::move(present)), options(options)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+    Stop();
+}
+
+void FramePipeline::Start()
+{
+    emulation = std::thread([this] { Emulate(); });
+    presentation = std::thread([this] { Presentation(); });
+}
+
+void FramePipeline::Wait()
+{
+    if (emulation.joinable())
+        emulation.join();
+
+    emulationDone.store(true, std::memory_order_release);
+    buffer.Interrupt();
+
+    if (presentation.joinable())
+        presentation.join();
+}
+
+void FramePipeline::Stop()
+{
+    stopEmulation.store(true, std::memory_order_relaxed);
+    Wait();
+}
+
+void FramePipeline::Emulate()
+{
+#if NES_ENABLE_ZONES
+    NameZoneThread("emulation");
+#endif
+
+    auto const period = Period(options.emulationHz);
+    auto deadline = Clock::now();
+    for (uint64_t frame = 0; options.frames == 0 || frame < options.frames; frame++)
+    {
+        if (stopEmulation.load(std::memory_order_relaxed))
+            break;
+
+        if (period > Clock::duration::zero())
+        {
+            auto const now = Clock::now();
+            if (now < deadline)
+            {
+                std::this_thread::sleep_until(deadline);
+            }
+            else if (now > deadline + period)
+            {
+                // A whole frame behind, catching up would just run a burst of frames
+                // nobody sees, so start counting again from here
+                late.fetch_add(1, std::memory_order_relaxed);
+                deadline = now;
+            }
+            deadline += period;
+        }
+
+        auto& next = buffer.Back();
+        next.number = frame;
+        {
+            NES_ZONE("emulate");
+            produce(next);
+        }
+
+        if (options.digest)
+        {
+            NES_ZONE("digest");
+            HashTiles(next.pixels, next.tiles);
+            next.hash = HashFrame(next.tiles);
+        }
+
+        produced.fetch_add(1, std::memory_order_relaxed);
+        if (buffer.Publish())
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FramePipeline::RecordPresent(Clock::time_point& last, Clock::duration period)
+{
+    auto const now = Clock::now();
+    if (presented.fetch_add(1, std::memory_order_relaxed) > 0 && period > Clock::duration::zero())
+    {
+        auto const gap = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last - period).count();
+        auto const jitter = static_cast<uint64_t>(gap < 0 ? -gap : gap);
+        jitterSamples.fetch_add(1, std::memory_order_relaxed);
+        jitterNanoseconds.fetch_add(jitter, std::memory_order_relaxed);
+        if (jitter > maxJitterNanoseconds.load(std::memory_order_relaxed))
+            maxJitterNanoseconds.store(jitter, std::memory_order_relaxed);
+    }
+    last = now;
+}
+
+void FramePipeline::Compare(VideoFrame& frame)
+{
+    if (!options.digest)
+        return;
+
+    frame.changed = !presentedAny || frame.hash != presentedHash;
+    frame.dirty = presentedAny ? CompareTiles(presentedTiles, frame.tiles) : DirtyTiles::All();
+    if (!frame.changed)
+        unchanged.fetch_add(1, std::memory_order_relaxed);
+
+    presentedTiles = frame.tiles;
+    presentedHash = frame.hash;
+    presentedAny = true;
+}
+
+void FramePipeline::Presentation()
+{
+#if NES_ENABLE_ZONES
+    NameZoneThread("presentation");
+#endif
+
+    Clock::time_point last;
+
+    if (options.presentHz > 0)
+    {
+        bool haveFrame = false;
+        // Refresh driven, whatever's newest at each tick
+        auto const period = Period(options.presentHz);
+        auto tick = Clock::now();
+        while (true)
+        {
+            tick = std::max(tick + period, Clock::now() - period);
+            std::this_thread::sleep_until(tick);
+
+            // Done first, so a frame published just before it still gets shown
+            bool const done = emulationDone.load(std::memory_order_acquire);
+            bool const fresh = buffer.Acquire();
+            if (done && !fresh)
+                break;
+            if (!fresh && !haveFrame)
+                continue;
+
+            auto& frame = buffer.Front();
+            if (fresh)
+            {
+                Compare(frame);
+            }
+            else
+            {
+                duplicated.fetch_add(1, std::memory_order_relaxed);
+                frame.changed = false;
+                frame.dirty = {};
+            }
+            haveFrame = true;
+
+            NES_ZONE("present");
+            present(frame);
+            RecordPresent(last, period);
+        }
+        return;
+    }
+
+    // Frame driven, each new frame as soon as it's there
+    auto const period = Period(options.emulationHz);
+    while (true)
+    {
+        auto const seen = buffer.Sequence();
+        bool const done = emulationDone.load(std::memory_order_acquire);
+        if (buffer.Acquire())
+        {
+            Compare(buffer.Front());
+            NES_ZONE("present");
+            present(buffer.Front());
+            RecordPresent(last, period);
+            continue;
+        }
+
+        if (done)
+            break;
+        buffer.Wait(seen);
+    }
+}
+
+FramePacingStats FramePipeline::Stats() const
+{
+    FramePacingStats stats;
+    stats.produced = produced.load(std::memory_order_relaxed);
+    stats.presented = presented.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.duplicated = duplicated.load(std::memory_order_relaxed);
+    stats.late = late.load(std::memory_order_relaxed);
+    stats.unchanged = unchanged.load(std::memory_order_relaxed);
+
+    auto const samples = jitterSamples.load(std::memory_order_relaxed);
+    stats.meanJitterMicroseconds = samples ? jitterNanoseconds.load(std::memory_order_relaxed) / 1e3 / samples : 0.0;
+    stats.maxJitterMicroseconds = maxJitterNanoseconds.load(std::memory_order_relaxed) / 1e3;
+    return stats;
+}
+
+} // nes
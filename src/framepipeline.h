@@ -0,0 +1,113 @@
+#pragma once
+
+#include "frame.h"
+#include "framehash.h"
+#include "triplebuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace nes
+{
+
+struct VideoFrame
+{
+    FrameBuffer pixels;
+    uint64_t number; // Counts from 0, set by the pipeline
+
+    // Only with FramePacingOptions::digest. hash and tiles are worked out on the
+    // emulation thread, changed and dirty on the presentation thread against the
+    // last frame presented, so they cover any frames dropped in between. A
+    // duplicate present has nothing changed and nothing dirty.
+    uint64_t hash;
+    bool changed;
+    TileHashes tiles;
+    DirtyTiles dirty;
+};
+
+struct FramePacingOptions
+{
+    double emulationHz = NtscFrameRate; // 0 runs flat out
+    double presentHz = 0;               // Like a display refresh. 0 presents each new frame as it turns up.
+    uint64_t frames = 0;                // Stop emulating after this many, 0 for when Stop is called
+    bool digest = false;                // Hash each frame and mark its dirty tiles, see VideoFrame
+};
+
+struct FramePacingStats
+{
+    uint64_t produced;
+    uint64_t presented;   // Including duplicates
+    uint64_t dropped;     // Produced, then replaced before presentation got to them
+    uint64_t duplicated;  // Refreshes with nothing new, the last frame went again
+    uint64_t late;        // Frames the emulation thread started after their deadline
+    uint64_t unchanged;   // Presented new but identical to the frame before, with digest on
+    double meanJitterMicroseconds; // Gap between presents against what it should have been
+    double maxJitterMicroseconds;
+};
+
+// Emulation on one thread, presentation on another, a TripleBuffer between them.
+// Emulation never waits for presentation, however slow it is, and presentation
+// never waits for emulation beyond there being a first frame, it shows the last
+// one again instead.
+//
+// produce runs on the emulation thread and fills in the next frame, present runs on
+// the presentation thread.
+class FramePipeline
+{
+public:
+    using Produce = std::function<void(VideoFrame&)>;
+    using Present = std::function<void(VideoFrame const&)>;
+
+    FramePipeline(Produce produce, Present present, FramePacingOptions const& options = {});
+    ~FramePipeline();
+    FramePipeline(FramePipeline const&) = delete;
+    FramePipeline& operator=(FramePipeline const&) = delete;
+
+    void Start();
+
+    // Waits for emulation to get through options.frames and for the last of them to
+    // be presented.
+    void Wait();
+
+    // Stops emulation after the frame it's on.
+    void Stop();
+
+    // Safe from any thread while it runs.
+    FramePacingStats Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Emulate();
+    void Presentation();
+    void RecordPresent(Clock::time_point& last, Clock::duration period);
+    void Compare(VideoFrame& frame);
+
+    Produce produce;
+    Present present;
+    FramePacingOptions options;
+    TripleBuffer<VideoFrame> buffer;
+    std::thread emulation;
+    std::thread presentation;
+    std::atomic<bool> stopEmulation { false };
+    std::atomic<bool> emulationDone { false };
+
+    // Presentation thread's, what the last frame it presented looked like
+    TileHashes presentedTiles;
+    uint64_t presentedHash = 0;
+    bool presentedAny = false;
+
+    std::atomic<uint64_t> produced { 0 };
+    std::atomic<uint64_t> presented { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<uint64_t> duplicated { 0 };
+    std::atomic<uint64_t> late { 0 };
+    std::atomic<uint64_t> unchanged { 0 };
+    std::atomic<uint64_t> jitterSamples { 0 };
+    std::atomic<uint64_t> jitterNanoseconds { 0 };
+    std::atomic<uint64_t> maxJitterNanoseconds { 0 };
+};
+
+} // nes
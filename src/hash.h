@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace nes
+{
+
+// Quick 64 bit hash for spotting when two runs stop matching. Eight bytes at a
+// time multiply/xorshift, nothing cryptographic about it.
+inline uint64_t Hash64(std::span<uint8_t const> data, uint64_t seed = 0)
+{
+    constexpr uint64_t Prime1 = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+
+    auto mix = [](uint64_t h)
+    {
+        h ^= h >> 31;
+        h *= Prime2;
+        h ^= h >> 29;
+        return h;
+    };
+
+    uint64_t h = seed ^ (data.size() * Prime1);
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data.data() + i, 8);
+        h = (h ^ mix(word * Prime1)) * Prime1;
+    }
+
+    uint64_t tail = 0;
+    if (i < data.size())
+        std::memcpy(&tail, data.data() + i, data.size() - i);
+    h = (h ^ mix(tail * Prime1)) * Prime1;
+
+    return mix(h);
+}
+
+} // nes
@@ -0,0 +1,49 @@
+#include "heatmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace nes
+{
+
+void Heatmap::Clear()
+{
+    std::fill(reads.begin(), reads.end(), 0);
+    std::fill(writes.begin(), writes.end(), 0);
+    std::fill(executes.begin(), executes.end(), 0);
+}
+
+void Heatmap::WritePgm(std::ostream& stream) const
+{
+    uint64_t most = 0;
+    for (size_t i = 0; i < 0x10000; i++)
+        most = std::max<uint64_t>(most, uint64_t(reads[i]) + writes[i] + executes[i]);
+
+    double const scale = most > 0 ? 255.0 / std::log2(most + 1.0) : 0.0;
+
+    std::vector<char> pixels(0x10000);
+    for (size_t i = 0; i < 0x10000; i++)
+    {
+        uint64_t const total = uint64_t(reads[i]) + writes[i] + executes[i];
+        pixels[i] = static_cast<char>(std::lround(std::log2(total + 1.0) * scale));
+    }
+
+    stream << "P5\n256 256\n255\n";
+    stream.write(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+}
+
+void Heatmap::WriteCsv(std::ostream& stream) const
+{
+    stream << "address,reads,writes,executes\n";
+    for (size_t i = 0; i < 0x10000; i++)
+    {
+        if (reads[i] == 0 && writes[i] == 0 && executes[i] == 0)
+            continue;
+
+        char line[64];
+        snprintf(line, sizeof(line), "$%04zX,%u,%u,%u\n", i, reads[i], writes[i], executes[i]);
+        stream << line;
+    }
+}
+
+} // nes
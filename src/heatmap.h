@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace nes
+{
+
+// How often each of the 64K CPU addresses was read, written and executed from.
+// Opcode fetches count as executes, not reads.
+struct Heatmap
+{
+    std::vector<uint32_t> reads = std::vector<uint32_t>(0x10000);
+    std::vector<uint32_t> writes = std::vector<uint32_t>(0x10000);
+    std::vector<uint32_t> executes = std::vector<uint32_t>(0x10000);
+
+    void Clear();
+
+    // 256x256 greyscale, one pixel per address with a page per row, so $C000 is
+    // row 192. Log scaled, counts vary far too much for anything else.
+    void WritePgm(std::ostream& stream) const;
+
+    // "address,reads,writes,executes", only addresses that were touched.
+    void WriteCsv(std::ostream& stream) const;
+};
+
+} // nes
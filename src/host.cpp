@@ -0,0 +1,151 @@
+#include "host.h"
+#include "tsc.h"
+#include "zones.h"
+#include <algorithm>
+#include <cmath>
+
+namespace nes
+{
+
+static size_t BucketFor(uint64_t nanoseconds)
+{
+    if (nanoseconds < 2)
+        return 0;
+
+    auto const bucket = static_cast<size_t>(std::log2(static_cast<double>(nanoseconds)) * LatencyHistogram::BucketsPerOctave);
+    return std::min(bucket, LatencyHistogram::BucketCount - 1);
+}
+
+void LatencyHistogram::Record(uint64_t nanoseconds)
+{
+    buckets[BucketFor(nanoseconds)]++;
+    count++;
+    totalNanoseconds += nanoseconds;
+    maxNanoseconds = std::max(maxNanoseconds, nanoseconds);
+}
+
+void LatencyHistogram::Merge(LatencyHistogram const& other)
+{
+    for (size_t i = 0; i < BucketCount; i++)
+        buckets[i] += other.buckets[i];
+
+    count += other.count;
+    totalNanoseconds += other.totalNanoseconds;
+    maxNanoseconds = std::max(maxNanoseconds, other.maxNanoseconds);
+}
+
+uint64_t LatencyHistogram::Percentile(double percentile) const
+{
+    if (count == 0)
+        return 0;
+
+    auto const target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BucketCount; i++)
+    {
+        seen += buckets[i];
+        if (seen >= target)
+        {
+            // Top edge of the bucket, but never more than we've actually seen.
+            auto const upper = std::exp2(static_cast<double>(i + 1) / BucketsPerOctave);
+            return std::min(static_cast<uint64_t>(upper), maxNanoseconds);
+        }
+    }
+
+    return maxNanoseconds;
+}
+
+Host::Host(JobScheduler& scheduler) : scheduler(scheduler), seconds(0)
+{
+}
+
+size_t Host::Add(std::unique_ptr<Console> console)
+{
+    auto const index = instances.size();
+    auto const home = static_cast<unsigned>(index % scheduler.WorkerCount());
+
+    instances.push_back(std::make_unique<Slot>(Slot {
+        .console = std::move(console),
+        .homeWorker = home,
+        .lastWorker = home,
+        .framesRemaining = 0,
+        .submitted = {},
+        .stats = {},
+    }));
+
+    return index;
+}
+
+void Host::RunFrames(uint64_t frames)
+{
+    if (frames == 0)
+        return;
+
+    auto const start = Clock::now();
+
+    for (auto& instance : instances)
+    {
+        instance->framesRemaining = frames;
+        Schedule(*instance);
+    }
+
+    scheduler.Wait();
+
+    seconds += std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void Host::Schedule(Slot& instance)
+{
+    instance.submitted = Clock::now();
+    scheduler.Submit([this, &instance] { RunFrame(instance); }, instance.homeWorker);
+}
+
+void Host::RunFrame(Slot& instance)
+{
+    NES_ZONE("frame");
+    auto const worker = JobScheduler::CurrentWorker();
+    if (worker != instance.lastWorker)
+        instance.stats.migrations++;
+    instance.lastWorker = worker;
+
+    auto const started = Clock::now();
+    auto const startTicks = ReadTimestampCounter();
+    instance.console->RunFrame();
+    auto const endTicks = ReadTimestampCounter();
+    auto const finished = Clock::now();
+
+    using std::chrono::nanoseconds;
+    instance.stats.frames++;
+    instance.stats.busyNanoseconds += std::chrono::duration_cast<nanoseconds>(finished - started).count();
+    instance.stats.busyTicks += endTicks - startTicks;
+    instance.stats.latency.Record(std::chrono::duration_cast<nanoseconds>(finished - instance.submitted).count());
+
+    // Only one frame of an instance is ever in flight, so nothing else touches it.
+    if (--instance.framesRemaining > 0)
+        Schedule(instance);
+}
+
+HostMetrics Host::Metrics() const
+{
+    LatencyHistogram latency;
+    HostMetrics metrics {};
+    metrics.instances = instances.size();
+
+    for (auto const& instance : instances)
+    {
+        metrics.frames += instance->stats.frames;
+        metrics.migrations += instance->stats.migrations;
+        latency.Merge(instance->stats.latency);
+    }
+
+    metrics.steals = scheduler.Steals();
+    metrics.seconds = seconds;
+    metrics.framesPerSecond = seconds > 0 ? metrics.frames / seconds : 0;
+    metrics.meanLatencyMicroseconds = latency.count ? latency.totalNanoseconds / 1000.0 / latency.count : 0;
+    metrics.p99LatencyMicroseconds = latency.Percentile(99) / 1000.0;
+    metrics.maxLatencyMicroseconds = latency.maxNanoseconds / 1000.0;
+
+    return metrics;
+}
+
+} // nes
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "console.h"
+#include "scheduler.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nes
+{
+
+// Log scale histogram, 8 buckets per power of two, so about 9% resolution from
+// 1ns up to ~4s. Fixed size so recording never allocates.
+struct LatencyHistogram
+{
+    static constexpr size_t BucketsPerOctave = 8;
+    static constexpr size_t BucketCount = 32 * BucketsPerOctave;
+
+    std::array<uint64_t, BucketCount> buckets {};
+    uint64_t count = 0;
+    uint64_t totalNanoseconds = 0;
+    uint64_t maxNanoseconds = 0;
+
+    void Record(uint64_t nanoseconds);
+    void Merge(LatencyHistogram const& other);
+    uint64_t Percentile(double percentile) const;
+};
+
+struct InstanceStats
+{
+    uint64_t frames = 0;
+    uint64_t busyNanoseconds = 0;
+    uint64_t busyTicks = 0; // Host TSC ticks spent inside RunFrame
+    uint64_t migrations = 0; // Frames that ran on a different worker to the previous one
+    LatencyHistogram latency;
+};
+
+struct HostMetrics
+{
+    uint64_t instances;
+    uint64_t frames;
+    uint64_t steals;
+    uint64_t migrations;
+    double seconds;
+    double framesPerSecond;
+    double meanLatencyMicroseconds;
+    double p99LatencyMicroseconds;
+    double maxLatencyMicroseconds;
+};
+
+// Runs a bunch of independent consoles on a JobScheduler. Each frame of each
+// console is one job. An instance always asks for the same worker so its RAM and
+// CPU state stay warm in one core's cache, and it only moves if that worker is
+// behind and another one steals it.
+class Host
+{
+public:
+    explicit Host(JobScheduler& scheduler);
+
+    size_t Add(std::unique_ptr<Console> console);
+
+    size_t InstanceCount() const { return instances.size(); }
+    Console& Instance(size_t index) { return *instances[index]->console; }
+    InstanceStats const& Stats(size_t index) const { return instances[index]->stats; }
+
+    // Runs every instance forward by frames and waits for them all.
+    void RunFrames(uint64_t frames);
+
+    // Totals over everything run so far.
+    HostMetrics Metrics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot
+    {
+        std::unique_ptr<Console> console;
+        unsigned homeWorker;
+        unsigned lastWorker;
+        uint64_t framesRemaining;
+        Clock::time_point submitted;
+        InstanceStats stats;
+    };
+
+    void Schedule(Slot& instance);
+    void RunFrame(Slot& instance);
+
+    JobScheduler& scheduler;
+    std::vector<std::unique_ptr<Slot>> instances;
+    double seconds;
+};
+
+} // nes
@@ -0,0 +1,94 @@
+#include "inputscript.h"
+#include "controller.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace nes
+{
+
+static std::optional<uint8_t> ParseButtons(std::string const& text)
+{
+    if (text == "-")
+        return 0;
+
+    static constexpr struct { char const* name; uint8_t mask; } names[] = {
+        { "A", Controller::A },
+        { "B", Controller::B },
+        { "Select", Controller::Select },
+        { "Start", Controller::Start },
+        { "Up", Controller::Up },
+        { "Down", Controller::Down },
+        { "Left", Controller::Left },
+        { "Right", Controller::Right },
+    };
+
+    uint8_t buttons = 0;
+    std::stringstream stream(text);
+    std::string name;
+    while (std::getline(stream, name, '+'))
+    {
+        auto found = std::find_if(std::begin(names), std::end(names), [&name](auto const& n) { return name == n.name; });
+        if (found == std::end(names))
+            return std::nullopt;
+        buttons |= found->mask;
+    }
+
+    return buttons;
+}
+
+std::array<uint8_t, 2> InputScript::At(uint64_t frame) const
+{
+    // Last entry at or before this frame
+    auto next = std::upper_bound(entries.begin(), entries.end(), frame, [](uint64_t f, Entry const& e) { return f < e.frame; });
+    if (next == entries.begin())
+        return { 0, 0 };
+
+    return std::prev(next)->pads;
+}
+
+std::optional<InputScript> InputScript::Parse(std::istream& stream)
+{
+    InputScript script;
+    std::string line;
+
+    while (std::getline(stream, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::stringstream fields(line);
+
+        uint64_t frame;
+        std::string pad1, pad2 = "-";
+        if (!(fields >> frame))
+        {
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+            return std::nullopt;
+        }
+
+        if (!(fields >> pad1))
+            return std::nullopt;
+        fields >> pad2;
+
+        auto buttons1 = ParseButtons(pad1);
+        auto buttons2 = ParseButtons(pad2);
+        if (!buttons1 || !buttons2)
+            return std::nullopt;
+
+        script.entries.push_back({ frame, { *buttons1, *buttons2 } });
+    }
+
+    std::stable_sort(script.entries.begin(), script.entries.end(), [](Entry const& a, Entry const& b) { return a.frame < b.frame; });
+    return script;
+}
+
+std::optional<InputScript> InputScript::Load(std::string const& filename)
+{
+    std::ifstream stream(filename);
+    if (!stream)
+        return std::nullopt;
+
+    return Parse(stream);
+}
+
+} // nes
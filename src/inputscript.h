@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nes
+{
+
+// Scripted pad input for headless runs. One line per change, buttons hold
+// until the next line that mentions a later frame:
+//
+//   # frame  pad1        [pad2]
+//   0        -
+//   60       Start
+//   62       -
+//   120      Right+A     B
+//
+// Buttons are A B Select Start Up Down Left Right joined with +, "-" for none.
+struct InputScript
+{
+    struct Entry
+    {
+        uint64_t frame;
+        std::array<uint8_t, 2> pads;
+    };
+
+    std::vector<Entry> entries; // Sorted by frame
+
+    std::array<uint8_t, 2> At(uint64_t frame) const;
+
+    static std::optional<InputScript> Parse(std::istream& stream);
+    static std::optional<InputScript> Load(std::string const& filename);
+};
+
+} // nes
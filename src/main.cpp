@@ -1,72 +1,62 @@
 #include <stdint.h>
-#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
 #include <string>
-#include <vector>
-#include <algorithm>
-#include "cpumemory.h"
-#include "cpu.h"
-
-struct Header
-{
-    char Magic[4];
-    uint8_t ProgRomCount;
-    uint8_t ChrRomCount;
-    uint8_t Flags6;
-    uint8_t Flags7;
-    uint8_t Flags8;
-    uint8_t Flags9;
-    uint8_t Flags10;
-    uint8_t Padding[5];
-};
-
-static_assert(sizeof(Header) == 16, "Header should be 16 bytes!");
-constexpr size_t ProgRomBankSize = 16 * 1024;
-constexpr size_t ChrRomBankSize = 8 * 1024;
+#include "cartridge.h"
+#include "console.h"
+#include "framepipeline.h"
 
+// NES rom.nes [frames]
+// Runs in real time with emulation and presentation on their own threads. Nothing
+// to present to yet, so it just reports how the frames were paced.
 int main(int argc, char *argv[])
 {
 //    uint8_t low = 0xFF;
 //    uint8_t high = 0x01;
-    
+
     //uint16_t word = high << 8 | low; // Widening happens here.
-    
-    std::vector<uint8_t> ram(0x2000);
-    ram.reserve(0x2000);
-    std::fill(ram.begin(), ram.end(), 0xEA );
-    
-    nes::CPUMemory memoryMap(ram);
-    nes::CPU cpu(&memoryMap);
-    
-    /*auto cycles =*/ cpu.Step();
-    
-    if (argc < 1)
+
+    if (argc < 2)
         return 1;
-    
+
     auto filename = std::string(argv[1]);
-    auto fileStream = std::ifstream(filename, std::ifstream::binary);
-    
-    Header header = {};
-    fileStream.read(reinterpret_cast<char *>(&header), sizeof(header));
-    
-    size_t romSize = header.ProgRomCount * ProgRomBankSize;
-    auto rom = std::vector<uint8_t>(romSize);
-    size_t vromSize = header.ChrRomCount * ChrRomBankSize;
-    auto vrom = std::vector<uint8_t>(vromSize);
-    
-    size_t readCount = 0;
-    readCount = fileStream.read(reinterpret_cast<char *>(rom.data()), romSize).gcount();
-    readCount = fileStream.read(reinterpret_cast<char *>(vrom.data()), vromSize).gcount();
-    
-    // Some temp code to  check if we've read everything!
-    if (!fileStream.eof())
+    auto cartridge = nes::Cartridge::Load(filename);
+    if (!cartridge)
     {
-        printf("Didn't get to EOF while reading %s\n", filename.c_str());
-        char buff[1024];
-        readCount = fileStream.read(buff, 1024).gcount();
-        auto isEofNow = fileStream.eof();
-        printf("After reading %zd bytes, eof is now %s", readCount, isEofNow ? "true" : "false");
+        printf("Couldn't load %s, is it an iNES ROM?\n", filename.c_str());
+        return 1;
     }
-    
+    if (auto const reason = cartridge->Unsupported())
+    {
+        printf("Can't run %s, %s\n", filename.c_str(), reason);
+        return 1;
+    }
+
+    printf("%s: %zu KB PRG, %zu KB CHR, mapper %d\n", filename.c_str(),
+           cartridge->prgRom.size() / 1024, cartridge->chrRom.size() / 1024, cartridge->Mapper());
+
+    nes::Console console(std::make_shared<nes::Cartridge const>(std::move(*cartridge)));
+    console.Reset();
+
+    nes::FramePacingOptions options;
+    options.frames = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+    // The console only ever gets touched from the emulation thread
+    auto produce = [&console](nes::VideoFrame& frame) {
+        console.RunFrame();
+        frame.pixels = console.ppu.frame;
+    };
+    nes::FramePipeline pipeline(produce, [](nes::VideoFrame const&) {}, options);
+    pipeline.Start();
+    pipeline.Wait();
+
+    auto const stats = pipeline.Stats();
+    printf("%llu frames, %llu presented, %llu dropped, %llu duplicated, %llu late, jitter mean %.1fus max %.1fus\n",
+           static_cast<unsigned long long>(stats.produced), static_cast<unsigned long long>(stats.presented),
+           static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.duplicated),
+           static_cast<unsigned long long>(stats.late), stats.meanJitterMicroseconds, stats.maxJitterMicroseconds);
+
 //    if (int a = 0; a == 0)
 //    {
 //        printf("YES!\n");
@@ -75,4 +65,3 @@ int main(int argc, char *argv[])
 //    auto [one, two, three] = std::make_tuple(1, "two", 3.0f);
     return 0;
 }
-
@@ -10,6 +10,14 @@ public:
     virtual ~Memory() = default;
     virtual uint8_t Read(uint16_t address) = 0;
     virtual void Write(uint16_t address, uint8_t value) = 0;
+
+    // Opcode fetches. Same as a read unless the bus wants to tell them apart.
+    virtual uint8_t Fetch(uint16_t address) { return Read(address); }
+
+    // For debuggers and tracers looking at memory, not part of the program. No side
+    // effects, not counted, no watchpoints. Same as a read unless the bus has any of
+    // those to skip.
+    virtual uint8_t Peek(uint16_t address) { return Read(address); }
 };
 
 }
\ No newline at end of file
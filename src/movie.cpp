@@ -0,0 +1,200 @@
+#include "movie.h"
+#include "hash.h"
+#include "zones.h"
+#include <algorithm>
+#include <fstream>
+#include <span>
+#include <type_traits>
+
+namespace nes
+{
+
+constexpr char MovieMagic[4] = { 'N', 'E', 'S', 'M' };
+constexpr uint32_t MovieVersion = 2;
+
+// Everything goes out as raw little endian PODs, same as the iNES header comes in.
+template<typename T>
+static void WriteValue(std::ostream& stream, T const& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    stream.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool ReadValue(std::istream& stream, T& value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool Movie::Save(std::string const& filename) const
+{
+    std::ofstream stream(filename, std::ofstream::binary);
+    if (!stream)
+        return false;
+
+    stream.write(MovieMagic, sizeof(MovieMagic));
+    WriteValue(stream, MovieVersion);
+    WriteValue(stream, static_cast<uint32_t>(sizeof(ConsoleState)));
+    WriteValue(stream, romHash);
+    WriteValue(stream, checkpointInterval);
+    WriteValue(stream, static_cast<uint64_t>(inputs.size()));
+
+    for (size_t i = 0; i < inputs.size();)
+    {
+        uint32_t run = 1;
+        while (i + run < inputs.size() && inputs[i + run] == inputs[i] && run < UINT32_MAX)
+            run++;
+
+        WriteValue(stream, run);
+        WriteValue(stream, inputs[i]);
+        i += run;
+    }
+
+    stream.write(reinterpret_cast<char const*>(hashes.data()), hashes.size() * sizeof(uint64_t));
+
+    WriteValue(stream, static_cast<uint32_t>(checkpoints.size()));
+    for (auto const& checkpoint : checkpoints)
+        WriteValue(stream, checkpoint);
+
+    return static_cast<bool>(stream);
+}
+
+std::optional<Movie> Movie::Load(std::string const& filename)
+{
+    std::ifstream stream(filename, std::ifstream::binary);
+    char magic[4];
+    uint32_t version, stateSize;
+    uint64_t frameCount;
+    Movie movie;
+
+    if (!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, MovieMagic))
+        return std::nullopt;
+
+    // Checkpoints are raw ConsoleStates, so any change to the layout makes old files useless.
+    if (!ReadValue(stream, version) || version != MovieVersion || !ReadValue(stream, stateSize) || stateSize != sizeof(ConsoleState))
+        return std::nullopt;
+
+    if (!ReadValue(stream, movie.romHash) || !ReadValue(stream, movie.checkpointInterval) || !ReadValue(stream, frameCount))
+        return std::nullopt;
+
+    while (movie.inputs.size() < frameCount)
+    {
+        uint32_t run;
+        std::array<uint8_t, 2> pads;
+        if (!ReadValue(stream, run) || !ReadValue(stream, pads) || run == 0 || run > frameCount - movie.inputs.size())
+            return std::nullopt;
+
+        movie.inputs.insert(movie.inputs.end(), run, pads);
+    }
+
+    movie.hashes.resize(frameCount);
+    if (!stream.read(reinterpret_cast<char*>(movie.hashes.data()), frameCount * sizeof(uint64_t)))
+        return std::nullopt;
+
+    // Segments run from each checkpoint to the next, so they have to start at frame 0,
+    // go forwards and each cover at least one frame, or verifying would skip frames.
+    uint32_t checkpointCount;
+    if (!ReadValue(stream, checkpointCount) || checkpointCount == 0)
+        return std::nullopt;
+
+    movie.checkpoints.resize(checkpointCount);
+    for (size_t i = 0; i < checkpointCount; i++)
+    {
+        auto& checkpoint = movie.checkpoints[i];
+        if (!ReadValue(stream, checkpoint) || checkpoint.frame >= frameCount)
+            return std::nullopt;
+        if (i == 0 ? checkpoint.frame != 0 : checkpoint.frame <= movie.checkpoints[i - 1].frame)
+            return std::nullopt;
+    }
+
+    return movie;
+}
+
+// Console::Hash leaves the picture out, but a movie should catch the picture going
+// wrong too, so it goes in on frames that were drawn.
+static uint64_t FrameHash(Console const& console, uint64_t hash)
+{
+    hash = console.Hash(hash);
+    if (!console.ppu.render)
+        return hash;
+
+    std::span<uint8_t const> const pixels(reinterpret_cast<uint8_t const*>(console.ppu.frame.data()), sizeof(console.ppu.frame));
+    return Hash64(pixels, hash);
+}
+
+MovieRecorder::MovieRecorder(Console& console, uint32_t checkpointInterval) : console(console), hash(0)
+{
+    if (console.cartridge)
+        movie.romHash = console.cartridge->Hash();
+    movie.checkpointInterval = std::max(1u, checkpointInterval);
+}
+
+void MovieRecorder::RunFrame(std::array<uint8_t, 2> pads)
+{
+    auto const frame = movie.inputs.size();
+    if (frame % movie.checkpointInterval == 0)
+    {
+        auto& checkpoint = movie.checkpoints.emplace_back();
+        checkpoint.frame = frame;
+        checkpoint.hash = hash;
+        console.Save(checkpoint.state);
+    }
+
+    console.memory.controllers[0].buttons = pads[0];
+    console.memory.controllers[1].buttons = pads[1];
+    console.RunFrame();
+    hash = FrameHash(console, hash);
+
+    movie.inputs.push_back(pads);
+    movie.hashes.push_back(hash);
+}
+
+std::optional<uint64_t> VerifySegment(Console& console, Movie const& movie, size_t checkpoint)
+{
+    NES_ZONE("verify");
+    auto const& start = movie.checkpoints[checkpoint];
+    auto const end = checkpoint + 1 < movie.checkpoints.size() ? movie.checkpoints[checkpoint + 1].frame : movie.inputs.size();
+
+    console.Load(start.state);
+    uint64_t hash = start.hash;
+
+    for (auto frame = start.frame; frame < end; frame++)
+    {
+        console.memory.controllers[0].buttons = movie.inputs[frame][0];
+        console.memory.controllers[1].buttons = movie.inputs[frame][1];
+        console.RunFrame();
+        hash = FrameHash(console, hash);
+
+        if (hash != movie.hashes[frame])
+            return frame;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<uint64_t> VerifyMovie(Movie const& movie, std::shared_ptr<Cartridge const> cartridge, JobScheduler& scheduler)
+{
+    // Each segment only needs its own checkpoint, so they're all independent.
+    std::vector<std::optional<uint64_t>> results(movie.checkpoints.size());
+
+    for (size_t i = 0; i < movie.checkpoints.size(); i++)
+    {
+        scheduler.Submit([&, i] {
+            Console console(cartridge);
+            results[i] = VerifySegment(console, movie, i);
+        });
+    }
+
+    scheduler.Wait();
+
+    for (auto const& result : results)
+    {
+        if (result)
+            return result;
+    }
+
+    return std::nullopt;
+}
+
+} // nes
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "cartridge.h"
+#include "console.h"
+#include "scheduler.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace nes
+{
+
+// Snapshot a movie can restart from. frame is the movie frame it comes before and
+// hash is the rolling hash up to that point.
+struct MovieCheckpoint
+{
+    uint64_t frame;
+    uint64_t hash;
+    ConsoleState state;
+};
+
+// Pad input for every frame plus the rolling hash after every frame, of RAM, registers
+// and PPU state, and the picture on frames that get drawn. So a movie only verifies
+// with the renderEvery it was recorded with.
+// Input is run length encoded on disk, it hardly ever changes frame to frame.
+// The first checkpoint is always the state the recording started from.
+struct Movie
+{
+    uint64_t romHash = 0;
+    uint32_t checkpointInterval = 0;
+    std::vector<std::array<uint8_t, 2>> inputs;
+    std::vector<uint64_t> hashes;
+    std::vector<MovieCheckpoint> checkpoints;
+
+    bool Save(std::string const& filename) const;
+    static std::optional<Movie> Load(std::string const& filename);
+};
+
+class MovieRecorder
+{
+public:
+    // Records from whatever state the console is in now.
+    MovieRecorder(Console& console, uint32_t checkpointInterval = 600);
+
+    void RunFrame(std::array<uint8_t, 2> pads);
+
+    Movie const& Recording() const { return movie; }
+
+private:
+    Console& console;
+    Movie movie;
+    uint64_t hash;
+};
+
+// Replays from one checkpoint up to the next and returns the first movie frame whose
+// hash doesn't match, if there is one.
+std::optional<uint64_t> VerifySegment(Console& console, Movie const& movie, size_t checkpoint);
+
+// Same thing for every segment at once, each on its own console on the scheduler.
+// Returns the earliest mismatch in the whole movie.
+std::optional<uint64_t> VerifyMovie(Movie const& movie, std::shared_ptr<Cartridge const> cartridge, JobScheduler& scheduler);
+
+} // nes
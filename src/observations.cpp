@@ -0,0 +1,214 @@
+#include "observations.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NES_SHM 1
+#endif
+
+namespace nes
+{
+
+// Sequence a slot ends up with once the index'th publish is written into it.
+static uint64_t Finished(uint64_t index)
+{
+    return 2 * (index + 1);
+}
+
+// A live emulator gets a publish done in well under this many yields, a dead one
+// never does.
+static constexpr int MaxRetries = 1 << 16;
+
+std::unique_ptr<ObservationExport> ObservationExport::Create(std::string const& name, uint32_t slots)
+{
+#if NES_SHM
+    if (slots == 0)
+        return nullptr;
+
+    size_t const bytes = sizeof(ObservationHeader) + size_t { slots } * sizeof(ObservationSlot);
+    // Only ever a new one. Taking over a name means readers of whatever had it before
+    // could see our slots being laid out under them.
+    int const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return nullptr;
+
+    bool const sized = ::ftruncate(fd, static_cast<off_t>(bytes)) == 0;
+    void* mapping = sized ? ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    return std::unique_ptr<ObservationExport>(new ObservationExport(name, mapping, bytes));
+#else
+    (void)name;
+    (void)slots;
+    return nullptr;
+#endif
+}
+
+ObservationExport::ObservationExport(std::string name, void* mapping, size_t bytes)
+    : name(std::move(name)), mapping(mapping), bytes(bytes)
+{
+    auto* base = static_cast<uint8_t*>(mapping);
+    uint32_t const count = static_cast<uint32_t>((bytes - sizeof(ObservationHeader)) / sizeof(ObservationSlot));
+
+    slots = reinterpret_cast<ObservationSlot*>(base + sizeof(ObservationHeader));
+    for (uint32_t i = 0; i < count; i++)
+        new (&slots[i]) ObservationSlot();
+
+    header = new (base) ObservationHeader();
+    header->version = ObservationVersion;
+    header->slotCount = count;
+    header->slotBytes = sizeof(ObservationSlot);
+    header->frameWidth = FrameWidth;
+    header->frameHeight = FrameHeight;
+    header->ramBytes = sizeof(Observation::ram);
+    header->magic.store(ObservationMagic, std::memory_order_release);
+}
+
+ObservationExport::~ObservationExport()
+{
+#if NES_SHM
+    ::munmap(mapping, bytes);
+    ::shm_unlink(name.c_str());
+#endif
+}
+
+void ObservationExport::Publish(uint64_t frame, std::span<uint8_t const> ram, std::span<Pixel const> pixels)
+{
+    auto const index = next++;
+    auto& slot = slots[index % header->slotCount];
+
+    // Odd first, and nothing below gets to move above it
+    slot.sequence.store(Finished(index) - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto& observation = slot.observation;
+    observation.frame = frame;
+    std::memcpy(observation.ram.data(), ram.data(), std::min(ram.size(), observation.ram.size()));
+    if (!pixels.empty())
+        std::memcpy(observation.pixels.data(), pixels.data(), std::min(pixels.size(), observation.pixels.size()) * sizeof(Pixel));
+
+    slot.sequence.store(Finished(index), std::memory_order_release);
+    header->published.store(index + 1, std::memory_order_release);
+}
+
+uint64_t ObservationExport::Published() const
+{
+    return header->published.load(std::memory_order_relaxed);
+}
+
+std::unique_ptr<ObservationReader> ObservationReader::Open(std::string const& name)
+{
+#if NES_SHM
+    int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info;
+    bool const big = ::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ObservationHeader);
+    size_t const bytes = big ? static_cast<size_t>(info.st_size) : 0;
+    void* mapping = big ? ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    // Magic first, nothing else is there until it is
+    std::unique_ptr<ObservationReader> reader(new ObservationReader(mapping, bytes));
+    auto const& header = *reader->header;
+    if (header.magic.load(std::memory_order_acquire) != ObservationMagic)
+        return nullptr;
+
+    bool const matches = header.version == ObservationVersion &&
+                         header.slotBytes == sizeof(ObservationSlot) && header.frameWidth == FrameWidth &&
+                         header.frameHeight == FrameHeight && header.ramBytes == sizeof(Observation::ram) &&
+                         header.slotCount > 0 &&
+                         bytes >= sizeof(ObservationHeader) + size_t { header.slotCount } * sizeof(ObservationSlot);
+    return matches ? std::move(reader) : nullptr;
+#else
+    (void)name;
+    return nullptr;
+#endif
+}
+
+ObservationReader::ObservationReader(void* mapping, size_t bytes) : mapping(mapping), bytes(bytes)
+{
+    auto const* base = static_cast<uint8_t const*>(mapping);
+    header = reinterpret_cast<ObservationHeader const*>(base);
+    slots = reinterpret_cast<ObservationSlot const*>(base + sizeof(ObservationHeader));
+}
+
+ObservationReader::~ObservationReader()
+{
+#if NES_SHM
+    ::munmap(mapping, bytes);
+#endif
+}
+
+uint64_t ObservationReader::Published() const
+{
+    return header->published.load(std::memory_order_acquire);
+}
+
+ObservationSlot const* ObservationReader::Newest(uint64_t& sequence) const
+{
+    for (int retry = 0; retry < MaxRetries; retry++)
+    {
+        auto const published = Published();
+        if (published == 0)
+            return nullptr;
+
+        auto const& slot = slots[(published - 1) % header->slotCount];
+        sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence == Finished(published - 1))
+            return &slot;
+
+        // Already being written over by a later lap, the newer frame will be there
+        // in a moment
+        std::this_thread::yield();
+    }
+    return nullptr;
+}
+
+bool ObservationReader::Unchanged(ObservationSlot const& slot, uint64_t sequence)
+{
+    // Keeps the reads of the slot from sinking below the second look at sequence
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool ObservationReader::Read(uint64_t index, Observation& out) const
+{
+    auto const& slot = slots[index % header->slotCount];
+    auto const sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != Finished(index))
+        return false;
+
+    std::memcpy(&out, &slot.observation, sizeof(Observation));
+    return Unchanged(slot, sequence);
+}
+
+bool ObservationReader::ReadNewest(Observation& out) const
+{
+    for (int retry = 0; retry < MaxRetries; retry++)
+    {
+        auto const published = Published();
+        if (published == 0)
+            return false;
+        if (Read(published - 1, out))
+            return true;
+        std::this_thread::yield();
+    }
+    return false;
+}
+
+} // nes
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "frame.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace nes
+{
+
+constexpr uint32_t ObservationMagic = 0x4F53454E; // "NESO"
+constexpr uint32_t ObservationVersion = 1;
+
+// What a consumer gets each frame. Plain bytes, the same in every process that maps
+// it, so no pointers and nothing that needs constructing.
+struct Observation
+{
+    uint64_t frame; // The console's frame counter, which goes backwards when a snapshot loads
+    std::array<uint8_t, 0x800> ram;
+    FrameBuffer pixels;
+};
+
+// One entry of the ring. sequence is odd while the emulator is writing it and even
+// once it's done. A reader takes sequence, reads, and checks sequence didn't move;
+// if it did, the emulator came round the ring and wrote over it meanwhile and the
+// read goes again.
+//
+// Slots are numbered by publish, not by the console's frame counter, so loading a
+// snapshot doesn't upset anything. The index'th publish goes in slot
+// index % slotCount and ends with sequence 2 * (index + 1).
+struct alignas(64) ObservationSlot
+{
+    std::atomic<uint64_t> sequence;
+    alignas(64) Observation observation;
+};
+
+// Start of the shared memory, the slots follow it. magic is written last, so a
+// consumer that sees it can trust the rest, and then checks the layout fields
+// against what it was built with.
+struct alignas(64) ObservationHeader
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    uint32_t frameWidth;
+    uint32_t frameHeight;
+    uint32_t ramBytes;
+    alignas(64) std::atomic<uint64_t> published; // Publishes finished so far, the newest is index published - 1
+};
+
+// Shared between processes, so they have to really be lock free, not a mutex
+// that only exists in this one.
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+
+// The emulator's end. Makes a POSIX shared memory object of slots observations and
+// writes each frame into the next one round. Never waits for readers, a reader that
+// falls more than slots behind just loses frames. The name is removed again when
+// this goes, anyone who already has it mapped keeps it.
+class ObservationExport
+{
+public:
+    // name is a shm_open name, "/something". Null if it couldn't be made, including
+    // when something else already has the name.
+    static std::unique_ptr<ObservationExport> Create(std::string const& name, uint32_t slots = 4);
+
+    ~ObservationExport();
+    ObservationExport(ObservationExport const&) = delete;
+    ObservationExport& operator=(ObservationExport const&) = delete;
+
+    // ram is the 2KB behind CPUMemory. Empty pixels leaves whatever picture the slot
+    // had from slotCount publishes ago, so only for when nobody wants pictures. One
+    // thread at a time.
+    void Publish(uint64_t frame, std::span<uint8_t const> ram, std::span<Pixel const> pixels);
+
+    std::string const& Name() const { return name; }
+    uint64_t Published() const;
+
+private:
+    ObservationExport(std::string name, void* mapping, size_t bytes);
+
+    std::string name;
+    void* mapping;
+    size_t bytes;
+    ObservationHeader* header;
+    ObservationSlot* slots;
+    uint64_t next = 0;
+};
+
+// The consumer's end, maps an existing export read only.
+class ObservationReader
+{
+public:
+    // Null if it's not there or it isn't laid out the way we expect.
+    static std::unique_ptr<ObservationReader> Open(std::string const& name);
+
+    ~ObservationReader();
+    ObservationReader(ObservationReader const&) = delete;
+    ObservationReader& operator=(ObservationReader const&) = delete;
+
+    uint32_t SlotCount() const { return header->slotCount; }
+    uint64_t Published() const;
+
+    // Zero copy. The newest finished slot, or null if there isn't one yet, and the
+    // sequence to hand to Unchanged once you're done looking at it. If Unchanged says
+    // no, whatever you read was torn and needs throwing away. Also null if the
+    // newest slot stays half written, as it does when the emulator died mid publish.
+    ObservationSlot const* Newest(uint64_t& sequence) const;
+    static bool Unchanged(ObservationSlot const& slot, uint64_t sequence);
+
+    // Copies the newest frame out whole, retrying until it gets a clean one. False if
+    // nothing's been published yet, or if it never gets a clean one.
+    bool ReadNewest(Observation& out) const;
+
+    // Copies out a particular publish, counting from 0. False if it isn't published
+    // yet or has already been written over.
+    bool Read(uint64_t index, Observation& out) const;
+
+private:
+    ObservationReader(void* mapping, size_t bytes);
+
+    void* mapping;
+    size_t bytes;
+    ObservationHeader const* header;
+    ObservationSlot const* slots;
+};
+
+} // nes
@@ -0,0 +1,239 @@
+#include "palette.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace nes
+{
+
+// 2C02, as the nesdev wiki has it
+static constexpr uint32_t DefaultColors[64] = {
+    0x666666, 0x002A88, 0x1412A7, 0x3B00A4, 0x5C007E, 0x6E0040, 0x6C0600, 0x561D00,
+    0x333500, 0x0B4800, 0x005200, 0x004F08, 0x00404D, 0x000000, 0x000000, 0x000000,
+    0xADADAD, 0x155FD9, 0x4240FF, 0x7527FE, 0xA01ACC, 0xB71E7B, 0xB53120, 0x994E00,
+    0x6B6D00, 0x388700, 0x0C9300, 0x008F32, 0x007C8D, 0x000000, 0x000000, 0x000000,
+    0xFFFEFF, 0x64B0FF, 0x9290FF, 0xC676FF, 0xF36AFF, 0xFE6ECC, 0xFE8170, 0xEA9E22,
+    0xBCBE00, 0x88D800, 0x5CE430, 0x45E082, 0x48CDDE, 0x4F4F4F, 0x000000, 0x000000,
+    0xFFFEFF, 0xC0DFFF, 0xD3D2FF, 0xE8C8FF, 0xFBC2FF, 0xFEC4EA, 0xFECCC5, 0xF7D8A5,
+    0xE4E594, 0xCFEF96, 0xBDF4AB, 0xB3F3CC, 0xB5EBF2, 0xB8B8B8, 0x000000, 0x000000,
+};
+
+static uint32_t Encode(uint32_t rgb, PixelFormat format)
+{
+    uint32_t const r = (rgb >> 16) & 0xFF;
+    uint32_t const g = (rgb >> 8) & 0xFF;
+    uint32_t const b = rgb & 0xFF;
+
+    switch (format)
+    {
+    case PixelFormat::RGBA8888:
+        return 0xFF000000 | b << 16 | g << 8 | r;
+    case PixelFormat::BGRA8888:
+        return 0xFF000000 | r << 16 | g << 8 | b;
+    case PixelFormat::RGB565:
+        return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+    case PixelFormat::Gray8:
+        return (77 * r + 150 * g + 29 * b) >> 8; // BT.601
+    }
+    return 0;
+}
+
+// Row by row, so odd widths and padded strides work. The SIMD loop does as many
+// whole blocks as fit and this does the rest.
+template<size_t Bytes>
+static void ConvertRowScalar(Pixel const* pixels, unsigned count, uint32_t const* lut, uint8_t* out)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        uint32_t const value = lut[pixels[i] & PixelMask];
+        if constexpr (Bytes == 4)
+            std::memcpy(out + i * 4, &value, 4);
+        else if constexpr (Bytes == 2)
+        {
+            auto const half = static_cast<uint16_t>(value);
+            std::memcpy(out + i * 2, &half, 2);
+        }
+        else
+            out[i] = static_cast<uint8_t>(value);
+    }
+}
+
+#if NES_AVX2
+
+__attribute__((target("avx2"))) static inline __m256i Gather8(Pixel const* pixels, uint32_t const* lut)
+{
+    auto const indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(pixels)));
+    auto const masked = _mm256_and_si256(indices, _mm256_set1_epi32(PixelMask));
+    return _mm256_i32gather_epi32(reinterpret_cast<int const*>(lut), masked, 4);
+}
+
+// Returns how many pixels it did, always a multiple of its block size.
+__attribute__((target("avx2"))) static unsigned ConvertRowAvx2(Pixel const* pixels, unsigned count,
+                                                               uint32_t const* lut, uint8_t* out, size_t bytes)
+{
+    unsigned i = 0;
+    if (bytes == 4)
+    {
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4), Gather8(pixels + i, lut));
+    }
+    else if (bytes == 2)
+    {
+        // Pack works within 128 bit lanes, so the quarters come out as 0 2 1 3
+        for (; i + 16 <= count; i += 16)
+        {
+            auto const packed = _mm256_packus_epi32(Gather8(pixels + i, lut), Gather8(pixels + i + 8, lut));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), _mm256_permute4x64_epi64(packed, 0xD8));
+        }
+    }
+    else
+    {
+        // Two packs, so groups of 4 pixels come out as 0 2 4 6 1 3 5 7
+        auto const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        for (; i + 32 <= count; i += 32)
+        {
+            auto const low = _mm256_packus_epi32(Gather8(pixels + i, lut), Gather8(pixels + i + 8, lut));
+            auto const high = _mm256_packus_epi32(Gather8(pixels + i + 16, lut), Gather8(pixels + i + 24, lut));
+            auto const bytes8 = _mm256_packus_epi16(low, high);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permutevar8x32_epi32(bytes8, order));
+        }
+    }
+    return i;
+}
+
+#endif
+
+static void Convert(std::span<Pixel const> pixels, unsigned width, PaletteLut const& lut, uint8_t* out, size_t stride,
+                    [[maybe_unused]] bool simd)
+{
+    if (width == 0)
+        return;
+
+    size_t const bytes = BytesPerPixel(lut.Format());
+    size_t const rows = pixels.size() / width;
+    for (size_t row = 0; row < rows; row++)
+    {
+        Pixel const* source = pixels.data() + row * width;
+        uint8_t* destination = out + row * stride;
+        unsigned done = 0;
+
+#if NES_AVX2
+        if (simd && HasAvx2())
+            done = ConvertRowAvx2(source, width, lut.Data(), destination, bytes);
+#endif
+
+        switch (bytes)
+        {
+        case 4: ConvertRowScalar<4>(source + done, width - done, lut.Data(), destination + done * 4); break;
+        case 2: ConvertRowScalar<2>(source + done, width - done, lut.Data(), destination + done * 2); break;
+        default: ConvertRowScalar<1>(source + done, width - done, lut.Data(), destination + done); break;
+        }
+    }
+}
+
+size_t BytesPerPixel(PixelFormat format)
+{
+    switch (format)
+    {
+    case PixelFormat::RGB565:
+        return 2;
+    case PixelFormat::Gray8:
+        return 1;
+    default:
+        return 4;
+    }
+}
+
+Palette Palette::Default()
+{
+    return FromBase(DefaultColors);
+}
+
+Palette Palette::FromBase(std::span<uint32_t const, 64> base)
+{
+    Palette palette {};
+    for (size_t emphasis = 0; emphasis < 8; emphasis++)
+    {
+        for (size_t index = 0; index < 64; index++)
+        {
+            // Each emphasis bit leaves its own channel alone and dims the other two
+            double scale[3] = { 1.0, 1.0, 1.0 }; // R, G, B
+            for (int bit = 0; bit < 3; bit++)
+            {
+                if (emphasis & (1 << bit))
+                {
+                    for (int channel = 0; channel < 3; channel++)
+                        scale[channel] *= channel == bit ? 1.0 : 0.816;
+                }
+            }
+
+            uint32_t const rgb = base[index];
+            uint32_t color = 0;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                int const shift = 16 - channel * 8;
+                auto const value = static_cast<uint32_t>(((rgb >> shift) & 0xFF) * scale[channel] + 0.5);
+                color |= std::min<uint32_t>(value, 0xFF) << shift;
+            }
+            palette.colors[emphasis << 6 | index] = color;
+        }
+    }
+    return palette;
+}
+
+std::optional<Palette> Palette::Load(std::string const& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+
+    std::vector<uint8_t> const bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    auto rgb = [&bytes](size_t i) {
+        return static_cast<uint32_t>(bytes[i * 3] << 16 | bytes[i * 3 + 1] << 8 | bytes[i * 3 + 2]);
+    };
+
+    if (bytes.size() == PaletteSize * 3)
+    {
+        Palette palette {};
+        for (size_t i = 0; i < PaletteSize; i++)
+            palette.colors[i] = rgb(i);
+        return palette;
+    }
+
+    if (bytes.size() == 64 * 3)
+    {
+        uint32_t base[64];
+        for (size_t i = 0; i < 64; i++)
+            base[i] = rgb(i);
+        return FromBase(base);
+    }
+
+    return std::nullopt;
+}
+
+PaletteLut::PaletteLut(Palette const& palette, PixelFormat format) : entries(), format(format)
+{
+    for (size_t i = 0; i < PaletteSize; i++)
+        entries[i] = Encode(palette.colors[i], format);
+}
+
+void ConvertPixels(std::span<Pixel const> pixels, unsigned width, PaletteLut const& lut, uint8_t* out, size_t stride)
+{
+    Convert(pixels, width, lut, out, stride, true);
+}
+
+void ConvertPixelsScalar(std::span<Pixel const> pixels, unsigned width, PaletteLut const& lut, uint8_t* out,
+                         size_t stride)
+{
+    Convert(pixels, width, lut, out, stride, false);
+}
+
+bool ConvertPixelsUsesAvx2()
+{
+    return HasAvx2();
+}
+
+} // nes
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "frame.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace nes
+{
+
+// Every index with every emphasis combination.
+constexpr size_t PaletteSize = 512;
+
+enum class PixelFormat
+{
+    RGBA8888, // Bytes R, G, B, A
+    BGRA8888, // Bytes B, G, R, A, what most windowing APIs want
+    RGB565,   // Native endian 16 bit
+    Gray8,    // Luma, for analysis rather than looking at
+};
+
+size_t BytesPerPixel(PixelFormat format);
+
+struct Palette
+{
+    std::array<uint32_t, PaletteSize> colors; // 0xRRGGBB by Pixel
+
+    // The usual 2C02 colours.
+    static Palette Default();
+
+    // A .pal file, 64 RGB triples, or 512 if it has its own emphasis colours.
+    static std::optional<Palette> Load(std::string const& filename);
+
+    // 64 colours in, emphasis worked out by dimming the channels that aren't
+    // emphasised. Close to what a real 2C02 does, not exact.
+    static Palette FromBase(std::span<uint32_t const, 64> base);
+};
+
+// Palette already in the output format, one entry per Pixel, so converting is one
+// lookup a pixel.
+class PaletteLut
+{
+public:
+    PaletteLut(Palette const& palette, PixelFormat format);
+
+    PixelFormat Format() const { return format; }
+    uint32_t operator[](Pixel pixel) const { return entries[pixel & PixelMask]; }
+    uint32_t const* Data() const { return entries.data(); }
+
+private:
+    alignas(64) std::array<uint32_t, PaletteSize> entries;
+    PixelFormat format;
+};
+
+// Rows of width pixels, back to back, into rows stride bytes apart in out. Uses
+// AVX2 gathers when the CPU has them.
+void ConvertPixels(std::span<Pixel const> pixels, unsigned width, PaletteLut const& lut, uint8_t* out, size_t stride);
+
+// Same thing a pixel at a time. The baseline, and what the SIMD path is tested against.
+void ConvertPixelsScalar(std::span<Pixel const> pixels, unsigned width, PaletteLut const& lut, uint8_t* out,
+                         size_t stride);
+
+// Whether ConvertPixels gets the AVX2 path on this machine.
+bool ConvertPixelsUsesAvx2();
+
+} // nes
@@ -0,0 +1,472 @@
+#include "ppu.h"
+#include <algorithm>
+
+namespace nes
+{
+
+// Palette RAM is 32 bytes, and the sprite backdrop entries are the background's.
+static uint8_t PaletteAddress(uint16_t address)
+{
+    address &= 0x1F;
+    if ((address & 0x13) == 0x10)
+        address &= ~0x10;
+    return static_cast<uint8_t>(address);
+}
+
+static uint8_t Reverse(uint8_t bits)
+{
+    bits = static_cast<uint8_t>((bits & 0xF0) >> 4 | (bits & 0x0F) << 4);
+    bits = static_cast<uint8_t>((bits & 0xCC) >> 2 | (bits & 0x33) << 2);
+    return static_cast<uint8_t>((bits & 0xAA) >> 1 | (bits & 0x55) << 1);
+}
+
+// https://www.nesdev.org/wiki/PPU_scrolling#Wrapping_around
+static uint16_t IncrementY(uint16_t v)
+{
+    if ((v & 0x7000) != 0x7000)
+        return v + 0x1000;
+
+    v &= ~0x7000;
+    uint16_t y = (v & 0x03E0) >> 5;
+    if (y == 29)
+    {
+        y = 0;
+        v ^= 0x0800;
+    }
+    else if (y == 31)
+    {
+        y = 0;
+    }
+    else
+    {
+        y++;
+    }
+    return static_cast<uint16_t>((v & ~0x03E0) | (y << 5));
+}
+
+PPU::PPU(uint64_t const& clock) : state(), frame(), clock(clock)
+{
+}
+
+void PPU::SetChrRom(std::span<uint8_t const> rom, bool verticalMirroring)
+{
+    // Carts without CHR ROM have 8K of RAM there instead
+    chrRom = rom.size() >= 0x2000 ? rom : std::span<uint8_t const>();
+    this->verticalMirroring = verticalMirroring;
+}
+
+void PPU::Reset()
+{
+    // Memory keeps whatever it had, like the real thing
+    state.v = state.t = 0;
+    state.fineX = state.writeToggle = 0;
+    state.ctrl = state.mask = state.status = 0;
+    state.oamAddress = state.readBuffer = state.openBus = 0;
+    state.nmi = 0;
+    nextLine = 0;
+    sprite0Dot = NoHit;
+}
+
+uint32_t PPU::Dot() const
+{
+    uint64_t const elapsed = clock > frameStart ? (clock - frameStart) * 3 : 0;
+    return static_cast<uint32_t>(std::min<uint64_t>(elapsed, LinesPerFrame * DotsPerLine));
+}
+
+void PPU::BeginFrame(uint64_t startCycle)
+{
+    frameStart = startCycle;
+    nextLine = 0;
+}
+
+void PPU::CatchUp()
+{
+    CatchUp(Dot());
+}
+
+void PPU::EndFrame()
+{
+    CatchUp(LinesPerFrame * DotsPerLine);
+}
+
+void PPU::CatchUp(uint32_t dot)
+{
+    while (nextLine < LinesPerFrame && nextLine * DotsPerLine <= dot)
+    {
+        if (sprite0Dot <= nextLine * DotsPerLine)
+        {
+            state.status |= 0x40;
+            sprite0Dot = NoHit;
+        }
+        RunLine(nextLine++);
+    }
+
+    if (sprite0Dot <= dot)
+    {
+        state.status |= 0x40;
+        sprite0Dot = NoHit;
+    }
+}
+
+void PPU::RunLine(uint32_t line)
+{
+    if (line < FrameHeight)
+    {
+        if (!RenderingEnabled())
+        {
+            if (render)
+            {
+                uint16_t const emphasis = static_cast<uint16_t>((state.mask & 0xE0) << 1);
+                uint8_t const grey = (state.mask & 0x01) ? 0x30 : 0x3F;
+                auto const backdrop = static_cast<Pixel>((state.palette[0] & grey) | emphasis);
+                std::fill_n(frame.begin() + line * FrameWidth, FrameWidth, backdrop);
+            }
+            return;
+        }
+
+        // Everything up to RenderLine happens whether anyone's looking or not
+        std::array<uint8_t, 8> sprites;
+        size_t const count = EvaluateSprites(line, sprites);
+        CheckSprite0(line);
+        if (render)
+            RenderLine(line, std::span<uint8_t const>(sprites.data(), count));
+
+        state.v = IncrementY(state.v);
+        state.v = static_cast<uint16_t>((state.v & ~0x041F) | (state.t & 0x041F));
+    }
+    else if (line == VblankLine)
+    {
+        state.status |= 0x80;
+        if (state.ctrl & 0x80)
+            state.nmi = 1;
+    }
+    else if (line == PreRenderLine)
+    {
+        state.status &= 0x1F;
+        sprite0Dot = NoHit;
+
+        // Horizontal and vertical copies together are all of t
+        if (RenderingEnabled())
+            state.v = state.t;
+    }
+}
+
+size_t PPU::EvaluateSprites(uint32_t line, std::array<uint8_t, 8>& sprites)
+{
+    // Sprites show up the line after their Y
+    int const height = (state.ctrl & 0x20) ? 16 : 8;
+    size_t count = 0;
+    for (unsigned i = 0; i < 64; i++)
+    {
+        int const row = static_cast<int>(line) - (state.oam[i * 4] + 1);
+        if (row < 0 || row >= height)
+            continue;
+
+        if (count == sprites.size())
+        {
+            // Without the hardware's diagonal search bug
+            state.status |= 0x20;
+            break;
+        }
+        sprites[count++] = static_cast<uint8_t>(i);
+    }
+    return count;
+}
+
+void PPU::CheckSprite0(uint32_t line)
+{
+    if ((state.mask & 0x18) != 0x18 || (state.status & 0x40) || sprite0Dot != NoHit)
+        return;
+
+    int const height = (state.ctrl & 0x20) ? 16 : 8;
+    int const row = static_cast<int>(line) - (state.oam[0] + 1);
+    if (row < 0 || row >= height)
+        return;
+
+    uint8_t high = 0;
+    uint8_t const low = SpritePattern(state.oam.data(), line, high);
+    uint8_t const opaque = low | high;
+    bool const clipped = (state.mask & 0x06) != 0x06;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        uint32_t const x = state.oam[3] + i;
+        if (x >= 255)
+            break; // Never hits on the last column
+        if ((x < 8 && clipped) || !(opaque & (0x80 >> i)))
+            continue;
+
+        if (BackgroundOpaque(x))
+        {
+            sprite0Dot = line * DotsPerLine + x + 1;
+            return;
+        }
+    }
+}
+
+bool PPU::BackgroundOpaque(uint32_t x) const
+{
+    uint32_t const pixel = state.fineX + x;
+    uint32_t coarseX = (state.v & 0x1F) + pixel / 8;
+    uint16_t nametable = state.v & 0x0C00;
+    if (coarseX >= 32)
+    {
+        coarseX -= 32;
+        nametable ^= 0x0400;
+    }
+
+    uint16_t const tile = Read(static_cast<uint16_t>(0x2000 | nametable | (state.v & 0x03E0) | coarseX));
+    uint16_t const address = static_cast<uint16_t>(((state.ctrl & 0x10) << 8) + tile * 16 + ((state.v >> 12) & 7));
+    return ((Pattern(address) | Pattern(address + 8)) << (pixel & 7)) & 0x80;
+}
+
+uint8_t PPU::SpritePattern(uint8_t const* sprite, uint32_t line, uint8_t& high) const
+{
+    int const height = (state.ctrl & 0x20) ? 16 : 8;
+    int row = static_cast<int>(line) - (sprite[0] + 1);
+    if (sprite[2] & 0x80)
+        row = height - 1 - row;
+
+    uint16_t address;
+    if (height == 16)
+    {
+        uint16_t const tile = static_cast<uint16_t>((sprite[1] & 0xFE) + (row >= 8 ? 1 : 0));
+        address = static_cast<uint16_t>(((sprite[1] & 0x01) << 12) + tile * 16 + (row & 7));
+    }
+    else
+    {
+        address = static_cast<uint16_t>(((state.ctrl & 0x08) << 9) + sprite[1] * 16 + row);
+    }
+
+    // Bit 7 is always the leftmost pixel once this is done
+    uint8_t low = Pattern(address);
+    high = Pattern(address + 8);
+    if (sprite[2] & 0x40)
+    {
+        low = Reverse(low);
+        high = Reverse(high);
+    }
+    return low;
+}
+
+void PPU::RenderLine(uint32_t line, std::span<uint8_t const> sprites)
+{
+    // Palette RAM offsets, 0 for transparent
+    std::array<uint8_t, FrameWidth + 8> background {};
+    if (state.mask & 0x08)
+    {
+        uint16_t const patterns = static_cast<uint16_t>((state.ctrl & 0x10) << 8);
+        uint16_t const fineY = (state.v >> 12) & 7;
+        uint16_t const coarseY = (state.v >> 5) & 0x1F;
+        uint16_t coarseX = state.v & 0x1F;
+        uint16_t nametable = state.v & 0x0C00;
+
+        // 33 tiles, the first one part off the left when fine X isn't 0
+        for (uint32_t tile = 0; tile < 33; tile++)
+        {
+            uint16_t const base = static_cast<uint16_t>(0x2000 | nametable);
+            uint16_t const index = Read(static_cast<uint16_t>(base | (coarseY << 5) | coarseX));
+            uint8_t const attribute = Read(static_cast<uint16_t>(base | 0x03C0 | ((coarseY >> 2) << 3) | (coarseX >> 2)));
+            uint8_t const palette = static_cast<uint8_t>(((attribute >> (((coarseY & 2) << 1) | (coarseX & 2))) & 3) << 2);
+
+            uint16_t const address = static_cast<uint16_t>(patterns + index * 16 + fineY);
+            uint8_t const low = Pattern(address);
+            uint8_t const high = Pattern(address + 8);
+            for (uint32_t bit = 0; bit < 8; bit++)
+            {
+                uint8_t const value = static_cast<uint8_t>(((low << bit) & 0x80) >> 7 | ((high << bit) & 0x80) >> 6);
+                background[tile * 8 + bit] = value ? (palette | value) : 0;
+            }
+
+            if (++coarseX == 32)
+            {
+                coarseX = 0;
+                nametable ^= 0x0400;
+            }
+        }
+    }
+
+    auto const* shown = background.data() + state.fineX;
+
+    // Sprite palette offsets, plus 0x20 when they go behind the background
+    std::array<uint8_t, FrameWidth> foreground {};
+    if (state.mask & 0x10)
+    {
+        for (auto index : sprites)
+        {
+            auto const* sprite = &state.oam[index * 4];
+            uint8_t high = 0;
+            uint8_t const low = SpritePattern(sprite, line, high);
+            uint8_t const attributes = static_cast<uint8_t>(0x10 | ((sprite[2] & 3) << 2) | ((sprite[2] & 0x20) ? 0x20 : 0));
+            for (uint32_t bit = 0; bit < 8; bit++)
+            {
+                uint32_t const x = sprite[3] + bit;
+                uint8_t const value = static_cast<uint8_t>(((low << bit) & 0x80) >> 7 | ((high << bit) & 0x80) >> 6);
+                // Lower numbered sprites win, and they were first
+                if (x < FrameWidth && value && !foreground[x])
+                    foreground[x] = attributes | value;
+            }
+        }
+    }
+
+    uint32_t const firstBackground = (state.mask & 0x02) ? 0 : 8;
+    uint32_t const firstSprite = (state.mask & 0x04) ? 0 : 8;
+    uint16_t const emphasis = static_cast<uint16_t>((state.mask & 0xE0) << 1);
+    uint8_t const grey = (state.mask & 0x01) ? 0x30 : 0x3F;
+    auto* out = frame.data() + line * FrameWidth;
+    for (uint32_t x = 0; x < FrameWidth; x++)
+    {
+        uint8_t color = x >= firstBackground ? shown[x] : 0;
+        uint8_t const sprite = x >= firstSprite ? foreground[x] : 0;
+        if (sprite && (!color || !(sprite & 0x20)))
+            color = sprite & 0x1F;
+        out[x] = static_cast<Pixel>((state.palette[color] & grey) | emphasis);
+    }
+}
+
+uint8_t PPU::Pattern(uint16_t address) const
+{
+    address &= 0x1FFF;
+    return chrRom.empty() ? state.chrRam[address] : chrRom[address];
+}
+
+uint16_t PPU::Mirror(uint16_t address) const
+{
+    uint16_t const table = (address >> 10) & 3;
+    uint16_t const physical = verticalMirroring ? (table & 1) : (table >> 1);
+    return static_cast<uint16_t>(physical * 0x400 + (address & 0x3FF));
+}
+
+uint8_t PPU::Read(uint16_t address) const
+{
+    address &= 0x3FFF;
+    if (address < 0x2000)
+        return Pattern(address);
+    if (address < 0x3F00)
+        return state.vram[Mirror(address)];
+    return state.palette[PaletteAddress(address)];
+}
+
+void PPU::Write(uint16_t address, uint8_t value)
+{
+    address &= 0x3FFF;
+    if (address < 0x2000)
+    {
+        if (chrRom.empty())
+            state.chrRam[address] = value;
+    }
+    else if (address < 0x3F00)
+    {
+        state.vram[Mirror(address)] = value;
+    }
+    else
+    {
+        state.palette[PaletteAddress(address)] = value & 0x3F;
+    }
+}
+
+uint8_t PPU::ReadRegister(uint16_t address)
+{
+    CatchUp();
+
+    uint8_t value = state.openBus;
+    switch (address & 7)
+    {
+        case 2:
+            value = static_cast<uint8_t>((state.status & 0xE0) | (state.openBus & 0x1F));
+            state.status &= ~0x80;
+            state.writeToggle = 0;
+            break;
+
+        case 4:
+            value = state.oam[state.oamAddress];
+            break;
+
+        case 7:
+        {
+            uint16_t const vramAddress = state.v & 0x3FFF;
+            if (vramAddress >= 0x3F00)
+            {
+                // Palette comes straight back, the buffer gets the nametable underneath
+                value = Read(vramAddress);
+                state.readBuffer = Read(vramAddress - 0x1000);
+            }
+            else
+            {
+                value = state.readBuffer;
+                state.readBuffer = Read(vramAddress);
+            }
+            state.v = static_cast<uint16_t>((state.v + ((state.ctrl & 0x04) ? 32 : 1)) & 0x7FFF);
+            break;
+        }
+    }
+
+    state.openBus = value;
+    return value;
+}
+
+void PPU::WriteRegister(uint16_t address, uint8_t value)
+{
+    CatchUp();
+
+    state.openBus = value;
+    switch (address & 7)
+    {
+        case 0:
+            // Turning NMIs on part way through vblank gets one straight away
+            if (!(state.ctrl & 0x80) && (value & 0x80) && (state.status & 0x80))
+                state.nmi = 1;
+            state.ctrl = value;
+            state.t = static_cast<uint16_t>((state.t & ~0x0C00) | ((value & 0x03) << 10));
+            break;
+
+        case 1:
+            state.mask = value;
+            break;
+
+        case 3:
+            state.oamAddress = value;
+            break;
+
+        case 4:
+            state.oam[state.oamAddress++] = value;
+            break;
+
+        case 5:
+            if (!state.writeToggle)
+            {
+                state.t = static_cast<uint16_t>((state.t & ~0x001F) | (value >> 3));
+                state.fineX = value & 7;
+            }
+            else
+            {
+                state.t = static_cast<uint16_t>((state.t & ~0x73E0) | ((value & 0x07) << 12) | ((value & 0xF8) << 2));
+            }
+            state.writeToggle ^= 1;
+            break;
+
+        case 6:
+            if (!state.writeToggle)
+            {
+                state.t = static_cast<uint16_t>((state.t & 0x00FF) | ((value & 0x3F) << 8));
+            }
+            else
+            {
+                state.t = static_cast<uint16_t>((state.t & 0xFF00) | value);
+                state.v = state.t;
+            }
+            state.writeToggle ^= 1;
+            break;
+
+        case 7:
+            Write(state.v, value);
+            state.v = static_cast<uint16_t>((state.v + ((state.ctrl & 0x04) ? 32 : 1)) & 0x7FFF);
+            break;
+    }
+}
+
+void PPU::WriteOam(uint8_t value)
+{
+    state.oam[state.oamAddress++] = value;
+}
+
+} // nes
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "frame.h"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace nes
+{
+
+constexpr uint32_t DotsPerLine = 341;
+constexpr uint32_t LinesPerFrame = 262;
+constexpr uint32_t VblankLine = 241;
+constexpr uint32_t PreRenderLine = 261;
+
+// Everything in the PPU that changes and that the CPU can find out about one way or
+// another. Flat and padding free so it can go straight into a ConsoleState and be
+// hashed as bytes.
+struct PPUState
+{
+    std::array<uint8_t, 0x2000> chrRam; // Only used by carts without CHR ROM
+    std::array<uint8_t, 0x800> vram;    // Two nametables, mirrored into four
+    std::array<uint8_t, 0x100> oam;
+    std::array<uint8_t, 0x20> palette;
+    uint16_t v;  // Current VRAM address, loopy's v
+    uint16_t t;  // Temporary VRAM address, loopy's t
+    uint8_t fineX;
+    uint8_t writeToggle;
+    uint8_t ctrl;   // $2000
+    uint8_t mask;   // $2001
+    uint8_t status; // $2002, top three bits
+    uint8_t oamAddress;
+    uint8_t readBuffer; // $2007 reads come out one behind
+    uint8_t openBus;    // Last value written to any register
+    uint8_t nmi;        // Raised, for the CPU to take before its next instruction
+    uint8_t unused;
+};
+
+static_assert(std::has_unique_object_representations_v<PPUState>);
+
+// Scanline at a time PPU. The console's frame starts at visible line 0, vblank
+// starts on line 241 and line 261 sets up the next frame. Nothing runs on its own,
+// the PPU catches up to the CPU whenever the CPU touches a register and at the
+// vblank and frame boundaries, a whole line at a time as each line starts. So
+// register writes part way through a line show up from the next one, which is
+// the accuracy this buys.
+//
+// render switches off drawing into frame, which is most of the cost, and nothing
+// else. Scrolling, vblank, sprite 0 hit and sprite overflow all still happen the
+// same way, so the CPU and RAM end up exactly where they would have with it on.
+class PPU
+{
+public:
+    // clock is the CPU cycle count, where the PPU gets the time from.
+    explicit PPU(uint64_t const& clock);
+
+    void SetChrRom(std::span<uint8_t const> rom, bool verticalMirroring);
+    void Reset();
+
+    // $2000-$2007, address is only looked at for its low three bits.
+    uint8_t ReadRegister(uint16_t address);
+    void WriteRegister(uint16_t address, uint8_t value);
+
+    // OAM DMA, one byte at a time from wherever OAMADDR is.
+    void WriteOam(uint8_t value);
+
+    // Frame boundaries, in CPU cycles. EndFrame runs whatever lines are left.
+    void BeginFrame(uint64_t startCycle);
+    void CatchUp();
+    void EndFrame();
+
+    uint64_t Clock() const { return clock; }
+
+    PPUState state;
+    FrameBuffer frame;
+    bool render = true;
+
+private:
+    static constexpr uint32_t NoHit = UINT32_MAX;
+
+    uint32_t Dot() const;
+    void CatchUp(uint32_t dot);
+    void RunLine(uint32_t line);
+    void RenderLine(uint32_t line, std::span<uint8_t const> sprites);
+    size_t EvaluateSprites(uint32_t line, std::array<uint8_t, 8>& sprites);
+    void CheckSprite0(uint32_t line);
+    bool BackgroundOpaque(uint32_t x) const;
+    uint8_t SpritePattern(uint8_t const* sprite, uint32_t line, uint8_t& high) const;
+    uint8_t Pattern(uint16_t address) const;
+
+    uint8_t Read(uint16_t address) const;
+    void Write(uint16_t address, uint8_t value);
+    uint16_t Mirror(uint16_t address) const;
+    bool RenderingEnabled() const { return (state.mask & 0x18) != 0; }
+
+    uint64_t const& clock;
+    std::span<uint8_t const> chrRom;
+    bool verticalMirroring = false;
+    uint64_t frameStart = 0;
+    uint32_t nextLine = 0;
+    uint32_t sprite0Dot = NoHit;
+};
+
+} // nes
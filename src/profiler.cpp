@@ -0,0 +1,133 @@
+#include "profiler.h"
+#include "cpu.h"
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+namespace nes
+{
+
+Profiler::Profiler(uint32_t sampleInterval) : sampleInterval(std::max(1u, sampleInterval)), pcSamples(0x10000)
+{
+    stack.reserve(MaxDepth);
+    Clear();
+}
+
+void Profiler::Clear()
+{
+    untilSample = sampleInterval;
+    instructions = 0;
+    opcodeCounts.fill(0);
+    opcodeCycles.fill(0);
+    bankCycles.fill(0);
+    std::fill(pcSamples.begin(), pcSamples.end(), 0);
+    stack.clear();
+    stackSamples.clear();
+}
+
+void Profiler::Call(uint16_t target)
+{
+    if (stack.size() == MaxDepth)
+        stack.erase(stack.begin());
+    stack.push_back(target);
+}
+
+void Profiler::Return()
+{
+    // Returning out of something we didn't see called, e.g. we attached mid-frame.
+    if (!stack.empty())
+        stack.pop_back();
+}
+
+void Profiler::Sample(uint16_t pc)
+{
+    pcSamples[pc]++;
+    stackSamples[stack]++;
+}
+
+static char const* ModeName(AddressMode mode)
+{
+    switch (mode)
+    {
+        case AddressMode::Implicit: return "imp";
+        case AddressMode::Accumulator: return "acc";
+        case AddressMode::Immediate: return "imm";
+        case AddressMode::ZeroPage: return "zp";
+        case AddressMode::ZeroPageX: return "zp,x";
+        case AddressMode::ZeroPageY: return "zp,y";
+        case AddressMode::Relative: return "rel";
+        case AddressMode::Absolute: return "abs";
+        case AddressMode::AbsoluteX: return "abs,x";
+        case AddressMode::AbsoluteY: return "abs,y";
+        case AddressMode::Indirect: return "ind";
+        case AddressMode::IndexedIndirect: return "(zp,x)";
+        case AddressMode::IndirectIndexed: return "(zp),y";
+    }
+    return "?";
+}
+
+void Profiler::WriteReport(std::ostream& stream, size_t top) const
+{
+    char line[128];
+    auto const totalCycles = std::accumulate(opcodeCycles.begin(), opcodeCycles.end(), uint64_t { 0 });
+
+    snprintf(line, sizeof(line), "%llu instructions, %llu cycles\n\n", static_cast<unsigned long long>(instructions),
+             static_cast<unsigned long long>(totalCycles));
+    stream << line;
+
+    std::vector<int> opcodes(256);
+    std::iota(opcodes.begin(), opcodes.end(), 0);
+    std::sort(opcodes.begin(), opcodes.end(), [this](int a, int b) { return opcodeCycles[a] > opcodeCycles[b]; });
+
+    stream << "opcode  mode       count           cycles      %\n";
+    for (size_t i = 0; i < std::min<size_t>(top, 256) && opcodeCounts[opcodes[i]] > 0; i++)
+    {
+        auto const opcode = static_cast<uint8_t>(opcodes[i]);
+        auto const& info = CPU::Info(opcode);
+        snprintf(line, sizeof(line), "  %02X    %-8s %12llu %16llu %6.2f%s\n", opcode,
+                 info.instruction ? ModeName(info.addressMode) : "-",
+                 static_cast<unsigned long long>(opcodeCounts[opcode]),
+                 static_cast<unsigned long long>(opcodeCycles[opcode]),
+                 totalCycles ? 100.0 * opcodeCycles[opcode] / totalCycles : 0.0,
+                 info.instruction ? "" : "  (not implemented)");
+        stream << line;
+    }
+
+    std::vector<uint32_t> pcs(0x10000);
+    std::iota(pcs.begin(), pcs.end(), 0);
+    auto const shown = std::min<size_t>(top, pcs.size());
+    std::partial_sort(pcs.begin(), pcs.begin() + shown, pcs.end(), [this](uint32_t a, uint32_t b) { return pcSamples[a] > pcSamples[b]; });
+    auto const totalSamples = std::accumulate(pcSamples.begin(), pcSamples.end(), uint64_t { 0 });
+
+    stream << "\npc       samples      %\n";
+    for (size_t i = 0; i < shown && pcSamples[pcs[i]] > 0; i++)
+    {
+        snprintf(line, sizeof(line), "  $%04X %10u %6.2f\n", pcs[i], pcSamples[pcs[i]], 100.0 * pcSamples[pcs[i]] / totalSamples);
+        stream << line;
+    }
+
+    stream << "\nbank           cycles      %\n";
+    for (size_t bank = 0; bank < BankCount; bank++)
+    {
+        snprintf(line, sizeof(line), "  $%04zX %14llu %6.2f\n", bank << 13, static_cast<unsigned long long>(bankCycles[bank]),
+                 totalCycles ? 100.0 * bankCycles[bank] / totalCycles : 0.0);
+        stream << line;
+    }
+}
+
+void Profiler::WriteCollapsedStacks(std::ostream& stream) const
+{
+    char name[16];
+    for (auto const& [frames, count] : stackSamples)
+    {
+        stream << "reset";
+        for (auto target : frames)
+        {
+            snprintf(name, sizeof(name), ";sub_%04X", target);
+            stream << name;
+        }
+        stream << ' ' << count << '\n';
+    }
+}
+
+} // nes
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace nes
+{
+
+// Profiles the emulated game rather than the emulator: which opcodes run and how
+// many cycles they take, where PC spends its time, which 8K bank of the address
+// space it's in, and 6502 call stacks rebuilt from JSR/RTS.
+//
+// The CPU only calls into this in builds configured with NES_PROFILER=ON, so
+// normal builds don't pay anything. Attach with cpu.profiler = &profiler.
+class Profiler
+{
+public:
+    static constexpr size_t BankCount = 8;  // $0000, $2000 ... $E000
+    static constexpr size_t MaxDepth = 64;  // Anything deeper is a game playing tricks with the stack
+
+    // Sample PC and the call stack every sampleInterval instructions. 1 is exact but
+    // slow, the default is a prime so it doesn't line up with game loops.
+    explicit Profiler(uint32_t sampleInterval = 97);
+
+    // next is where the instruction left PC, so a JSR's is the subroutine it called.
+    void Record(uint16_t pc, uint8_t opcode, uint8_t cycles, uint16_t next)
+    {
+        opcodeCounts[opcode]++;
+        opcodeCycles[opcode] += cycles;
+        bankCycles[pc >> 13] += cycles;
+        instructions++;
+
+        if (opcode == 0x20)
+            Call(next);
+        else if (opcode == 0x60 || opcode == 0x40)
+            Return();
+
+        if (--untilSample == 0)
+        {
+            untilSample = sampleInterval;
+            Sample(pc);
+        }
+    }
+
+    void Clear();
+
+    uint64_t Instructions() const { return instructions; }
+    uint64_t OpcodeCount(uint8_t opcode) const { return opcodeCounts[opcode]; }
+    uint64_t OpcodeCycles(uint8_t opcode) const { return opcodeCycles[opcode]; }
+    uint64_t BankCycles(size_t bank) const { return bankCycles[bank]; }
+    uint32_t PcSamples(uint16_t pc) const { return pcSamples[pc]; }
+    size_t Depth() const { return stack.size(); }
+
+    // Human readable, top opcodes by cycles, hottest PCs and bank split.
+    void WriteReport(std::ostream& stream, size_t top = 20) const;
+
+    // One line per distinct stack, "reset;sub_C123;sub_C456 42", what flamegraph.pl
+    // and speedscope take.
+    void WriteCollapsedStacks(std::ostream& stream) const;
+
+private:
+    void Call(uint16_t target);
+    void Return();
+    void Sample(uint16_t pc);
+
+    uint32_t sampleInterval;
+    uint32_t untilSample;
+    uint64_t instructions;
+
+    std::array<uint64_t, 256> opcodeCounts;
+    std::array<uint64_t, 256> opcodeCycles;
+    std::array<uint64_t, BankCount> bankCycles;
+    std::vector<uint32_t> pcSamples; // 64K entries, one per address
+
+    std::vector<uint16_t> stack;     // Callee of each JSR we're inside
+    std::map<std::vector<uint16_t>, uint64_t> stackSamples;
+};
+
+} // nes
@@ -0,0 +1,131 @@
+#include "rollback.h"
+#include "zones.h"
+#include <algorithm>
+#include <chrono>
+
+namespace nes
+{
+
+LoopbackLink::LoopbackLink(uint32_t latency) : latency(latency), now(0)
+{
+    ends[0].link = this;
+    ends[1].link = this;
+    ends[0].peer = &ends[1];
+    ends[1].peer = &ends[0];
+}
+
+void LoopbackLink::Endpoint::Send(InputPacket const& packet)
+{
+    peer->inbox.push_back({ link->now + link->latency, packet });
+}
+
+bool LoopbackLink::Endpoint::Receive(InputPacket& packet)
+{
+    if (inbox.empty() || inbox.front().deliverAt > link->now)
+        return false;
+
+    packet = inbox.front().packet;
+    inbox.pop_front();
+    return true;
+}
+
+RollbackSession::RollbackSession(Console& console, Transport& transport, int localPort, uint32_t maxRollback)
+    : console(console), transport(transport), localPort(localPort), maxRollback(maxRollback),
+      frame(0), confirmedFrames(0), lastRemote(0),
+      // Remote can be a whole window ahead of us as well as behind
+      inputs(2 * (maxRollback + 2)), snapshots(maxRollback + 1)
+{
+}
+
+RollbackSession::FrameInput& RollbackSession::Input(uint64_t f)
+{
+    auto& input = inputs[f % inputs.size()];
+    if (input.frame != f)
+        input = { .frame = f };
+    return input;
+}
+
+void RollbackSession::Simulate(uint64_t f)
+{
+    auto& input = Input(f);
+    if (!input.confirmed)
+        input.remote = lastRemote;
+
+    console.memory.controllers[localPort].buttons = input.local;
+    console.memory.controllers[1 - localPort].buttons = input.remote;
+    console.RunFrame();
+}
+
+void RollbackSession::ReceiveRemote(uint64_t& rollbackFrom)
+{
+    InputPacket packet;
+    while (transport.Receive(packet))
+    {
+        auto& input = Input(packet.frame);
+
+        // Already ran this frame on a guess that turned out wrong
+        if (packet.frame < frame && input.remote != packet.buttons)
+            rollbackFrom = std::min(rollbackFrom, packet.frame);
+
+        input.remote = packet.buttons;
+        input.confirmed = true;
+    }
+
+    while (Input(confirmedFrames).confirmed)
+    {
+        lastRemote = Input(confirmedFrames).remote;
+        confirmedFrames++;
+    }
+}
+
+bool RollbackSession::AdvanceFrame(uint8_t localButtons)
+{
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::nanoseconds;
+
+    uint64_t rollbackFrom = frame;
+    ReceiveRemote(rollbackFrom);
+
+    // Any further and the snapshot we'd need to go back to would already be overwritten
+    if (frame - confirmedFrames > maxRollback)
+    {
+        stats.stalls++;
+        return false;
+    }
+
+    if (rollbackFrom < frame)
+    {
+        NES_ZONE("rollback");
+        auto const start = Clock::now();
+        console.Load(snapshots[rollbackFrom % snapshots.size()]);
+        for (auto f = rollbackFrom; f < frame; f++)
+        {
+            if (f != rollbackFrom)
+                console.Save(snapshots[f % snapshots.size()]);
+            Simulate(f);
+        }
+
+        stats.rollbacks++;
+        stats.resimulatedFrames += frame - rollbackFrom;
+        stats.maxRollbackFrames = std::max(stats.maxRollbackFrames, frame - rollbackFrom);
+        stats.rollbackNanoseconds += std::chrono::duration_cast<nanoseconds>(Clock::now() - start).count();
+    }
+
+    auto& input = Input(frame);
+    input.local = localButtons;
+    transport.Send({ frame, localButtons });
+
+    {
+        NES_ZONE("snapshot");
+        auto const start = Clock::now();
+        console.Save(snapshots[frame % snapshots.size()]);
+        stats.snapshotNanoseconds += std::chrono::duration_cast<nanoseconds>(Clock::now() - start).count();
+    }
+
+    Simulate(frame);
+    frame++;
+    stats.frames++;
+    return true;
+}
+
+} // nes
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "console.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace nes
+{
+
+struct InputPacket
+{
+    uint64_t frame;
+    uint8_t buttons;
+};
+
+// However the remote player's input gets here. Receive never blocks.
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+    virtual void Send(InputPacket const& packet) = 0;
+    virtual bool Receive(InputPacket& packet) = 0;
+};
+
+// Two ends of a pretend network in the same process. Packets show up on the other
+// end after latency calls to Advance, so tests can run both players on one box
+// with as much lag as they like and still be deterministic.
+class LoopbackLink
+{
+public:
+    explicit LoopbackLink(uint32_t latency);
+
+    Transport& End(int index) { return ends[index]; }
+
+    // One tick of simulated time, usually one frame.
+    void Advance() { now++; }
+
+private:
+    struct Queued
+    {
+        uint64_t deliverAt;
+        InputPacket packet;
+    };
+
+    class Endpoint : public Transport
+    {
+    public:
+        LoopbackLink* link = nullptr;
+        std::deque<Queued> inbox;
+        Endpoint* peer = nullptr;
+
+        void Send(InputPacket const& packet) override;
+        bool Receive(InputPacket& packet) override;
+    };
+
+    uint32_t latency;
+    uint64_t now;
+    Endpoint ends[2];
+};
+
+// GGPO style rollback. Every frame runs straight away using a guess for the remote
+// player's input (whatever they last pressed). When their real input turns up and
+// the guess was wrong, load the snapshot from that frame and run forward again
+// with the right input, all before this frame is shown.
+class RollbackSession
+{
+public:
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t stalls = 0;              // Frames refused for being too far ahead of the remote player
+        uint64_t rollbacks = 0;
+        uint64_t resimulatedFrames = 0;
+        uint64_t maxRollbackFrames = 0;
+        uint64_t snapshotNanoseconds = 0;
+        uint64_t rollbackNanoseconds = 0; // Restore plus re-simulation
+    };
+
+    // localPort is which pad the local player is on, the remote player gets the other one.
+    RollbackSession(Console& console, Transport& transport, int localPort, uint32_t maxRollback);
+
+    // Sends local input, takes in whatever remote input has arrived, rolls back if a
+    // guess was wrong, then runs the next frame. Returns false without running
+    // anything if that would put us more than maxRollback frames past the last
+    // confirmed remote input; call again next frame.
+    bool AdvanceFrame(uint8_t localButtons);
+
+    uint64_t Frame() const { return frame; }
+    Stats const& GetStats() const { return stats; }
+
+private:
+    struct FrameInput
+    {
+        uint64_t frame = ~0ull;
+        uint8_t local = 0;
+        uint8_t remote = 0;      // What we actually ran the frame with
+        bool confirmed = false;  // remote is the real thing, not a guess
+    };
+
+    FrameInput& Input(uint64_t f);
+    void Simulate(uint64_t f);
+    void ReceiveRemote(uint64_t& rollbackFrom);
+
+    Console& console;
+    Transport& transport;
+    int localPort;
+    uint32_t maxRollback;
+
+    uint64_t frame;            // Next frame to run
+    uint64_t confirmedFrames;  // Remote input is known for every frame before this
+    uint8_t lastRemote;        // Latest confirmed remote input, used as the guess
+
+    // Both rings are allocated once up front, snapshots[f % size] is the state at the start of frame f.
+    std::vector<FrameInput> inputs;
+    std::vector<ConsoleState> snapshots;
+    Stats stats;
+};
+
+} // nes
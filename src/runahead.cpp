@@ -0,0 +1,83 @@
+#include "runahead.h"
+#include "tsc.h"
+#include "zones.h"
+#include <chrono>
+#include <utility>
+
+namespace nes
+{
+
+RunAhead::RunAhead(std::shared_ptr<Cartridge const> cartridge, uint32_t framesAhead, bool secondInstance)
+    : main(cartridge), framesAhead(framesAhead), saved(), presented(), picture()
+{
+    if (secondInstance)
+        shadow = std::make_unique<Console>(cartridge);
+}
+
+void RunAhead::Reset()
+{
+    main.Reset();
+    main.Save(presented);
+    picture = main.ppu.frame;
+    stats = {};
+}
+
+void RunAhead::RunFrame(Console& console, std::array<uint8_t, 2> pads)
+{
+    console.memory.controllers[0].buttons = pads[0];
+    console.memory.controllers[1].buttons = pads[1];
+    console.RunFrame();
+}
+
+void RunAhead::RunFrame(std::array<uint8_t, 2> pads)
+{
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::nanoseconds;
+
+    auto const start = Clock::now();
+    RunFrame(main, pads);
+    auto const real = Clock::now();
+    auto const startTicks = ReadTimestampCounter();
+
+    if (shadow)
+    {
+        NES_ZONE("run-ahead");
+        main.Save(saved);
+        shadow->Load(saved);
+        for (uint32_t i = 0; i < framesAhead; i++)
+            RunFrame(*shadow, pads);
+
+        {
+            NES_ZONE("present");
+            shadow->Save(presented);
+            picture = shadow->ppu.frame;
+        }
+    }
+    else
+    {
+        NES_ZONE("run-ahead");
+        main.Save(saved);
+        picture = main.ppu.frame; // Snapshots leave the picture out, so it's kept here meanwhile
+
+        for (uint32_t i = 0; i < framesAhead; i++)
+            RunFrame(main, pads);
+
+        {
+            NES_ZONE("present");
+            main.Save(presented);
+        }
+        main.Load(saved);
+        std::swap(picture, main.ppu.frame);
+    }
+
+    auto const endTicks = ReadTimestampCounter();
+    auto const end = Clock::now();
+
+    stats.frames++;
+    stats.realNanoseconds += std::chrono::duration_cast<nanoseconds>(real - start).count();
+    stats.lastExtraNanoseconds = std::chrono::duration_cast<nanoseconds>(end - real).count();
+    stats.extraNanoseconds += stats.lastExtraNanoseconds;
+    stats.extraTicks += endTicks - startTicks;
+}
+
+} // nes
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cartridge.h"
+#include "console.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace nes
+{
+
+// Run-ahead hides a game's own input lag. Every frame: run the real frame, snapshot,
+// run a few more frames with the same input, show what that produced, then rewind
+// to the snapshot. The player sees the response to a button press frames sooner.
+// https://docs.libretro.com/guides/runahead/
+//
+// With a second instance the speculative frames run on a separate console that gets
+// a copy of the real one, so the real console is never rewound.
+class RunAhead
+{
+public:
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t realNanoseconds = 0;  // Running the real frame
+        uint64_t extraNanoseconds = 0; // Snapshot, speculative frames and restore
+        uint64_t extraTicks = 0;
+        uint64_t lastExtraNanoseconds = 0;
+    };
+
+    RunAhead(std::shared_ptr<Cartridge const> cartridge, uint32_t framesAhead, bool secondInstance);
+
+    void Reset();
+    void RunFrame(std::array<uint8_t, 2> pads);
+
+    // The console the real game runs on.
+    Console& Main() { return main; }
+
+    // State after the speculative frames, this is what gets shown.
+    ConsoleState const& Presented() const { return presented; }
+
+    // And what they drew. Main's own ppu.frame stays the real frame's picture.
+    FrameBuffer const& Picture() const { return picture; }
+
+    Stats const& GetStats() const { return stats; }
+
+private:
+    void RunFrame(Console& console, std::array<uint8_t, 2> pads);
+
+    Console main;
+    std::unique_ptr<Console> shadow;
+    uint32_t framesAhead;
+
+    // Preallocated so nothing per frame ever touches the heap.
+    ConsoleState saved;
+    ConsoleState presented;
+    FrameBuffer picture;
+    Stats stats;
+};
+
+} // nes
@@ -0,0 +1,212 @@
+#include "scheduler.h"
+#include "zones.h"
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace nes
+{
+
+static thread_local unsigned currentWorker = JobScheduler::NoWorker;
+
+// The cores we're allowed on, which under taskset or a container can be fewer than
+// hardware_concurrency and needn't start at 0. Empty if there's no way to ask.
+static std::vector<unsigned> AllowedCores()
+{
+    std::vector<unsigned> cores;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (unsigned core = 0; core < CPU_SETSIZE; core++)
+        {
+            if (CPU_ISSET(core, &set))
+                cores.push_back(core);
+        }
+    }
+#endif
+    return cores;
+}
+
+static bool PinToCore(std::thread& thread, unsigned core)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    // Only bother on Linux for now, that's where the big boxes are.
+    (void)thread;
+    (void)core;
+    return false;
+#endif
+}
+
+JobScheduler::JobScheduler(unsigned workerCount, bool pinWorkers)
+    : pinned(0), stopping(false), queued(0), outstanding(0), steals(0), nextWorker(0)
+{
+    auto const cores = AllowedCores();
+    if (workerCount == 0)
+        workerCount = cores.empty() ? std::max(1u, std::thread::hardware_concurrency()) : static_cast<unsigned>(cores.size());
+
+    for (unsigned i = 0; i < workerCount; i++)
+        workers.push_back(std::make_unique<Worker>());
+
+    // Workers go in the vector before any of them start, they all look at each other's deques.
+    for (unsigned i = 0; i < workerCount; i++)
+    {
+        workers[i]->thread = std::thread(&JobScheduler::Run, this, i);
+        if (pinWorkers && !cores.empty())
+            pinned += PinToCore(workers[i]->thread, cores[i % cores.size()]);
+    }
+}
+
+JobScheduler::~JobScheduler()
+{
+    {
+        std::lock_guard lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers)
+        worker->thread.join();
+}
+
+void JobScheduler::Submit(Job job, unsigned preferredWorker)
+{
+    auto& worker = *workers[preferredWorker % workers.size()];
+
+    // Counted before it's visible so a worker can never take the count below zero.
+    outstanding.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(sleepMutex);
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+    }
+    wake.notify_all();
+}
+
+void JobScheduler::Submit(Job job)
+{
+    // Jobs submitted from a worker stay on that worker, otherwise spread them out.
+    unsigned worker = CurrentWorker();
+    if (worker == NoWorker)
+        worker = nextWorker.fetch_add(1, std::memory_order_relaxed);
+
+    Submit(std::move(job), worker);
+}
+
+void JobScheduler::Wait()
+{
+    std::unique_lock lock(sleepMutex);
+    idle.wait(lock, [this] { return outstanding.load() == 0; });
+}
+
+unsigned JobScheduler::CurrentWorker()
+{
+    return currentWorker;
+}
+
+bool JobScheduler::TryPop(unsigned index, Job& job)
+{
+    auto& worker = *workers[index];
+    std::lock_guard lock(worker.mutex);
+    if (worker.jobs.empty())
+        return false;
+
+    // Oldest first from our own deque. Jobs that resubmit themselves (every console
+    // frame does) would starve everything else on this worker if we took the newest.
+    job = std::move(worker.jobs.front());
+    worker.jobs.pop_front();
+    return true;
+}
+
+bool JobScheduler::TrySteal(unsigned index, Job& job, bool fromIdle)
+{
+    for (size_t i = 1; i < workers.size(); i++)
+    {
+        auto& victim = *workers[(index + i) % workers.size()];
+
+        // An idle owner is about to pick its own work up, leave it there unless it's
+        // already had its chance.
+        if (!fromIdle && !victim.busy.load(std::memory_order_relaxed))
+            continue;
+
+        std::lock_guard lock(victim.mutex);
+        if (victim.jobs.empty())
+            continue;
+
+        // Newest when stealing, it's the one the owner would have got to last.
+        job = std::move(victim.jobs.back());
+        victim.jobs.pop_back();
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void JobScheduler::Run(unsigned index)
+{
+    currentWorker = index;
+    auto& self = *workers[index];
+
+#if NES_ENABLE_ZONES
+    NameZoneThread("worker " + std::to_string(index));
+#endif
+
+    // Set once idle owners have been given a turn at their own work and it's still there
+    bool impatient = false;
+
+    while (true)
+    {
+        Job job;
+        if (TryPop(index, job) || TrySteal(index, job, impatient))
+        {
+            impatient = false;
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            self.busy.store(true, std::memory_order_relaxed);
+            {
+                NES_ZONE("job");
+                job();
+            }
+            self.busy.store(false, std::memory_order_relaxed);
+
+            if (outstanding.fetch_sub(1) == 1)
+            {
+                std::lock_guard lock(sleepMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        if (stopping && queued.load() == 0)
+            return;
+
+        if (queued.load() > 0)
+        {
+            // Work exists but nobody busy has it, so its owner is idle and should
+            // grab it. Give it a chance, then take it ourselves next time round.
+            lock.unlock();
+            std::this_thread::yield();
+            impatient = true;
+            continue;
+        }
+
+        impatient = false;
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+    }
+}
+
+} // nes
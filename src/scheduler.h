@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+
+// Work stealing thread pool. Every worker has its own deque, jobs get pushed to
+// the worker they asked for and only move elsewhere when some other worker has
+// nothing to do and the owner is already busy. Keeps a job's data in the same
+// core's cache as much as possible without leaving cores idle.
+class JobScheduler
+{
+public:
+    using Job = std::function<void()>;
+
+    static constexpr unsigned NoWorker = ~0u;
+
+    // workerCount of 0 means one per core we're allowed to run on. Pinned workers go
+    // round those cores in order.
+    explicit JobScheduler(unsigned workerCount = 0, bool pinWorkers = true);
+    ~JobScheduler();
+
+    JobScheduler(JobScheduler const&) = delete;
+    JobScheduler& operator=(JobScheduler const&) = delete;
+
+    // Safe to call from any thread, including from inside a running job.
+    void Submit(Job job, unsigned preferredWorker);
+    void Submit(Job job);
+
+    // Blocks until every submitted job, and anything they submitted, has finished.
+    // Don't call from a worker thread.
+    void Wait();
+
+    unsigned WorkerCount() const { return static_cast<unsigned>(workers.size()); }
+    uint64_t Steals() const { return steals.load(std::memory_order_relaxed); }
+
+    // Workers that really are pinned. Less than WorkerCount when the OS said no, or
+    // there was no way to find out which cores we're allowed on.
+    unsigned PinnedWorkers() const { return pinned; }
+
+    // Index of the worker running the calling thread, or NoWorker.
+    static unsigned CurrentWorker();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::atomic<bool> busy { false };
+        std::thread thread;
+    };
+
+    void Run(unsigned index);
+    bool TryPop(unsigned index, Job& job);
+    bool TrySteal(unsigned index, Job& job, bool fromIdle);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    unsigned pinned;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stopping;
+
+    std::atomic<size_t> queued;
+    std::atomic<size_t> outstanding;
+    std::atomic<uint64_t> steals;
+    std::atomic<unsigned> nextWorker;
+};
+
+// How many bands ParallelFor splits count items into. A couple per worker so one slow
+// core doesn't hold the rest up, plus one for the calling thread. 1 without a scheduler.
+inline unsigned ParallelBands(JobScheduler const* scheduler, unsigned count)
+{
+    unsigned const workers = scheduler ? scheduler->WorkerCount() : 0;
+    return std::min(workers * 2 + 1, count);
+}
+
+// Calls fn(band, first, last) for each band of [0, count), the last band on this
+// thread and the rest as jobs, and returns once they're all done. band is below
+// ParallelBands, so callers can keep scratch space per band. Without a scheduler
+// it's one call on this thread. Don't pass a scheduler from one of its own workers.
+template <typename Fn>
+void ParallelFor(JobScheduler* scheduler, unsigned count, Fn const& fn)
+{
+    unsigned const bands = ParallelBands(scheduler, count);
+    if (bands == 0)
+        return;
+
+    std::latch done(bands - 1);
+    for (unsigned band = 0; band + 1 < bands; band++)
+    {
+        unsigned const first = count * band / bands;
+        unsigned const last = count * (band + 1) / bands;
+        scheduler->Submit([&fn, &done, band, first, last] {
+            fn(band, first, last);
+            done.count_down();
+        });
+    }
+
+    fn(bands - 1, count * (bands - 1) / bands, count);
+    done.wait();
+}
+
+} // nes
@@ -0,0 +1,430 @@
+#include "screenshot.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+namespace nes
+{
+
+// Deflate packs bits from the least significant end, Huffman codes most significant
+// bit first, so the codes below are stored reversed.
+struct BitWriter
+{
+    std::vector<uint8_t>& out;
+    uint64_t bits = 0;
+    unsigned count = 0;
+
+    void Put(uint32_t value, unsigned length)
+    {
+        bits |= uint64_t { value } << count;
+        count += length;
+        while (count >= 8)
+        {
+            out.push_back(static_cast<uint8_t>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void Finish()
+    {
+        if (count > 0)
+            out.push_back(static_cast<uint8_t>(bits));
+        bits = 0;
+        count = 0;
+    }
+};
+
+static constexpr uint32_t Reverse(uint32_t code, unsigned length)
+{
+    uint32_t reversed = 0;
+    for (unsigned i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    return reversed;
+}
+
+struct Code
+{
+    uint16_t bits;
+    uint8_t length;
+};
+
+// RFC 1951 3.2.6, the fixed literal/length code
+static constexpr std::array<Code, 288> MakeFixedCodes()
+{
+    std::array<Code, 288> codes {};
+    for (uint32_t symbol = 0; symbol < 288; symbol++)
+    {
+        uint32_t code;
+        unsigned length;
+        if (symbol < 144)
+            code = 0x30 + symbol, length = 8;
+        else if (symbol < 256)
+            code = 0x190 + symbol - 144, length = 9;
+        else if (symbol < 280)
+            code = symbol - 256, length = 7;
+        else
+            code = 0xC0 + symbol - 280, length = 8;
+        codes[symbol] = { static_cast<uint16_t>(Reverse(code, length)), static_cast<uint8_t>(length) };
+    }
+    return codes;
+}
+
+static constexpr auto FixedCodes = MakeFixedCodes();
+
+static constexpr uint16_t LengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                             31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static constexpr uint8_t LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                             2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static constexpr uint16_t DistanceBase[30] = { 1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                               33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                               1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static constexpr uint8_t DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3,  3,  4,  4,  5,  5,  6,
+                                               6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static constexpr unsigned MinMatch = 3;
+static constexpr unsigned MaxMatch = 258;
+static constexpr unsigned WindowSize = 32768;
+static constexpr unsigned HashBits = 15;
+static constexpr unsigned MaxChain = 16; // Candidates tried a byte, plenty for frames
+
+static void PutMatch(BitWriter& writer, unsigned length, unsigned distance)
+{
+    unsigned const lengthCode = static_cast<unsigned>(std::upper_bound(LengthBase, LengthBase + 29, length) - LengthBase) - 1;
+    auto const& code = FixedCodes[257 + lengthCode];
+    writer.Put(code.bits, code.length);
+    writer.Put(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+    unsigned const distanceCode = static_cast<unsigned>(std::upper_bound(DistanceBase, DistanceBase + 30, distance) - DistanceBase) - 1;
+    writer.Put(Reverse(distanceCode, 5), 5);
+    writer.Put(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+}
+
+static uint32_t Adler32(std::span<uint8_t const> data)
+{
+    uint32_t a = 1, b = 0;
+    size_t i = 0;
+    while (i < data.size())
+    {
+        // Biggest run that can't overflow b before the modulo
+        size_t const end = std::min(data.size(), i + 5552);
+        for (; i < end; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+std::vector<uint8_t> Deflate(std::span<uint8_t const> data)
+{
+    std::vector<uint8_t> out { 0x78, 0x01 }; // 32K window, no dictionary
+    out.reserve(data.size() / 4 + 64);
+    BitWriter writer { out };
+    writer.Put(1, 1); // Last block
+    writer.Put(1, 2); // Fixed codes
+
+    std::vector<int32_t> head(size_t { 1 } << HashBits, -1);
+    std::vector<int32_t> previous(WindowSize, -1);
+    size_t const size = data.size();
+    auto hash = [&](size_t i) {
+        uint32_t const bytes = uint32_t { data[i] } | uint32_t { data[i + 1] } << 8 | uint32_t { data[i + 2] } << 16;
+        return (bytes * 0x9E3779B1u) >> (32 - HashBits);
+    };
+    auto insert = [&](size_t i) {
+        auto const h = hash(i);
+        previous[i % WindowSize] = head[h];
+        head[h] = static_cast<int32_t>(i);
+    };
+
+    size_t i = 0;
+    while (i < size)
+    {
+        unsigned best = 0;
+        size_t bestDistance = 0;
+        if (i + MinMatch <= size)
+        {
+            unsigned const limit = static_cast<unsigned>(std::min<size_t>(MaxMatch, size - i));
+            int32_t candidate = head[hash(i)];
+            for (unsigned chain = 0; chain < MaxChain && candidate >= 0 && i - static_cast<size_t>(candidate) <= WindowSize; chain++)
+            {
+                // Slots get reused as the window moves, so the bytes are always checked
+                auto const c = static_cast<size_t>(candidate);
+                if (data[c + best] == data[i + best])
+                {
+                    unsigned length = 0;
+                    while (length < limit && data[c + length] == data[i + length])
+                        length++;
+                    if (length > best)
+                    {
+                        best = length;
+                        bestDistance = i - c;
+                        if (best == limit)
+                            break;
+                    }
+                }
+                candidate = previous[c % WindowSize];
+            }
+            insert(i);
+        }
+
+        if (best >= MinMatch)
+        {
+            PutMatch(writer, best, static_cast<unsigned>(bestDistance));
+            for (size_t j = i + 1; j < i + best && j + MinMatch <= size; j++)
+                insert(j);
+            i += best;
+        }
+        else
+        {
+            auto const& code = FixedCodes[data[i]];
+            writer.Put(code.bits, code.length);
+            i++;
+        }
+    }
+
+    auto const& end = FixedCodes[256];
+    writer.Put(end.bits, end.length);
+    writer.Finish();
+
+    uint32_t const adler = Adler32(data);
+    out.insert(out.end(), { static_cast<uint8_t>(adler >> 24), static_cast<uint8_t>(adler >> 16),
+                            static_cast<uint8_t>(adler >> 8), static_cast<uint8_t>(adler) });
+    return out;
+}
+
+static constexpr std::array<uint32_t, 256> MakeCrcTable()
+{
+    std::array<uint32_t, 256> table {};
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[n] = c;
+    }
+    return table;
+}
+
+static constexpr auto CrcTable = MakeCrcTable();
+
+static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.insert(out.end(), { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) });
+}
+
+static void PutChunk(std::vector<uint8_t>& out, char const (&type)[5], std::span<uint8_t const> data)
+{
+    PutBigEndian(out, static_cast<uint32_t>(data.size()));
+    size_t const start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = start; i < out.size(); i++)
+        crc = CrcTable[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+    PutBigEndian(out, crc ^ 0xFFFFFFFFu);
+}
+
+std::vector<uint8_t> EncodePng(FrameBuffer const& pixels, Palette const& palette, PngOptions const& options)
+{
+    unsigned const shrink = std::clamp(options.shrink, 1u, FrameHeight);
+    unsigned const width = (FrameWidth + shrink - 1) / shrink;
+    unsigned const height = (FrameHeight + shrink - 1) / shrink;
+    auto at = [&](unsigned x, unsigned y) { return pixels[y * shrink * FrameWidth + x * shrink] & PixelMask; };
+
+    // Palette entry for each Pixel the picture has, in the order they turn up
+    std::array<int16_t, PaletteSize> entries;
+    entries.fill(-1);
+    std::vector<uint8_t> plte;
+    for (unsigned y = 0; y < height && plte.size() <= 256 * 3; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            auto const pixel = at(x, y);
+            if (entries[pixel] >= 0)
+                continue;
+            entries[pixel] = static_cast<int16_t>(plte.size() / 3);
+            uint32_t const color = palette.colors[pixel];
+            plte.insert(plte.end(), { static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8),
+                                      static_cast<uint8_t>(color) });
+        }
+    }
+    bool const indexed = plte.size() <= 256 * 3;
+
+    // Every line filter type 0, which is what's recommended for indexed colour and
+    // leaves repeats in the picture as repeats for LZ77 to find
+    std::vector<uint8_t> raw;
+    raw.reserve(size_t { height } * (1 + width * (indexed ? 1 : 3)));
+    for (unsigned y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        for (unsigned x = 0; x < width; x++)
+        {
+            auto const pixel = at(x, y);
+            if (indexed)
+            {
+                raw.push_back(static_cast<uint8_t>(entries[pixel]));
+                continue;
+            }
+            uint32_t const color = palette.colors[pixel];
+            raw.insert(raw.end(), { static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8),
+                                    static_cast<uint8_t>(color) });
+        }
+    }
+
+    std::vector<uint8_t> png { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> header;
+    PutBigEndian(header, width);
+    PutBigEndian(header, height);
+    header.insert(header.end(), { 8, static_cast<uint8_t>(indexed ? 3 : 2), 0, 0, 0 });
+    PutChunk(png, "IHDR", header);
+    if (indexed)
+        PutChunk(png, "PLTE", plte);
+    PutChunk(png, "IDAT", Deflate(raw));
+    PutChunk(png, "IEND", {});
+    return png;
+}
+
+ScreenshotWriter::ScreenshotWriter(Palette const& palette, size_t maxQueued)
+    : palette(palette), maxQueued(std::max<size_t>(maxQueued, 1))
+{
+    // One for every queued request, the one being encoded and one being filled, so
+    // requests don't allocate once it's going
+    for (size_t i = 0; i < this->maxQueued + 2; i++)
+        spare.push_back(std::make_unique<FrameBuffer>());
+    thread = std::thread([this] { Run(); });
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    queuedChanged.notify_one();
+    thread.join();
+}
+
+void ScreenshotWriter::Save(std::string path, FrameBuffer const& pixels, PngOptions const& options)
+{
+    Queue({ std::move(path), nullptr, options, nullptr }, pixels);
+}
+
+void ScreenshotWriter::Encode(std::string key, FrameBuffer const& pixels, PngOptions const& options, Done done)
+{
+    Queue({ std::move(key), nullptr, options, std::move(done) }, pixels);
+}
+
+void ScreenshotWriter::Queue(Request request, FrameBuffer const& pixels)
+{
+    {
+        std::lock_guard lock(mutex);
+        stats.requested++;
+        if (!spare.empty())
+        {
+            request.pixels = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    // The copy's the only real work on the caller's thread, and it's outside the lock
+    if (!request.pixels)
+        request.pixels = std::make_unique<FrameBuffer>();
+    *request.pixels = pixels;
+
+    {
+        std::unique_lock lock(mutex);
+        bool waited = false;
+        while (true)
+        {
+            auto const same = std::find_if(queued.begin(), queued.end(), [&](Request const& r) { return r.key == request.key; });
+            if (same != queued.end())
+            {
+                stats.coalesced++;
+                spare.push_back(std::move(same->pixels));
+                *same = std::move(request);
+                break;
+            }
+
+            if (queued.size() < maxQueued)
+            {
+                queued.push_back(std::move(request));
+                break;
+            }
+
+            // Full. Only thumbnails make way, and only for another thumbnail.
+            auto const oldest = request.done ? std::find_if(queued.begin(), queued.end(), [](Request const& r) { return r.done != nullptr; })
+                                             : queued.end();
+            if (oldest != queued.end())
+            {
+                stats.dropped++;
+                spare.push_back(std::move(oldest->pixels));
+                queued.erase(oldest);
+                queued.push_back(std::move(request));
+                break;
+            }
+
+            stats.waited += waited ? 0 : 1;
+            waited = true;
+            room.wait(lock);
+        }
+    }
+    queuedChanged.notify_one();
+}
+
+void ScreenshotWriter::Flush()
+{
+    std::unique_lock lock(mutex);
+    finished.wait(lock, [this] { return queued.empty() && !encoding; });
+}
+
+ScreenshotStats ScreenshotWriter::Stats() const
+{
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+void ScreenshotWriter::Run()
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        queuedChanged.wait(lock, [this] { return stopping || !queued.empty(); });
+        if (queued.empty())
+            break; // Stopping, and everything's done
+
+        auto request = std::move(queued.front());
+        queued.pop_front();
+        encoding = true;
+        lock.unlock();
+        room.notify_all();
+
+        auto const png = EncodePng(*request.pixels, palette, request.options);
+        bool ok = true;
+        if (request.done)
+        {
+            request.done(png);
+        }
+        else
+        {
+            std::FILE* file = std::fopen(request.key.c_str(), "wb");
+            ok = file && std::fwrite(png.data(), 1, png.size(), file) == png.size();
+            if (file)
+                ok &= std::fclose(file) == 0;
+        }
+
+        lock.lock();
+        stats.encoded++;
+        stats.failed += ok ? 0 : 1;
+        spare.push_back(std::move(request.pixels));
+        encoding = false;
+        finished.notify_all();
+    }
+}
+
+} // nes
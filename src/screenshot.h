@@ -0,0 +1,104 @@
+#pragma once
+
+#include "frame.h"
+#include "palette.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+
+// zlib stream (RFC 1950) of data. One block of fixed Huffman codes with greedy LZ77
+// matching over the whole 32K window, nowhere near zlib's ratio but no tables to
+// send and fast on pictures that are mostly runs and repeated tiles.
+std::vector<uint8_t> Deflate(std::span<uint8_t const> data);
+
+struct PngOptions
+{
+    unsigned shrink = 1; // Keep every shrink'th pixel each way, 2 for a 128x120 thumbnail
+};
+
+// Whole PNG file. Indexed colour with only the colours the picture uses, which is
+// any frame without more than 256 index and emphasis combinations, so every frame
+// there is, and RGB otherwise.
+std::vector<uint8_t> EncodePng(FrameBuffer const& pixels, Palette const& palette = Palette::Default(),
+                               PngOptions const& options = {});
+
+struct ScreenshotStats
+{
+    uint64_t requested;
+    uint64_t encoded;
+    uint64_t coalesced; // Replaced a queued request with the same key before it got encoded
+    uint64_t dropped;   // Oldest queued thumbnail pushed out by a new one, queue full
+    uint64_t waited;    // Requests that had to wait for the encoder to make room
+    uint64_t failed;    // Files that couldn't be written
+};
+
+// Encodes PNGs on its own thread. A request copies the frame into one of a few
+// spare buffers and returns, so the emulation thread doesn't wait on compression
+// while the encoder keeps up.
+//
+// If it falls behind, a request with the same key as one still queued takes its
+// place, so a save slot's thumbnail only gets encoded once however often it's
+// saved. Past maxQueued a thumbnail pushes out the oldest queued thumbnail, there'll
+// be another one along, but someone asked for a file and gets it, so a Save waits
+// for room instead. So does a thumbnail when only files are queued.
+class ScreenshotWriter
+{
+public:
+    // On the encoder thread, with the finished file.
+    using Done = std::function<void(std::vector<uint8_t> const& png)>;
+
+    explicit ScreenshotWriter(Palette const& palette = Palette::Default(), size_t maxQueued = 4);
+    ~ScreenshotWriter(); // Encodes everything still queued first
+    ScreenshotWriter(ScreenshotWriter const&) = delete;
+    ScreenshotWriter& operator=(ScreenshotWriter const&) = delete;
+
+    // Written to path, which is also the key. Never dropped, waits for room if the
+    // queue's full.
+    void Save(std::string path, FrameBuffer const& pixels, PngOptions const& options = {});
+
+    // Handed to done instead, for thumbnails that go in with a save state rather than
+    // a file of their own.
+    void Encode(std::string key, FrameBuffer const& pixels, PngOptions const& options, Done done);
+
+    // Waits for everything requested so far to be finished.
+    void Flush();
+
+    ScreenshotStats Stats() const;
+
+private:
+    struct Request
+    {
+        std::string key;
+        std::unique_ptr<FrameBuffer> pixels;
+        PngOptions options;
+        Done done; // Empty to write the file named by key
+    };
+
+    void Queue(Request request, FrameBuffer const& pixels);
+    void Run();
+
+    Palette palette;
+    size_t maxQueued;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable queuedChanged;
+    std::condition_variable room;
+    std::condition_variable finished;
+    std::deque<Request> queued;
+    std::vector<std::unique_ptr<FrameBuffer>> spare;
+    bool encoding = false;
+    bool stopping = false;
+    ScreenshotStats stats {};
+};
+
+} // nes
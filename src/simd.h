@@ -0,0 +1,35 @@
+#pragma once
+
+// x86-64 builds compile the AVX2 paths with target attributes and pick them at run
+// time, so one binary still runs on machines without it. Elsewhere there's only
+// the scalar code and NES_AVX2 isn't defined.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NES_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace nes
+{
+
+inline bool HasAvx2()
+{
+#if NES_AVX2
+    static bool const has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+}
+
+// Haswell and later have both, but they're separate feature bits.
+inline bool HasAvx2Fma()
+{
+#if NES_AVX2
+    static bool const has = HasAvx2() && __builtin_cpu_supports("fma");
+    return has;
+#else
+    return false;
+#endif
+}
+
+} // nes
@@ -0,0 +1,297 @@
+#include "trace.h"
+#include "disassembler.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace nes
+{
+
+static char const Magic[4] = { 'N', 'E', 'S', 'T' };
+static uint32_t const Version = 1;
+
+// Control byte: below 0x80 is that many plus one literal bytes following, from
+// 0x80 up is a run of (control - 0x7F) zeros.
+static void Compress(uint8_t const* data, size_t size, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t run = 0;
+        while (i + run < size && data[i + run] == 0 && run < 128)
+            run++;
+
+        if (run > 0)
+        {
+            out.push_back(static_cast<uint8_t>(0x7F + run));
+            i += run;
+            continue;
+        }
+
+        // Literals until the next pair of zeros, a single zero is cheaper left in
+        size_t literal = 0;
+        while (i + literal < size && literal < 128 &&
+               !(data[i + literal] == 0 && (i + literal + 1 == size || data[i + literal + 1] == 0)))
+            literal++;
+
+        out.push_back(static_cast<uint8_t>(literal - 1));
+        out.insert(out.end(), data + i, data + i + literal);
+        i += literal;
+    }
+}
+
+static bool Decompress(uint8_t const* data, size_t size, uint8_t* out, size_t outSize)
+{
+    size_t o = 0;
+    for (size_t i = 0; i < size;)
+    {
+        uint8_t const control = data[i++];
+        if (control >= 0x80)
+        {
+            size_t const run = control - 0x7F;
+            if (o + run > outSize)
+                return false;
+            std::memset(out + o, 0, run);
+            o += run;
+        }
+        else
+        {
+            size_t const literal = control + 1u;
+            if (o + literal > outSize || i + literal > size)
+                return false;
+            std::memcpy(out + o, data + i, literal);
+            o += literal;
+            i += literal;
+        }
+    }
+
+    return o == outSize;
+}
+
+// What the next record probably is. PC carries on from the last instruction and
+// everything else is whatever it was last time we were at that PC, which in a loop
+// is usually right, so most of each delta is zeros. Cycles go as a difference. Every
+// block starts from a fresh one so blocks decode on their own.
+struct Predictor
+{
+    static constexpr size_t Slots = 1024;
+    static constexpr size_t First = offsetof(TraceRecord, opcode);
+    static constexpr size_t Last = offsetof(TraceRecord, cycle);
+
+    TraceRecord previous {};
+    std::array<TraceRecord, Slots> byPc {};
+
+    uint16_t NextPc() const
+    {
+        return static_cast<uint16_t>(previous.pc + Opcode(previous.opcode).size);
+    }
+
+    static void Xor(TraceRecord const& from, TraceRecord const& with, TraceRecord& to)
+    {
+        auto const* a = reinterpret_cast<uint8_t const*>(&from);
+        auto const* b = reinterpret_cast<uint8_t const*>(&with);
+        auto* out = reinterpret_cast<uint8_t*>(&to);
+        for (size_t i = First; i < Last; i++)
+            out[i] = a[i] ^ b[i];
+    }
+
+    void Encode(TraceRecord const& record, TraceRecord& delta)
+    {
+        auto& seen = byPc[record.pc % Slots];
+        delta.pc = record.pc ^ NextPc();
+        Xor(record, seen, delta);
+        delta.cycle = record.cycle - previous.cycle;
+        seen = previous = record;
+    }
+
+    void Decode(TraceRecord const& delta, TraceRecord& record)
+    {
+        uint16_t const pc = delta.pc ^ NextPc();
+        uint32_t const cycle = previous.cycle + delta.cycle;
+        auto& seen = byPc[pc % Slots];
+        Xor(delta, seen, record);
+        record.pc = pc;
+        record.cycle = cycle;
+        seen = previous = record;
+    }
+};
+
+Tracer::Tracer(std::string const& filename, size_t capacity)
+    : file(filename, std::ios::binary), ring(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(ring.size() - 1),
+      columns(BlockRecords * sizeof(TraceRecord))
+{
+    if (file)
+    {
+        uint32_t const header[] = { Version, sizeof(TraceRecord) };
+        file.write(Magic, sizeof(Magic));
+        file.write(reinterpret_cast<char const*>(header), sizeof(header));
+    }
+
+    // Runs even if the file didn't open, so the CPU never waits on a ring nobody drains
+    writer = std::thread(&Tracer::Writer, this);
+}
+
+Tracer::~Tracer()
+{
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+}
+
+void Tracer::WaitForSpace(uint64_t position)
+{
+    stalls++;
+    while (position - tailSeen == ring.size())
+    {
+        std::this_thread::yield();
+        tailSeen = tail.load(std::memory_order_acquire);
+    }
+}
+
+void Tracer::Writer()
+{
+    for (;;)
+    {
+        // Read stopping first, anything pushed before the destructor ran is then visible below
+        bool const stop = stopping.load(std::memory_order_acquire);
+        auto const first = tail.load(std::memory_order_relaxed);
+        auto const available = head.load(std::memory_order_acquire) - first;
+
+        if (available == 0)
+        {
+            if (stop)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        auto const count = static_cast<size_t>(std::min<uint64_t>(available, BlockRecords));
+        WriteBlock(first, count);
+        tail.store(first + count, std::memory_order_release);
+    }
+
+    file.flush();
+}
+
+void Tracer::WriteBlock(uint64_t first, size_t count)
+{
+    // Column at a time, all the low cycle bytes together and so on, so the zeros
+    // line up into long runs
+    Predictor predictor;
+    for (size_t i = 0; i < count; i++)
+    {
+        TraceRecord delta;
+        predictor.Encode(ring[(first + i) & mask], delta);
+
+        auto const* bytes = reinterpret_cast<uint8_t const*>(&delta);
+        for (size_t b = 0; b < sizeof(TraceRecord); b++)
+            columns[b * count + i] = bytes[b];
+    }
+
+    block.clear();
+    Compress(columns.data(), count * sizeof(TraceRecord), block);
+
+    if (file)
+    {
+        uint32_t const header[] = { static_cast<uint32_t>(count), static_cast<uint32_t>(block.size()) };
+        file.write(reinterpret_cast<char const*>(header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(block.data()), static_cast<std::streamsize>(block.size()));
+        bytesWritten.fetch_add(sizeof(header) + block.size(), std::memory_order_relaxed);
+    }
+}
+
+std::optional<TraceReader> TraceReader::Open(std::string const& filename)
+{
+    TraceReader reader;
+    reader.file.open(filename, std::ios::binary);
+
+    char magic[4];
+    uint32_t header[2];
+    if (!reader.file.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(magic)) != 0)
+        return std::nullopt;
+    if (!reader.file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != Version || header[1] != sizeof(TraceRecord))
+        return std::nullopt;
+
+    return reader;
+}
+
+bool TraceReader::ReadBlock()
+{
+    uint32_t header[2];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        return false;
+    if (header[0] == 0 || header[0] > Tracer::BlockRecords)
+        return false;
+
+    std::vector<uint8_t> compressed(header[1]);
+    if (!file.read(reinterpret_cast<char*>(compressed.data()), compressed.size()))
+        return false;
+
+    size_t const count = header[0];
+    std::vector<uint8_t> columns(count * sizeof(TraceRecord));
+    if (!Decompress(compressed.data(), compressed.size(), columns.data(), columns.size()))
+        return false;
+
+    records.resize(count);
+    Predictor predictor;
+    for (size_t i = 0; i < count; i++)
+    {
+        TraceRecord delta;
+        auto* bytes = reinterpret_cast<uint8_t*>(&delta);
+        for (size_t b = 0; b < sizeof(TraceRecord); b++)
+            bytes[b] = columns[b * count + i];
+
+        predictor.Decode(delta, records[i]);
+    }
+
+    next = 0;
+    return true;
+}
+
+bool TraceReader::Next(TraceRecord& record, uint64_t& cycle)
+{
+    if (next == records.size() && !ReadBlock())
+        return false;
+
+    record = records[next++];
+
+    // Cycles only go up, so going backwards means the low half wrapped
+    if (record.cycle < lastCycle)
+        cycleHigh += uint64_t(1) << 32;
+    lastCycle = record.cycle;
+
+    cycle = cycleHigh | record.cycle;
+    return true;
+}
+
+std::string FormatNestest(TraceRecord const& record, uint64_t cycle)
+{
+    auto const& name = Opcode(record.opcode);
+
+    char bytes[16];
+    if (name.size == 3)
+        snprintf(bytes, sizeof(bytes), "%02X %02X %02X", record.opcode, record.operands[0], record.operands[1]);
+    else if (name.size == 2)
+        snprintf(bytes, sizeof(bytes), "%02X %02X", record.opcode, record.operands[0]);
+    else
+        snprintf(bytes, sizeof(bytes), "%02X", record.opcode);
+
+    // 341 dots a scanline, 3 dots a CPU cycle
+    uint64_t const dots = cycle * 3;
+    auto const scanline = static_cast<unsigned>(dots / 341 % 262);
+    auto const dot = static_cast<unsigned>(dots % 341);
+
+    auto const text = Disassemble(record.pc, record.opcode, record.operands[0], record.operands[1]);
+
+    char line[128];
+    int const length = snprintf(line, sizeof(line), "%04X  %-8s  %-32sA:%02X X:%02X Y:%02X P:%02X SP:%02X PPU:%3u,%3u CYC:%llu",
+                                record.pc, bytes, text.c_str(), record.a, record.x, record.y, record.p, record.sp,
+                                scanline, dot, static_cast<unsigned long long>(cycle));
+    return std::string(line, length);
+}
+
+} // nes
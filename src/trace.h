@@ -0,0 +1,157 @@
+#pragma once
+
+#include "cpu.h"
+#include "disassembler.h"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nes
+{
+
+// One instruction, with the registers as they were before it ran, same as a
+// nestest log line.
+struct TraceRecord
+{
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operands[2]; // Only as many as the instruction has, the rest are 0
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+    uint8_t unused[2];
+    uint32_t cycle; // Low half only, the reader puts the top back
+};
+static_assert(sizeof(TraceRecord) == 16, "Trace files depend on the record layout");
+
+// Instruction trace for one console. The CPU writes records into a single producer,
+// single consumer ring and a background thread compresses and writes them out, so
+// the emulation thread never touches the file. If the writer falls behind, the CPU
+// waits for space rather than dropping records, a trace with holes in it is no use
+// for finding where two runs split. Stalls() says how often that happened.
+//
+// The CPU only calls into this in builds configured with NES_TRACER=ON. Attach
+// with cpu.tracer = &tracer.
+//
+// File: "NEST", version, record size, then blocks of
+// { uint32 records, uint32 bytes, payload }. Each record is stored as the difference
+// from a guess at it, mostly zeros, and the block is written a byte column at a
+// time with the zeros run length encoded.
+class Tracer
+{
+public:
+    static constexpr size_t DefaultCapacity = 1 << 16; // Records, 1MB
+    static constexpr size_t BlockRecords = 4096;
+
+    // capacity is rounded up to a power of two.
+    explicit Tracer(std::string const& filename, size_t capacity = DefaultCapacity);
+    ~Tracer(); // Writes out whatever is left
+    Tracer(Tracer const&) = delete;
+    Tracer& operator=(Tracer const&) = delete;
+
+    bool IsOpen() const { return file.is_open(); }
+
+    // Before the instruction at cpu.pc runs. Emulation thread only.
+    void Record(CPU const& cpu)
+    {
+        TraceRecord record {};
+        record.pc = cpu.pc;
+        record.opcode = cpu.memoryBus->Peek(cpu.pc);
+
+        // Sized by the disassembler, not the CPU table, so opcodes the CPU hasn't got
+        // yet still log their operands. Peeked so the program's reads are all that's
+        // on the bus.
+        auto const size = Opcode(record.opcode).size;
+        if (size > 1)
+            record.operands[0] = cpu.memoryBus->Peek(cpu.pc + 1);
+        if (size > 2)
+            record.operands[1] = cpu.memoryBus->Peek(cpu.pc + 2);
+
+        record.a = cpu.a;
+        record.x = cpu.x;
+        record.y = cpu.y;
+        record.p = cpu.s;
+        record.sp = cpu.sp;
+        record.cycle = static_cast<uint32_t>(cycle);
+        Push(record);
+    }
+
+    // After it ran.
+    void AddCycles(uint32_t cycles) { cycle += cycles; }
+
+    // Where the count starts, nestest logs start at 7 for the reset sequence.
+    void SetCycle(uint64_t value) { cycle = value; }
+
+    void Push(TraceRecord const& record)
+    {
+        auto const position = head.load(std::memory_order_relaxed);
+        if (position - tailSeen == ring.size())
+        {
+            tailSeen = tail.load(std::memory_order_acquire);
+            if (position - tailSeen == ring.size())
+                WaitForSpace(position);
+        }
+
+        ring[position & mask] = record;
+        head.store(position + 1, std::memory_order_release);
+    }
+
+    uint64_t Records() const { return head.load(std::memory_order_relaxed); }
+    uint64_t Stalls() const { return stalls; }
+    uint64_t BytesWritten() const { return bytesWritten.load(std::memory_order_relaxed); }
+
+private:
+    void WaitForSpace(uint64_t position);
+    void Writer();
+    void WriteBlock(uint64_t first, size_t count);
+
+    std::ofstream file;
+    std::vector<TraceRecord> ring;
+    size_t mask;
+    uint64_t cycle = 0;
+
+    // Producer side
+    alignas(64) std::atomic<uint64_t> head = 0;
+    uint64_t tailSeen = 0;
+    uint64_t stalls = 0;
+
+    // Consumer side
+    alignas(64) std::atomic<uint64_t> tail = 0;
+    std::atomic<uint64_t> bytesWritten = 0;
+    std::atomic<bool> stopping = false;
+    std::vector<uint8_t> columns;
+    std::vector<uint8_t> block;
+    std::thread writer;
+};
+
+// Reads a trace back a record at a time, it's usually far too big to load whole.
+class TraceReader
+{
+public:
+    static std::optional<TraceReader> Open(std::string const& filename);
+
+    // False at the end, or if the file is cut short. cycle has the full count.
+    bool Next(TraceRecord& record, uint64_t& cycle);
+
+private:
+    bool ReadBlock();
+
+    std::ifstream file;
+    std::vector<TraceRecord> records;
+    size_t next = 0;
+    uint64_t cycleHigh = 0;
+    uint32_t lastCycle = 0;
+};
+
+// A line in the same layout as nestest.log, so the two can be diffed:
+// "C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7"
+// Memory values ("= 00") aren't in the trace so they're left off.
+std::string FormatNestest(TraceRecord const& record, uint64_t cycle);
+
+} // nes
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace nes
+{
+
+// One producer, one consumer, neither ever waits for the other. The producer always
+// has a back slot to write, the consumer always has a front slot to read, and the
+// third sits in the middle holding the newest finished one. Publishing swaps back
+// and middle, acquiring swaps middle and front, each a single atomic exchange. If
+// the producer publishes twice before the consumer looks, the older one is gone.
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(TripleBuffer const&) = delete;
+    TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+    // Producer side. Fill Back, then Publish. True if that threw away a frame the
+    // consumer never saw.
+    T& Back() { return slots[back].value; }
+
+    bool Publish()
+    {
+        auto const previous = middle.exchange(static_cast<uint8_t>(back | Fresh), std::memory_order_acq_rel);
+        back = previous & IndexMask;
+        sequence.fetch_add(1, std::memory_order_release);
+        sequence.notify_one();
+        return (previous & Fresh) != 0;
+    }
+
+    // Consumer side. True if Front is now something it hasn't seen, otherwise Front
+    // is still whatever it was.
+    bool Acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh))
+            return false;
+
+        auto const previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & IndexMask;
+        return true;
+    }
+
+    T const& Front() const { return slots[front].value; }
+    T& Front() { return slots[front].value; } // Only ever the consumer's, so it can write there too
+
+    // For a consumer with nothing better to do. Take Sequence, try Acquire, and if
+    // that found nothing, Wait on the sequence from before. Can't miss a publish
+    // that way round.
+    uint64_t Sequence() const { return sequence.load(std::memory_order_acquire); }
+    void Wait(uint64_t seen) const { sequence.wait(seen, std::memory_order_acquire); }
+
+    // Wakes a waiting consumer without publishing anything, for shutting down.
+    void Interrupt()
+    {
+        sequence.fetch_add(1, std::memory_order_release);
+        sequence.notify_all();
+    }
+
+private:
+    static constexpr uint8_t IndexMask = 0x03;
+    static constexpr uint8_t Fresh = 0x04;
+
+    // Own cache lines, so the two sides only ever share the one they swap through
+    struct alignas(64) Slot
+    {
+        T value {};
+    };
+
+    std::array<Slot, 3> slots;
+    alignas(64) std::atomic<uint8_t> middle { 1 };
+    std::atomic<uint64_t> sequence { 0 };
+    alignas(64) uint8_t back = 0;  // Producer's
+    alignas(64) uint8_t front = 2; // Consumer's
+};
+
+} // nes
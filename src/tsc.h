@@ -0,0 +1,28 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace nes
+{
+
+// Host cycle counter for measuring really short things. Invariant TSC on anything
+// recent, so it ticks at a constant rate whatever the clock speed is doing. Falls
+// back to nanoseconds where there's no TSC.
+inline uint64_t ReadTimestampCounter()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // nes
@@ -0,0 +1,164 @@
+#include "zones.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nes
+{
+
+struct ZoneEvent
+{
+    char const* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct ZoneBuffer
+{
+    uint32_t id;
+    std::string name;
+    std::vector<ZoneEvent> events;
+    size_t dropped = 0;
+};
+
+// Buffers belong to this, not the thread, so zones from threads that have finished
+// still get exported.
+struct ZoneRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ZoneBuffer>> buffers;
+
+    // For turning ticks into microseconds at export
+    uint64_t startTicks = ReadTimestampCounter();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+};
+
+static ZoneRegistry& Registry()
+{
+    static ZoneRegistry registry;
+    return registry;
+}
+
+static thread_local ZoneBuffer* threadBuffer = nullptr;
+
+static ZoneBuffer& ThreadBuffer()
+{
+    if (!threadBuffer)
+    {
+        auto& registry = Registry();
+        std::lock_guard lock(registry.mutex);
+
+        auto buffer = std::make_unique<ZoneBuffer>();
+        buffer->id = static_cast<uint32_t>(registry.buffers.size() + 1);
+        buffer->name = "thread " + std::to_string(buffer->id);
+        buffer->events.reserve(ZoneBufferCapacity);
+        threadBuffer = buffer.get();
+        registry.buffers.push_back(std::move(buffer));
+    }
+
+    return *threadBuffer;
+}
+
+void RecordZone(char const* name, uint64_t startTicks, uint64_t endTicks)
+{
+    auto& buffer = ThreadBuffer();
+    if (buffer.events.size() == ZoneBufferCapacity)
+    {
+        buffer.dropped++;
+        return;
+    }
+
+    buffer.events.push_back({ name, startTicks, endTicks });
+}
+
+void NameZoneThread(std::string name)
+{
+    ThreadBuffer().name = std::move(name);
+}
+
+static void WriteString(std::ostream& stream, std::string const& text)
+{
+    stream << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            stream << '\\';
+        stream << c;
+    }
+    stream << '"';
+}
+
+void WriteZoneTrace(std::ostream& stream)
+{
+    auto& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+
+    // Calibrate against the steady clock over the whole run so far, long enough to be accurate.
+    using namespace std::chrono;
+    auto const elapsedTicks = ReadTimestampCounter() - registry.startTicks;
+    auto const elapsed = duration<double, std::micro>(steady_clock::now() - registry.startTime).count();
+    double const ticksPerMicrosecond = elapsed > 0 && elapsedTicks > 0 ? elapsedTicks / elapsed : 1.0;
+
+    // The first zone started before it made the registry, so go from the earliest thing we have
+    uint64_t origin = registry.startTicks;
+    for (auto const& buffer : registry.buffers)
+        for (auto const& event : buffer->events)
+            origin = std::min(origin, event.start);
+
+    stream << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] { stream << (first ? "" : ",\n"); first = false; };
+
+    for (auto const& buffer : registry.buffers)
+    {
+        separator();
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+        WriteString(stream, buffer->name);
+        stream << "}}";
+
+        for (auto const& event : buffer->events)
+        {
+            double const start = (event.start - origin) / ticksPerMicrosecond;
+            double const duration = (event.end - event.start) / ticksPerMicrosecond;
+
+            char line[160];
+            snprintf(line, sizeof(line), ",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f,\"dur\":%.3f}",
+                     buffer->id, start, duration);
+
+            separator();
+            stream << "{\"name\":";
+            WriteString(stream, event.name);
+            stream << line;
+        }
+    }
+
+    stream << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void ClearZones()
+{
+    auto& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+    for (auto& buffer : registry.buffers)
+    {
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
+
+size_t DroppedZones()
+{
+    auto& registry = Registry();
+    std::lock_guard lock(registry.mutex);
+
+    size_t dropped = 0;
+    for (auto const& buffer : registry.buffers)
+        dropped += buffer->dropped;
+    return dropped;
+}
+
+} // nes
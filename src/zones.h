@@ -0,0 +1,57 @@
+#pragma once
+
+#include "tsc.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Where host time goes, per thread, for chrome://tracing or ui.perfetto.dev.
+//
+//   NES_ZONE("cpu");
+//
+// times the rest of the enclosing scope on the current thread. Zones only exist in
+// builds configured with NES_ZONES=ON that aren't Release, everywhere else the
+// macro is nothing at all.
+#if NES_ENABLE_ZONES
+#define NES_ZONE_JOIN2(a, b) a##b
+#define NES_ZONE_JOIN(a, b) NES_ZONE_JOIN2(a, b)
+#define NES_ZONE(name) ::nes::ZoneScope NES_ZONE_JOIN(nesZone, __LINE__)(name)
+#else
+#define NES_ZONE(name) static_cast<void>(0)
+#endif
+
+namespace nes
+{
+
+// Each thread gets its own buffer the first time it records, so recording never
+// takes a lock. Once one's full further zones on that thread are dropped and counted.
+constexpr size_t ZoneBufferCapacity = 1 << 16;
+
+// name has to outlive the export, a string literal in practice.
+void RecordZone(char const* name, uint64_t startTicks, uint64_t endTicks);
+
+// Shows up as the thread's name in the viewer instead of a number.
+void NameZoneThread(std::string name);
+
+// Chrome trace event JSON. Only while nothing is recording, the buffers aren't locked.
+void WriteZoneTrace(std::ostream& stream);
+
+void ClearZones();
+size_t DroppedZones();
+
+class ZoneScope
+{
+public:
+    explicit ZoneScope(char const* name) : name(name), start(ReadTimestampCounter()) {}
+    ~ZoneScope() { RecordZone(name, start, ReadTimestampCounter()); }
+
+    ZoneScope(ZoneScope const&) = delete;
+    ZoneScope& operator=(ZoneScope const&) = delete;
+
+private:
+    char const* name;
+    uint64_t start;
+};
+
+} // nes
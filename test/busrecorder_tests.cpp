@@ -0,0 +1,72 @@
+#include "../src/busrecorder.h"
+#include "../src/cpu.h"
+#include "../src/flatmemory.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+TEST(BusRecorderTest, Records_Accesses_In_Order_With_Cycles)
+{
+    auto memory = std::make_unique<nes::FlatMemory>();
+    memory->data[0x10] = 0x42;
+    nes::BusRecorder recorder(*memory);
+
+    EXPECT_EQ(recorder.Fetch(0x10), 0x42);
+    recorder.Write(0x20, 0x99);
+    EXPECT_EQ(recorder.Read(0x20), 0x99);
+    EXPECT_EQ(memory->data[0x20], 0x99);
+
+    auto const events = recorder.Events();
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].cycle, 0);
+    EXPECT_EQ(events[0].kind, nes::BusKind::Fetch);
+    EXPECT_EQ(events[1].cycle, 1);
+    EXPECT_EQ(events[1].address, 0x20);
+    EXPECT_EQ(events[1].value, 0x99);
+    EXPECT_EQ(events[1].kind, nes::BusKind::Write);
+    EXPECT_EQ(events[2].kind, nes::BusKind::Read);
+
+    recorder.Clear();
+    EXPECT_TRUE(recorder.Events().empty());
+}
+
+TEST(BusRecorderTest, Full_Buffer_Drops_Without_Growing)
+{
+    auto memory = std::make_unique<nes::FlatMemory>();
+    nes::BusRecorder recorder(*memory, 4);
+    auto const* buffer = recorder.Events().data();
+
+    for (uint16_t i = 0; i < 10; i++)
+        recorder.Write(i, static_cast<uint8_t>(i));
+
+    EXPECT_EQ(recorder.Events().size(), 4);
+    EXPECT_EQ(recorder.Events().data(), buffer);
+    EXPECT_EQ(recorder.Dropped(), 6);
+    EXPECT_EQ(memory->data[9], 9); // Still went through
+    EXPECT_EQ(recorder.Compare(recorder.Events()), 4u); // Can't say it matches with bits missing
+}
+
+TEST(BusRecorderTest, Compare_Finds_First_Difference)
+{
+    auto memory = std::make_unique<nes::FlatMemory>();
+    memory->data[0x0200] = 0xA5; // LDA $10
+    memory->data[0x0201] = 0x10;
+    memory->data[0x0010] = 0x77;
+
+    nes::BusRecorder recorder(*memory);
+    nes::CPU cpu(&recorder);
+    cpu.pc = 0x0200;
+    cpu.Step();
+
+    std::vector<nes::BusEvent> expected = {
+        { 0, 0x0200, 0xA5, nes::BusKind::Read }, // Fetch and read are the same on the bus
+        { 1, 0x0201, 0x10, nes::BusKind::Read },
+        { 2, 0x0010, 0x77, nes::BusKind::Read },
+    };
+    EXPECT_FALSE(recorder.Compare(expected).has_value());
+
+    expected[2].value = 0x78;
+    EXPECT_EQ(recorder.Compare(expected), 2u);
+
+    expected.pop_back();
+    EXPECT_EQ(recorder.Compare(expected), 2u);
+}
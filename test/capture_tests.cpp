@@ -0,0 +1,86 @@
+#include "../src/capture.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+static std::vector<uint8_t> ReadFile(std::string const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+TEST(CaptureTest, StreamWriter_Writes_Everything_In_Order)
+{
+    auto const path = testing::TempDir() + "capture_stream.bin";
+    std::vector<uint8_t> expected;
+    {
+        auto writer = nes::StreamWriter::Open(path, 2); // Small, so Acquire has to wait
+        ASSERT_TRUE(writer);
+        for (int i = 0; i < 200; i++)
+        {
+            auto buffer = writer->Acquire();
+            buffer.assign(1000 + i, static_cast<uint8_t>(i));
+            expected.insert(expected.end(), buffer.begin(), buffer.end());
+            writer->Submit(std::move(buffer));
+        }
+        writer->Flush();
+        EXPECT_EQ(writer->BytesWritten(), expected.size());
+        EXPECT_FALSE(writer->Failed());
+    }
+
+    EXPECT_EQ(ReadFile(path), expected);
+    std::remove(path.c_str());
+}
+
+TEST(CaptureTest, Y4m_Header_And_Planes)
+{
+    auto const path = testing::TempDir() + "capture.y4m";
+    {
+        auto writer = nes::StreamWriter::Open(path);
+        auto palette = nes::Palette::Default();
+        palette.colors[0x20] = 0xFFFFFF;
+        palette.colors[0x0F] = 0x000000;
+        nes::Y4mWriter video(*writer, palette);
+        video.WriteFrame(*SolidFrame(0x20));
+        video.WriteFrame(*SolidFrame(0x0F));
+    }
+
+    auto const bytes = ReadFile(path);
+    std::string const header = "YUV4MPEG2 W256 H240 F39375000:655171 Ip A1:1 C444\n";
+    size_t const frameBytes = 6 + nes::FrameWidth * nes::FrameHeight * 3;
+    ASSERT_EQ(bytes.size(), header.size() + 2 * frameBytes);
+    EXPECT_EQ(std::string(bytes.begin(), bytes.begin() + header.size()), header);
+    EXPECT_EQ(std::string(bytes.begin() + header.size(), bytes.begin() + header.size() + 6), "FRAME\n");
+    EXPECT_EQ(bytes[header.size() + 6], 235); // White luma
+    EXPECT_EQ(bytes[header.size() + frameBytes + 6], 16);  // Black luma
+    EXPECT_EQ(bytes.back(), 128);                          // No chroma
+    std::remove(path.c_str());
+}
+
+TEST(CaptureTest, Wav_Sizes_Filled_In_On_Finish)
+{
+    auto const path = testing::TempDir() + "capture.wav";
+    {
+        auto writer = nes::StreamWriter::Open(path);
+        nes::WavWriter audio(*writer, 48000);
+        std::vector<int16_t> const samples = { 1, -1, 300 };
+        audio.WriteSamples(samples);
+        audio.WriteSamples(samples);
+        audio.Finish();
+    }
+
+    auto const bytes = ReadFile(path);
+    ASSERT_EQ(bytes.size(), 44 + 12);
+    auto read32 = [&bytes](size_t at) {
+        return static_cast<uint32_t>(bytes[at] | bytes[at + 1] << 8 | bytes[at + 2] << 16 | bytes[at + 3] << 24);
+    };
+    EXPECT_EQ(read32(4), 36 + 12);
+    EXPECT_EQ(read32(24), 48000);
+    EXPECT_EQ(read32(40), 12);
+    EXPECT_EQ(bytes[44 + 2], 0xFF); // -1
+    std::remove(path.c_str());
+}
@@ -0,0 +1,91 @@
+#include "../src/cartridge.h"
+#include "../src/console.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+static std::vector<uint8_t> MakeRom(uint8_t prgBanks, uint8_t chrBanks, bool trainer = false)
+{
+    size_t const prgStart = sizeof(nes::Header) + (trainer ? nes::TrainerSize : 0);
+    size_t const prgSize = prgBanks * nes::ProgRomBankSize;
+    std::vector<uint8_t> bytes(prgStart + prgSize + chrBanks * nes::ChrRomBankSize, 0xCC);
+
+    nes::Header header = { { 'N', 'E', 'S', 0x1A }, prgBanks, chrBanks, static_cast<uint8_t>(trainer ? 0x04 : 0x00), 0, 0, 0, 0, { 0 } };
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    // Each PRG bank filled with its 1 based bank number
+    for (size_t i = 0; i < prgSize; i++)
+        bytes[prgStart + i] = static_cast<uint8_t>(i / nes::ProgRomBankSize + 1);
+    return bytes;
+}
+
+TEST(CartridgeTest, Parse_Reads_Banks)
+{
+    auto cartridge = nes::Cartridge::Parse(MakeRom(2, 1));
+
+    ASSERT_TRUE(cartridge);
+    EXPECT_EQ(cartridge->prgRom.size(), 2 * nes::ProgRomBankSize);
+    EXPECT_EQ(cartridge->chrRom.size(), nes::ChrRomBankSize);
+    EXPECT_EQ(cartridge->prgRom.back(), 2);
+    EXPECT_EQ(cartridge->Mapper(), 0);
+}
+
+TEST(CartridgeTest, Parse_Skips_Trainer)
+{
+    auto cartridge = nes::Cartridge::Parse(MakeRom(1, 0, true));
+
+    ASSERT_TRUE(cartridge);
+    EXPECT_EQ(cartridge->prgRom.front(), 1);
+}
+
+TEST(CartridgeTest, Parse_Rejects_Bad_Files)
+{
+    auto truncated = MakeRom(2, 1);
+    truncated.resize(truncated.size() - 1);
+    auto badMagic = MakeRom(1, 0);
+    badMagic[3] = 0;
+
+    EXPECT_FALSE(nes::Cartridge::Parse(truncated));
+    EXPECT_FALSE(nes::Cartridge::Parse(badMagic));
+    EXPECT_FALSE(nes::Cartridge::Parse(std::vector<uint8_t>(4)));
+}
+
+TEST(CartridgeTest, Only_Nrom_Is_Supported)
+{
+    EXPECT_EQ(nes::Cartridge::Parse(MakeRom(1, 0))->Unsupported(), nullptr);
+    EXPECT_EQ(nes::Cartridge::Parse(MakeRom(2, 1))->Unsupported(), nullptr);
+    EXPECT_NE(nes::Cartridge::Parse(MakeRom(3, 0))->Unsupported(), nullptr); // 48K would mirror wrong
+
+    auto mapper = MakeRom(8, 0); // 128K, would need banking
+    mapper[6] = 0x10;
+    EXPECT_NE(nes::Cartridge::Parse(mapper)->Unsupported(), nullptr);
+}
+
+TEST(CartridgeTest, Small_Rom_Is_Mirrored)
+{
+    std::vector<uint8_t> ram(0x800);
+    std::vector<uint8_t> rom(nes::ProgRomBankSize);
+    rom[0x0000] = 0x11;
+    rom[0x3FFC] = 0x22;
+
+    nes::CPUMemory memory(ram);
+    memory.SetPrgRom(rom);
+
+    EXPECT_EQ(memory.Read(0x8000), 0x11);
+    EXPECT_EQ(memory.Read(0xC000), 0x11);
+    EXPECT_EQ(memory.Read(0xBFFC), 0x22);
+    EXPECT_EQ(memory.Read(0xFFFC), 0x22);
+}
+
+TEST(CartridgeTest, Console_Resets_To_Rom_Vector)
+{
+    auto bytes = MakeRom(1, 0);
+    // Reset vector is the last 4 bytes but 2 of the bank, point it at $C123
+    bytes[16 + 0x3FFC] = 0x23;
+    bytes[16 + 0x3FFD] = 0xC1;
+
+    auto cartridge = std::make_shared<nes::Cartridge const>(*nes::Cartridge::Parse(bytes));
+    nes::Console console(cartridge);
+    console.Reset();
+
+    EXPECT_EQ(console.cpu.pc, 0xC123);
+}
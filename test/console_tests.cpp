@@ -0,0 +1,82 @@
+#include "../src/console.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+
+TEST(ConsoleTest, RunFrame_Advances_To_Frame_Boundary)
+{
+    nes::Console console;
+    console.Reset();
+
+    console.RunFrame();
+
+    EXPECT_EQ(console.frame, 1);
+    EXPECT_GE(console.cycles, nes::CyclesPerFrame);
+    EXPECT_LT(console.cycles, nes::CyclesPerFrame + 8); // Longest instruction is 7 cycles
+    EXPECT_GT(console.instructions, 0);
+}
+
+TEST(ConsoleTest, RunFrame_Carries_Overshoot)
+{
+    nes::Console console;
+    console.Reset();
+
+    for (int i = 0; i < 10; i++)
+        console.RunFrame();
+
+    // RAM is all 2 cycle NOPs, so frames can't drift by more than one instruction.
+    EXPECT_EQ(console.frame, 10);
+    EXPECT_GE(console.cycles, 10 * nes::CyclesPerFrame);
+    EXPECT_LT(console.cycles, 10 * nes::CyclesPerFrame + 2);
+}
+
+TEST(ConsoleTest, Unimplemented_Opcode_Is_Skipped)
+{
+    nes::Console console;
+    console.ram[0] = 0x02; // Not in the instruction table
+    console.Reset();
+
+    auto cycles = console.cpu.Step();
+
+    EXPECT_EQ(cycles, 2);
+    EXPECT_EQ(console.cpu.pc, 0x0001);
+}
+
+TEST(ConsoleTest, Counters_Published_Every_Frame)
+{
+    // LDY #1, then loop LDA $02FF,Y (crosses into $0300), STA $0300, JMP back
+    nes::Console console(MakeTestCartridge({ 0xA0, 0x01, 0xB9, 0xFF, 0x02, 0x8D, 0x00, 0x03, 0x4C, 0x02, 0xC0 }));
+    console.Reset();
+
+    console.RunFrame();
+    console.RunFrame();
+    auto const counters = console.counters.Snapshot();
+
+    EXPECT_EQ(counters.frames, 2);
+    EXPECT_EQ(counters.instructions, console.instructions);
+    EXPECT_EQ(counters.cycles, console.cycles);
+    EXPECT_EQ(counters.pageCrossings, (console.instructions + 1) / 3); // Every LDA
+    EXPECT_EQ(counters.slowAccesses, 0);
+#if NES_BUS_COUNTERS
+    EXPECT_GT(counters.reads[nes::RegionPrgRom], counters.instructions);
+    EXPECT_EQ(counters.reads[nes::RegionRam], counters.pageCrossings);
+    EXPECT_EQ(counters.writes[nes::RegionRam], counters.instructions / 3);
+#endif
+    EXPECT_GT(counters.totalFrameNanoseconds, 0);
+}
+
+TEST(ConsoleTest, Counters_Keep_Going_Up_After_Load)
+{
+    nes::Console console;
+    console.Reset();
+    nes::ConsoleState state;
+    console.Save(state);
+
+    console.RunFrame();
+    console.Load(state);
+    console.RunFrame();
+    auto const counters = console.counters.Snapshot();
+
+    EXPECT_EQ(console.frame, 1);
+    EXPECT_EQ(counters.frames, 2);
+    EXPECT_EQ(counters.instructions, 2 * console.instructions);
+}
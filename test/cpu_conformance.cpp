@@ -0,0 +1,120 @@
+// Whole single step corpus against CPU::Step, one job per opcode file across every
+// core. Opcodes the CPU doesn't do yet are skipped, not failed.
+//
+//   CPU_Conformance path/to/nes6502/v1 [--threads N] [--opcode a9] [--bus]
+//
+// --bus also checks every bus access against the corpus cycle by cycle, dummy
+// reads included.
+//
+// Registered with ctest when NES_SINGLESTEP_DIR is set at configure time.
+
+#include "scheduler.h"
+#include "singlestep.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+struct FileRun
+{
+    std::filesystem::path path;
+    uint8_t opcode;
+    bool skipped = false;
+    SingleStepResult result;
+};
+
+int main(int argc, char* argv[])
+{
+    std::string directory;
+    std::string only;
+    unsigned threads = 0;
+    bool checkBus = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--opcode" && i + 1 < argc)
+            only = argv[++i];
+        else if (arg == "--bus")
+            checkBus = true;
+        else if (directory.empty() && arg[0] != '-')
+            directory = arg;
+        else
+            directory.clear(), i = argc;
+    }
+
+    std::error_code error;
+    if (directory.empty() || !std::filesystem::is_directory(directory, error))
+    {
+        printf("usage: CPU_Conformance path/to/nes6502/v1 [--threads N] [--opcode a9] [--bus]\n");
+        return 1;
+    }
+
+    // "a9.json" and so on
+    std::vector<FileRun> runs;
+    for (auto const& entry : std::filesystem::directory_iterator(directory))
+    {
+        auto const stem = entry.path().stem().string();
+        if (entry.path().extension() != ".json" || stem.size() != 2 || (!only.empty() && stem != only))
+            continue;
+
+        char* end;
+        auto const opcode = std::strtoul(stem.c_str(), &end, 16);
+        if (*end != '\0')
+            continue;
+
+        FileRun run;
+        run.path = entry.path();
+        run.opcode = static_cast<uint8_t>(opcode);
+        runs.push_back(std::move(run));
+    }
+    std::sort(runs.begin(), runs.end(), [](auto const& a, auto const& b) { return a.opcode < b.opcode; });
+
+    auto const start = std::chrono::steady_clock::now();
+    {
+        nes::JobScheduler scheduler(threads, true);
+        for (auto& run : runs)
+        {
+            if (nes::CPU::Info(run.opcode).instruction == nullptr)
+            {
+                run.skipped = true;
+                continue;
+            }
+
+            scheduler.Submit([&run, checkBus] {
+                std::ifstream file(run.path, std::ios::binary);
+                run.result = RunSingleStepFile(file, checkBus);
+            });
+        }
+        scheduler.Wait();
+    }
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t cases = 0, failures = 0, skipped = 0, failedOpcodes = 0;
+    for (auto const& run : runs)
+    {
+        if (run.skipped)
+        {
+            skipped++;
+            continue;
+        }
+
+        cases += run.result.cases;
+        failures += run.result.failures;
+        if (!run.result.parsed)
+            printf("%02x: couldn't parse %s after %zu cases\n", run.opcode, run.path.string().c_str(), run.result.cases);
+        if (run.result.failures > 0)
+        {
+            failedOpcodes++;
+            printf("%02x: %zu/%zu failed, first %s\n", run.opcode, run.result.failures, run.result.cases,
+                   run.result.firstFailure.c_str());
+        }
+    }
+
+    bool const parsed = std::all_of(runs.begin(), runs.end(), [](auto const& run) { return run.skipped || run.result.parsed; });
+    printf("%zu cases from %zu opcodes in %.2fs, %zu failed in %zu opcodes, %zu opcodes skipped\n", cases,
+           runs.size() - skipped, seconds, failures, failedOpcodes, skipped);
+    return failures == 0 && parsed && cases > 0 ? 0 : 1;
+}
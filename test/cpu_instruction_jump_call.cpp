@@ -52,4 +52,38 @@ TEST_F(CpuTests, JMP_Indirect_Sets_ProgramCounter_Bug)
     EXPECT_TRUE(!(flags ^ cpu.s));
     EXPECT_EQ(cpu.pc, 0x2000);
     EXPECT_EQ(cycles, 5);
-}
\ No newline at end of file
+}
+TEST_F(CpuTests, JSR_Pushes_Return_Address_Minus_One)
+{
+    cpu.memoryBus->Write(0x1000, 0x20);
+    cpu.memoryBus->Write(0x1001, 0x34);
+    cpu.memoryBus->Write(0x1002, 0x12);
+
+    cpu.Reset();
+    uint8_t cycles = 0;
+    uint8_t flags = cpu.s;
+    cycles += cpu.Step();
+
+    EXPECT_TRUE(!(flags ^ cpu.s));
+    EXPECT_EQ(cpu.pc, 0x1234);
+    EXPECT_EQ(cpu.sp, 0xFB);
+    EXPECT_EQ(cpu.memoryBus->Read(0x01FD), 0x10);
+    EXPECT_EQ(cpu.memoryBus->Read(0x01FC), 0x02);
+    EXPECT_EQ(cycles, 6);
+}
+
+TEST_F(CpuTests, RTS_Returns_After_JSR)
+{
+    cpu.memoryBus->Write(0x1000, 0x20);
+    cpu.memoryBus->Write(0x1001, 0x34);
+    cpu.memoryBus->Write(0x1002, 0x12);
+    cpu.memoryBus->Write(0x1234, 0x60);
+
+    cpu.Reset();
+    cpu.Step();
+    uint8_t cycles = cpu.Step();
+
+    EXPECT_EQ(cpu.pc, 0x1003);
+    EXPECT_EQ(cpu.sp, 0xFD);
+    EXPECT_EQ(cycles, 6);
+}
@@ -0,0 +1,40 @@
+#include "../fuzz/differential.h"
+#include <gtest/gtest.h>
+
+// CPU with one planted bug, so there's something for the harness to find.
+struct BrokenInx : nes::CPU
+{
+    using nes::CPU::CPU;
+
+    uint8_t Step()
+    {
+        bool const inx = memoryBus->Read(pc) == 0xE8;
+        auto const cycles = nes::CPU::Step();
+        if (inx)
+            x++;
+        return cycles;
+    }
+};
+
+TEST(DifferentialTest, Same_Core_Never_Diverges)
+{
+    auto runner = std::make_unique<DifferentialRunner<nes::CPU, nes::CPU>>();
+    for (uint64_t seed = 0; seed < 20; seed++)
+        EXPECT_FALSE(runner->Run(seed, 500).has_value()) << seed;
+    EXPECT_EQ(runner->Instructions(), 20 * 500);
+}
+
+TEST(DifferentialTest, Finds_Planted_Bug)
+{
+    auto runner = std::make_unique<DifferentialRunner<nes::CPU, BrokenInx>>();
+
+    // INX at $0200, the rest of the image is random
+    uint8_t const input[] = { 0x00, 0x02, 0x00, 0x10, 0x00, 0x20, 0xFD, 0xE8 };
+    auto const divergence = runner->Run(std::span<uint8_t const>(input), 10);
+
+    ASSERT_TRUE(divergence.has_value());
+    EXPECT_EQ(divergence->instruction, 0);
+    EXPECT_EQ(divergence->pc, 0x0200);
+    EXPECT_EQ(divergence->opcode, 0xE8);
+    EXPECT_EQ(divergence->what, " x 11 vs 12 bus f0200=E8 vs r0200=E8 f0200=E8 ");
+}
@@ -0,0 +1,125 @@
+#include "../filters/downsample.h"
+#include "../src/scheduler.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+TEST(DownsampleTest, Solid_Frame_Is_Its_Luma)
+{
+    auto const frame = SolidFrame(0x20);
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::Gray8);
+
+    for (auto mode : { nes::DownsampleMode::Area, nes::DownsampleMode::Max })
+    {
+        nes::Downsampler downsampler({ .mode = mode });
+        std::vector<uint8_t> out(downsampler.Bytes());
+        downsampler.Apply(*frame, out.data());
+        EXPECT_NEAR(out[0], lut[0x20], 1) << int(mode);
+        EXPECT_TRUE(std::all_of(out.begin(), out.end(), [&](uint8_t b) { return b == out[0]; })) << int(mode);
+    }
+}
+
+TEST(DownsampleTest, Full_Size_Matches_Gray8)
+{
+    auto const frame = NoiseFrame(1);
+    nes::Downsampler downsampler({ .width = nes::FrameWidth, .height = nes::FrameHeight });
+    std::vector<uint8_t> out(downsampler.Bytes());
+    downsampler.Apply(*frame, out.data());
+
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::Gray8);
+    for (size_t i = 0; i < out.size(); i++)
+        ASSERT_NEAR(out[i], lut[(*frame)[i]], 1) << i;
+}
+
+TEST(DownsampleTest, Area_Keeps_The_Average)
+{
+    auto const frame = NoiseFrame(2);
+    nes::Downsampler downsampler;
+    std::vector<uint8_t> out(downsampler.Bytes());
+    downsampler.Apply(*frame, out.data());
+
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::Gray8);
+    double in = 0;
+    for (auto pixel : *frame)
+        in += lut[pixel];
+    double const mean = std::accumulate(out.begin(), out.end(), 0.0) / out.size();
+    EXPECT_NEAR(mean, in / frame->size(), 1.0);
+}
+
+TEST(DownsampleTest, Max_Keeps_A_Lone_Pixel)
+{
+    auto frame = SolidFrame(0x0F);
+    (*frame)[100 * nes::FrameWidth + 37] = 0x30;
+
+    nes::Downsampler max({ .mode = nes::DownsampleMode::Max });
+    nes::Downsampler area;
+    std::vector<uint8_t> maxOut(max.Bytes());
+    std::vector<uint8_t> areaOut(area.Bytes());
+    max.Apply(*frame, maxOut.data());
+    area.Apply(*frame, areaOut.data());
+
+    // 37 * 84 / 256 and 100 * 84 / 240
+    size_t const at = 35 * 84 + 12;
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::Gray8);
+    EXPECT_NEAR(maxOut[at], lut[0x30], 1);
+    EXPECT_EQ(std::count(maxOut.begin(), maxOut.end(), 0), maxOut.size() - 1);
+    EXPECT_GT(areaOut[at], 0);
+    EXPECT_LT(areaOut[at], 64);
+}
+
+TEST(DownsampleTest, Crop_Drops_Lines)
+{
+    auto frame = SolidFrame(0x0F);
+    std::fill_n(frame->begin(), 8 * nes::FrameWidth, 0x30);
+    std::fill_n(frame->end() - 8 * nes::FrameWidth, 8 * nes::FrameWidth, 0x30);
+
+    nes::Downsampler downsampler({ .cropTop = 8, .cropBottom = 8, .mode = nes::DownsampleMode::Max });
+    std::vector<uint8_t> out(downsampler.Bytes());
+    downsampler.Apply(*frame, out.data());
+    EXPECT_TRUE(std::all_of(out.begin(), out.end(), [](uint8_t b) { return b == 0; }));
+}
+
+TEST(DownsampleTest, Simd_Matches_Scalar)
+{
+    auto const frame = NoiseFrame(3);
+    for (auto mode : { nes::DownsampleMode::Area, nes::DownsampleMode::Max })
+    {
+        for (auto [width, height] : { std::pair { 84u, 84u }, std::pair { 160u, 120u }, std::pair { 61u, 37u } })
+        {
+            nes::Downsampler downsampler({ .width = width, .height = height, .cropTop = 8, .mode = mode });
+            std::vector<uint8_t> simd(downsampler.Bytes());
+            std::vector<uint8_t> scalar(downsampler.Bytes());
+            downsampler.Apply(*frame, simd.data());
+            downsampler.ApplyScalar(*frame, scalar.data());
+            EXPECT_EQ(simd, scalar) << int(mode) << " " << width << "x" << height;
+        }
+    }
+}
+
+TEST(DownsampleTest, Batch_Matches_One_At_A_Time)
+{
+    std::vector<std::unique_ptr<nes::FrameBuffer>> frames;
+    std::vector<nes::FrameBuffer const*> pointers;
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        frames.push_back(NoiseFrame(10 + i));
+        pointers.push_back(frames.back().get());
+    }
+
+    nes::Downsampler downsampler;
+    std::vector<uint8_t> expected(downsampler.Bytes() * frames.size());
+    for (size_t i = 0; i < frames.size(); i++)
+        downsampler.Apply(*frames[i], expected.data() + downsampler.Bytes() * i);
+
+    nes::JobScheduler scheduler(2, false);
+    std::vector<uint8_t> batched(expected.size());
+    downsampler.ApplyBatch(pointers, batched.data(), &scheduler);
+    EXPECT_EQ(batched, expected);
+
+    std::fill(batched.begin(), batched.end(), 0);
+    downsampler.ApplyBatch(pointers, batched.data());
+    EXPECT_EQ(batched, expected);
+}
@@ -0,0 +1,73 @@
+#include "../src/framehash.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+TEST(FrameHashTest, Simd_Matches_Scalar)
+{
+    auto const frame = NoiseFrame(1);
+    nes::TileHashes simd, scalar;
+    nes::HashTiles(*frame, simd);
+    nes::HashTilesScalar(*frame, scalar);
+    EXPECT_EQ(simd, scalar);
+}
+
+TEST(FrameHashTest, One_Pixel_Dirties_Its_Tile)
+{
+    auto frame = NoiseFrame(2);
+    nes::TileHashes before, after;
+    nes::HashTiles(*frame, before);
+    nes::HashTiles(*frame, after);
+    EXPECT_EQ(nes::HashFrame(before), nes::HashFrame(after));
+    EXPECT_FALSE(nes::CompareTiles(before, after).Any());
+
+    (*frame)[123 * nes::FrameWidth + 77] ^= 0x40; // Just an emphasis bit
+    nes::HashTiles(*frame, after);
+    EXPECT_NE(nes::HashFrame(before), nes::HashFrame(after));
+
+    auto const dirty = nes::CompareTiles(before, after);
+    EXPECT_EQ(dirty.Count(), 1);
+    EXPECT_TRUE(dirty.Test(77 / 8, 123 / 8));
+}
+
+TEST(FrameHashTest, Same_Tile_Anywhere_Hashes_The_Same)
+{
+    // A tile's hash is only its pixels, so scrolled tiles can be matched up
+    auto frame = SolidFrame(0x0F);
+    for (unsigned y = 0; y < 8; y++)
+    {
+        (*frame)[y * nes::FrameWidth + y] = 0x30;
+        (*frame)[(16 + y) * nes::FrameWidth + 40 + y] = 0x30;
+    }
+
+    nes::TileHashes tiles;
+    nes::HashTiles(*frame, tiles);
+    EXPECT_EQ(tiles[0], tiles[2 * nes::TileColumns + 5]);
+    EXPECT_NE(tiles[0], tiles[1]);
+}
+
+TEST(FrameHashTest, Rects_Join_Runs_Down_Rows)
+{
+    nes::DirtyTiles dirty;
+    EXPECT_TRUE(dirty.Rects().empty());
+
+    for (unsigned row = 2; row < 5; row++)
+    {
+        dirty.Mark(3, row);
+        dirty.Mark(4, row);
+    }
+    dirty.Mark(31, 4);
+    dirty.Mark(0, 29);
+    dirty.Mark(3, 5); // Narrower than the run above, starts its own
+
+    auto const rects = dirty.Rects();
+    ASSERT_EQ(rects.size(), 4);
+    EXPECT_EQ(rects[0], (nes::TileRect { 24, 16, 16, 24 }));
+    EXPECT_EQ(rects[1], (nes::TileRect { 248, 32, 8, 8 }));
+    EXPECT_EQ(rects[2], (nes::TileRect { 24, 40, 8, 8 }));
+    EXPECT_EQ(rects[3], (nes::TileRect { 0, 232, 8, 8 }));
+
+    auto const all = nes::DirtyTiles::All().Rects();
+    ASSERT_EQ(all.size(), 1);
+    EXPECT_EQ(all[0], (nes::TileRect { 0, 0, nes::FrameWidth, nes::FrameHeight }));
+}
@@ -0,0 +1,181 @@
+#include "../src/framepipeline.h"
+#include "../src/triplebuffer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <latch>
+#include <thread>
+
+TEST(TripleBufferTest, Acquire_Gets_Newest)
+{
+    nes::TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.Acquire());
+
+    buffer.Back() = 1;
+    EXPECT_FALSE(buffer.Publish());
+    buffer.Back() = 2;
+    EXPECT_TRUE(buffer.Publish()); // 1 never got seen
+
+    EXPECT_TRUE(buffer.Acquire());
+    EXPECT_EQ(buffer.Front(), 2);
+    EXPECT_FALSE(buffer.Acquire());
+    EXPECT_EQ(buffer.Front(), 2);
+}
+
+TEST(TripleBufferTest, Frames_Never_Torn)
+{
+    // Every slot is filled with one number, so a slot both sides had at once shows
+    // up as a mix
+    using Block = std::array<uint64_t, 512>;
+    nes::TripleBuffer<Block> buffer;
+    constexpr uint64_t Frames = 20000;
+
+    std::thread producer([&buffer] {
+        for (uint64_t frame = 1; frame <= Frames; frame++)
+        {
+            buffer.Back().fill(frame);
+            buffer.Publish();
+        }
+    });
+
+    uint64_t last = 0;
+    bool torn = false, backwards = false;
+    while (last < Frames)
+    {
+        auto const seen = buffer.Sequence();
+        if (!buffer.Acquire())
+        {
+            buffer.Wait(seen);
+            continue;
+        }
+        auto const& block = buffer.Front();
+        for (auto value : block)
+            torn |= value != block[0];
+        backwards |= block[0] <= last;
+        last = block[0];
+    }
+    producer.join();
+
+    EXPECT_FALSE(torn);
+    EXPECT_FALSE(backwards);
+}
+
+TEST(FramePipelineTest, Slow_Presentation_Drops_Frames_Without_Stalling)
+{
+    nes::FramePacingOptions options;
+    options.emulationHz = 0;
+    options.frames = 200;
+
+    // The first present holds on until emulation has been all the way through, so
+    // everything in between has to be dropped rather than waited for
+    std::latch presenting(1), emulated(1);
+    bool first = true;
+    uint64_t lastNumber = 0;
+    nes::FramePipeline pipeline(
+        [&](nes::VideoFrame& frame) {
+            if (frame.number == 1)
+                presenting.wait();
+            if (frame.number == 199)
+                emulated.count_down();
+        },
+        [&](nes::VideoFrame const& frame) {
+            if (first)
+            {
+                first = false;
+                presenting.count_down();
+                emulated.wait();
+            }
+            lastNumber = frame.number;
+        },
+        options);
+    pipeline.Start();
+    pipeline.Wait();
+
+    auto const stats = pipeline.Stats();
+    EXPECT_EQ(stats.produced, 200);
+    EXPECT_GT(stats.dropped, 0);
+    EXPECT_EQ(stats.presented + stats.dropped, stats.produced);
+    EXPECT_EQ(lastNumber, 199); // Last one always makes it
+}
+
+TEST(FramePipelineTest, Fast_Refresh_Duplicates_Frames)
+{
+    nes::FramePacingOptions options;
+    options.emulationHz = 100;
+    options.presentHz = 400;
+    options.frames = 10;
+
+    nes::FramePipeline pipeline([](nes::VideoFrame&) {}, [](nes::VideoFrame const&) {}, options);
+    pipeline.Start();
+    pipeline.Wait();
+
+    auto const stats = pipeline.Stats();
+    EXPECT_EQ(stats.produced, 10);
+    EXPECT_GT(stats.duplicated, 0);
+    EXPECT_GE(stats.presented, stats.produced - stats.dropped);
+}
+
+TEST(FramePipelineTest, Digest_Dirty_Covers_Dropped_Frames)
+{
+    nes::FramePacingOptions options;
+    options.emulationHz = 0;
+    options.frames = 300;
+    options.digest = true;
+
+    // Frame n has the first n tiles lit, and the last 100 are the same as the one
+    // before, so what changed between any two frames is known exactly.
+    //
+    // The first present holds on until frame 150 so the ones in between get
+    // dropped, and from 200 on emulation waits for each frame to be presented so
+    // identical ones go one after another.
+    std::latch presenting(1), skipped(1);
+    std::atomic<int64_t> presented { -1 };
+    auto tiles = [](uint64_t number) { return std::min<uint64_t>(number, 200); };
+    auto produce = [&](nes::VideoFrame& frame) {
+        auto const number = static_cast<int64_t>(frame.number);
+        if (number == 1)
+            presenting.wait();
+        if (number == 150)
+            skipped.count_down();
+        for (int64_t seen = presented.load(); number > 200 && seen < number - 1; seen = presented.load())
+            presented.wait(seen);
+
+        frame.pixels.fill(0);
+        for (uint64_t tile = 0; tile < tiles(frame.number); tile++)
+            frame.pixels[(tile / nes::TileColumns) * 8 * nes::FrameWidth + (tile % nes::TileColumns) * 8] = 0x30;
+    };
+
+    int64_t last = -1;
+    bool allRight = true;
+    nes::FramePipeline pipeline(produce,
+                                [&](nes::VideoFrame const& frame) {
+                                    if (last < 0)
+                                    {
+                                        presenting.count_down();
+                                        skipped.wait();
+                                    }
+
+                                    auto const from = last < 0 ? 0 : tiles(static_cast<uint64_t>(last));
+                                    auto const to = tiles(frame.number);
+                                    if (last < 0)
+                                        allRight &= frame.dirty.Count() == nes::TileCount && frame.changed;
+                                    else
+                                        allRight &= frame.dirty.Count() == to - from && frame.changed == (to != from);
+                                    for (auto tile = from; tile < to; tile++)
+                                        allRight &= frame.dirty.Test(tile % nes::TileColumns, tile / nes::TileColumns);
+                                    last = static_cast<int64_t>(frame.number);
+
+                                    presented.store(last);
+                                    presented.notify_one();
+                                },
+                                options);
+    pipeline.Start();
+    pipeline.Wait();
+
+    auto const stats = pipeline.Stats();
+    EXPECT_TRUE(allRight);
+    EXPECT_GT(stats.dropped, 0);
+    EXPECT_GE(stats.unchanged, 99); // 201 to 299 at least
+    EXPECT_EQ(last, 299);
+}
@@ -0,0 +1,259 @@
+// Golden frame hash suite. Runs every ROM in the manifest for a fixed number of
+// frames, one scheduler job per ROM across every core, and compares Console::Hash
+// chained with a hash of the picture at checkpoints with the stored goldens.
+// Anything performance work breaks in the CPU, the bus or the PPU's drawing shows
+// up as a hash that moved.
+//
+//   NES_Golden test/golden/manifest.txt [--roms dir] [--threads N] [--update]
+//
+// --update writes goldens.txt from this run instead of checking against it. ROMs
+// that were skipped keep whatever goldens they had.
+
+#include "cartridge.h"
+#include "console.h"
+#include "goldenroms.h"
+#include "hash.h"
+#include "inputscript.h"
+#include "scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using Checkpoints = std::vector<std::pair<uint64_t, uint64_t>>; // Frame, hash
+
+struct GoldenRom
+{
+    std::string rom;
+    uint64_t frames = 0;
+    uint64_t every = 0;
+    std::string input;
+
+    bool skipped = false;
+    std::string error;
+    Checkpoints hashes;
+};
+
+static bool ReadManifest(std::filesystem::path const& path, std::vector<GoldenRom>& roms)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto const comment = line.find('#');
+        if (comment != std::string::npos)
+            line.resize(comment);
+
+        std::istringstream fields(line);
+        GoldenRom rom;
+        if (!(fields >> rom.rom))
+            continue;
+        if (!(fields >> rom.frames >> rom.every) || rom.every == 0)
+        {
+            printf("Bad manifest line: %s\n", line.c_str());
+            return false;
+        }
+        fields >> rom.input;
+        roms.push_back(std::move(rom));
+    }
+
+    return true;
+}
+
+// "rom frame hash" per line
+static std::map<std::string, Checkpoints> ReadGoldens(std::filesystem::path const& path)
+{
+    std::map<std::string, Checkpoints> goldens;
+    std::ifstream file(path);
+    std::string rom, hash;
+    uint64_t frame;
+    while (file >> rom >> frame >> hash)
+        goldens[rom].emplace_back(frame, std::strtoull(hash.c_str(), nullptr, 16));
+    return goldens;
+}
+
+static void Run(GoldenRom& entry, std::filesystem::path const& manifestDirectory, std::filesystem::path const& romDirectory)
+{
+    std::shared_ptr<nes::Cartridge const> cartridge;
+    if (entry.rom.rfind("builtin:", 0) == 0)
+    {
+        cartridge = MakeBuiltinCartridge(entry.rom.substr(8));
+        if (!cartridge)
+        {
+            entry.error = "no built in ROM called that";
+            return;
+        }
+    }
+    else
+    {
+        auto const path = romDirectory / entry.rom;
+        if (!std::filesystem::exists(path))
+        {
+            entry.skipped = true;
+            return;
+        }
+
+        auto loaded = nes::Cartridge::Load(path.string());
+        if (!loaded)
+        {
+            entry.error = "couldn't load " + path.string();
+            return;
+        }
+        if (auto const reason = loaded->Unsupported())
+        {
+            entry.error = "can't run " + path.string() + ", " + reason;
+            return;
+        }
+        cartridge = std::make_shared<nes::Cartridge const>(std::move(*loaded));
+    }
+
+    std::optional<nes::InputScript> script;
+    if (!entry.input.empty())
+    {
+        script = nes::InputScript::Load((manifestDirectory / entry.input).string());
+        if (!script)
+        {
+            entry.error = "couldn't read input " + entry.input;
+            return;
+        }
+    }
+
+    nes::Console console(cartridge);
+    console.inputScript = script ? &*script : nullptr;
+    console.Reset();
+
+    for (uint64_t frame = 1; frame <= entry.frames; frame++)
+    {
+        console.RunFrame();
+        if (frame % entry.every == 0)
+        {
+            // Console::Hash leaves the picture out so skipping drawing can be checked
+            // against it, but here the picture is the point
+            std::span<uint8_t const> const pixels(reinterpret_cast<uint8_t const*>(console.ppu.frame.data()),
+                                                  sizeof(console.ppu.frame));
+            entry.hashes.emplace_back(frame, nes::Hash64(pixels, console.Hash()));
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::filesystem::path manifest;
+    std::filesystem::path romDirectory = ".";
+    unsigned threads = 0;
+    bool update = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        if (arg == "--roms" && i + 1 < argc)
+            romDirectory = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--update")
+            update = true;
+        else if (manifest.empty() && arg[0] != '-')
+            manifest = arg;
+        else
+            manifest.clear(), i = argc;
+    }
+
+    std::vector<GoldenRom> roms;
+    if (manifest.empty() || !ReadManifest(manifest, roms))
+    {
+        printf("usage: NES_Golden manifest.txt [--roms dir] [--threads N] [--update]\n");
+        return 1;
+    }
+
+    auto const directory = manifest.parent_path();
+    auto const goldensPath = directory / "goldens.txt";
+    auto goldens = ReadGoldens(goldensPath);
+
+    auto const start = std::chrono::steady_clock::now();
+    {
+        nes::JobScheduler scheduler(threads, true);
+        for (auto& rom : roms)
+            scheduler.Submit([&rom, &directory, &romDirectory] { Run(rom, directory, romDirectory); });
+        scheduler.Wait();
+    }
+    auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0, skipped = 0;
+    for (auto const& rom : roms)
+    {
+        if (!rom.error.empty())
+        {
+            printf("%-36s ERROR %s\n", rom.rom.c_str(), rom.error.c_str());
+            failed++;
+        }
+        else if (rom.skipped)
+        {
+            printf("%-36s skipped, not found\n", rom.rom.c_str());
+            skipped++;
+        }
+        else if (update)
+        {
+            goldens[rom.rom] = rom.hashes;
+            printf("%-36s updated, %zu checkpoints\n", rom.rom.c_str(), rom.hashes.size());
+        }
+        else
+        {
+            auto const golden = goldens.find(rom.rom);
+            if (golden == goldens.end())
+            {
+                printf("%-36s FAIL no goldens, run with --update\n", rom.rom.c_str());
+                failed++;
+                continue;
+            }
+
+            auto mismatch = std::mismatch(rom.hashes.begin(), rom.hashes.end(), golden->second.begin(), golden->second.end());
+            if (mismatch.first == rom.hashes.end() && mismatch.second == golden->second.end())
+            {
+                printf("%-36s ok\n", rom.rom.c_str());
+                continue;
+            }
+
+            failed++;
+            if (mismatch.first == rom.hashes.end() || mismatch.second == golden->second.end())
+                printf("%-36s FAIL %zu checkpoints, goldens have %zu\n", rom.rom.c_str(), rom.hashes.size(), golden->second.size());
+            else
+                printf("%-36s FAIL frame %llu hash %016llx, golden %016llx\n", rom.rom.c_str(),
+                       static_cast<unsigned long long>(mismatch.first->first),
+                       static_cast<unsigned long long>(mismatch.first->second),
+                       static_cast<unsigned long long>(mismatch.second->second));
+        }
+    }
+
+    if (update && failed == 0)
+    {
+        // Manifest order, then anything that's no longer in the manifest is dropped
+        std::ofstream file(goldensPath);
+        for (auto const& rom : roms)
+        {
+            for (auto const& [frame, hash] : goldens[rom.rom])
+            {
+                char line[128];
+                snprintf(line, sizeof(line), "%s %llu %016llx\n", rom.rom.c_str(), static_cast<unsigned long long>(frame),
+                         static_cast<unsigned long long>(hash));
+                file << line;
+            }
+        }
+
+        if (!file)
+        {
+            printf("Couldn't write %s\n", goldensPath.string().c_str());
+            return 1;
+        }
+    }
+
+    printf("%zu ROMs in %.2fs, %zu failed, %zu skipped\n", roms.size(), seconds, failed, skipped);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#ifndef NES_GOLDENROMS_H
+#define NES_GOLDENROMS_H
+
+#include "testrom.h"
+#include <string>
+
+// Programs for the golden suite that don't need a ROM file, so the suite always
+// has something to run. Only opcodes CPU already does, and no branches yet, so
+// they're all one big loop that keeps changing RAM. MakeStatusSampler from
+// testrom.h is the one that draws, scrolling a little further every frame.
+
+// Arithmetic, shifts and the stack, results spread over zero page, $0300 and the stack page.
+inline std::vector<uint8_t> ArithmeticProgram()
+{
+    return {
+        0xA5, 0x00,       // LDA $00
+        0x18,             // CLC
+        0x65, 0x01,       // ADC $01
+        0x85, 0x00,       // STA $00
+        0x2A,             // ROL A
+        0x95, 0x10,       // STA $10,X
+        0xE9, 0x03,       // SBC #$03
+        0x9D, 0x00, 0x03, // STA $0300,X
+        0xE8,             // INX
+        0x0E, 0x00, 0x03, // ASL $0300
+        0xE6, 0x01,       // INC $01
+        0x48,             // PHA
+        0x4C, 0x00, 0xC0, // JMP $C000
+    };
+}
+
+// Indirect indexed stores through a moving pointer at $00, and reads back through
+// it and a mirror of RAM.
+inline std::vector<uint8_t> PointerProgram()
+{
+    return {
+        0xA9, 0x00,       // LDA #$00
+        0x85, 0x00,       // STA $00
+        0xA9, 0x02,       // LDA #$02
+        0x85, 0x01,       // STA $01
+        0x98,             // TYA              <- $C008
+        0x6D, 0x34, 0x12, // ADC $1234        (mirror of $0234)
+        0x91, 0x00,       // STA ($00),Y
+        0xC8,             // INY
+        0xE6, 0x00,       // INC $00
+        0xB1, 0x00,       // LDA ($00),Y
+        0xAA,             // TAX
+        0x7D, 0x00, 0x04, // ADC $0400,X
+        0x99, 0x00, 0x05, // STA $0500,Y
+        0x4C, 0x08, 0xC0, // JMP $C008
+    };
+}
+
+// "builtin:name" in the manifest. Null for names we don't know.
+inline std::shared_ptr<nes::Cartridge const> MakeBuiltinCartridge(std::string const& name)
+{
+    if (name == "padreader")
+        return MakeTestCartridge(PadReaderProgram());
+    if (name == "arithmetic")
+        return MakeTestCartridge(ArithmeticProgram());
+    if (name == "pointers")
+        return MakeTestCartridge(PointerProgram());
+    if (name == "sampler")
+        return MakeStatusSampler();
+    return nullptr;
+}
+
+#endif //NES_GOLDENROMS_H
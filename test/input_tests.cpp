@@ -0,0 +1,85 @@
+#include "../src/console.h"
+#include "../src/controller.h"
+#include "../src/inputscript.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(ControllerTest, Strobe_Then_Read_Shifts_Buttons_Out)
+{
+    std::vector<uint8_t> ram(0x800);
+    nes::CPUMemory memory(ram);
+    memory.controllers[0].buttons = nes::Controller::A | nes::Controller::Start | nes::Controller::Right;
+
+    memory.Write(0x4016, 1);
+    memory.Write(0x4016, 0);
+
+    uint8_t expected[] = { 1, 0, 0, 1, 0, 0, 0, 1, 1, 1 };
+    for (auto bit : expected)
+        EXPECT_EQ(memory.Read(0x4016) & 0x01, bit);
+}
+
+TEST(ControllerTest, Strobe_High_Keeps_Returning_A)
+{
+    nes::Controller controller;
+    controller.buttons = nes::Controller::A;
+    controller.Write(1);
+
+    EXPECT_EQ(controller.Read() & 0x01, 1);
+    EXPECT_EQ(controller.Read() & 0x01, 1);
+}
+
+TEST(ControllerTest, Second_Port_Is_Independent)
+{
+    std::vector<uint8_t> ram(0x800);
+    nes::CPUMemory memory(ram);
+    memory.controllers[1].buttons = nes::Controller::B;
+
+    memory.Write(0x4016, 1);
+    memory.Write(0x4016, 0);
+
+    EXPECT_EQ(memory.Read(0x4016) & 0x01, 0);
+    EXPECT_EQ(memory.Read(0x4017) & 0x01, 0);
+    EXPECT_EQ(memory.Read(0x4017) & 0x01, 1);
+}
+
+TEST(InputScriptTest, Parse_Holds_Buttons_Until_Next_Entry)
+{
+    std::stringstream text(
+        "# frame pad1 pad2\n"
+        "60   Start\n"
+        "\n"
+        "62   -\n"
+        "120  Right+A  B   # both pads\n");
+
+    auto script = nes::InputScript::Parse(text);
+
+    ASSERT_TRUE(script);
+    EXPECT_EQ(script->At(0)[0], 0);
+    EXPECT_EQ(script->At(60)[0], nes::Controller::Start);
+    EXPECT_EQ(script->At(61)[0], nes::Controller::Start);
+    EXPECT_EQ(script->At(62)[0], 0);
+    EXPECT_EQ(script->At(500)[0], nes::Controller::Right | nes::Controller::A);
+    EXPECT_EQ(script->At(500)[1], nes::Controller::B);
+}
+
+TEST(InputScriptTest, Parse_Rejects_Unknown_Buttons)
+{
+    std::stringstream text("10 Turbo\n");
+
+    EXPECT_FALSE(nes::InputScript::Parse(text));
+}
+
+TEST(InputScriptTest, Console_Applies_Script_Each_Frame)
+{
+    std::stringstream text("1 Up\n");
+    auto script = nes::InputScript::Parse(text);
+
+    nes::Console console;
+    console.inputScript = &*script;
+    console.Reset();
+
+    console.RunFrame();
+    EXPECT_EQ(console.memory.controllers[0].buttons, 0);
+    console.RunFrame();
+    EXPECT_EQ(console.memory.controllers[0].buttons, nes::Controller::Up);
+}
@@ -0,0 +1,151 @@
+#include "../src/console.h"
+#include "../src/cpumemory.h"
+#include "../src/heatmap.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+class CPUMemoryTest : public ::testing::Test
+{
+protected:
+    std::vector<uint8_t> ram = std::vector<uint8_t>(0x800);
+    std::vector<uint8_t> rom = std::vector<uint8_t>(0x4000);
+    nes::CPUMemory memory { ram };
+    std::vector<nes::WatchHit> hits;
+
+    void SetUp() override
+    {
+        for (size_t i = 0; i < rom.size(); i++)
+            rom[i] = static_cast<uint8_t>(i * 3);
+        memory.SetPrgRom(rom);
+        memory.onWatch = [this](nes::WatchHit const& hit) { hits.push_back(hit); };
+    }
+};
+
+TEST_F(CPUMemoryTest, Mirrors_Ram_And_Rom)
+{
+    memory.Write(0x0123, 0x42);
+    EXPECT_EQ(memory.Read(0x0923), 0x42);
+    EXPECT_EQ(memory.Read(0x1923), 0x42);
+    memory.Write(0x1FFF, 0x17);
+    EXPECT_EQ(ram[0x7FF], 0x17);
+
+    EXPECT_EQ(memory.Read(0x8005), rom[5]);
+    EXPECT_EQ(memory.Read(0xC005), rom[5]);
+    EXPECT_EQ(memory.Fetch(0xFFFF), rom[0x3FFF]);
+
+    memory.Write(0x8000, 0x99); // ROM
+    EXPECT_EQ(memory.Read(0x8000), rom[0]);
+}
+
+TEST_F(CPUMemoryTest, Pads_Still_Go_Through_The_Bus)
+{
+    memory.controllers[0].buttons = nes::Controller::A;
+    memory.Write(0x4016, 1);
+    memory.Write(0x4016, 0);
+    EXPECT_EQ(memory.Read(0x4016) & 1, 1);
+    EXPECT_EQ(memory.Read(0x4016) & 1, 0);
+}
+
+TEST_F(CPUMemoryTest, Watchpoints_Match_Range_And_Access)
+{
+    auto const id = memory.AddWatchpoint(0x0200, 0x02FF, nes::WatchWrite);
+    memory.AddWatchpoint(0xC000, 0xC000, nes::WatchExecute);
+
+    memory.Write(0x0210, 5);
+    memory.Write(0x0300, 6);            // Outside
+    EXPECT_EQ(memory.Read(0x0210), 5);  // Wrong access
+    memory.Fetch(0xC000);
+    memory.Read(0xC000);                // Read, not execute
+
+    ASSERT_EQ(hits.size(), 2);
+    EXPECT_EQ(hits[0].address, 0x0210);
+    EXPECT_EQ(hits[0].value, 5);
+    EXPECT_EQ(hits[0].access, nes::WatchWrite);
+    EXPECT_EQ(hits[0].watchpoint, id);
+    EXPECT_EQ(hits[1].address, 0xC000);
+    EXPECT_EQ(hits[1].value, rom[0]);
+    EXPECT_EQ(hits[1].access, nes::WatchExecute);
+
+    memory.RemoveWatchpoint(id);
+    memory.Write(0x0210, 7);
+    EXPECT_EQ(hits.size(), 2);
+    EXPECT_EQ(memory.Read(0x0A10), 7); // Back on the direct path, mirrors still right
+}
+
+TEST_F(CPUMemoryTest, Watchpoint_On_Mirror_Only_Sees_That_Mirror)
+{
+    memory.AddWatchpoint(0x0800, 0x0800, nes::WatchRead);
+    memory.Read(0x0000);
+    memory.Read(0x0800);
+    ASSERT_EQ(hits.size(), 1);
+    EXPECT_EQ(hits[0].address, 0x0800);
+}
+
+TEST_F(CPUMemoryTest, Peek_Leaves_No_Trace)
+{
+    nes::Heatmap heatmap;
+    memory.SetHeatmap(&heatmap);
+    memory.AddWatchpoint(0x0000, 0xFFFF, nes::WatchRead | nes::WatchExecute);
+    memory.Write(0x0123, 0x42);
+    memory.controllers[0].buttons = nes::Controller::A;
+    memory.Write(0x4016, 1);
+    memory.Write(0x4016, 0);
+    hits.clear();
+
+    EXPECT_EQ(memory.Peek(0x0923), 0x42);
+    EXPECT_EQ(memory.Peek(0xC005), rom[5]);
+    EXPECT_EQ(memory.Peek(0x4016), 0);
+    memory.SetHeatmap(nullptr);
+
+    EXPECT_TRUE(hits.empty());
+    EXPECT_EQ(heatmap.reads[0x0923], 0);
+    EXPECT_EQ(heatmap.reads[0xC005], 0);
+    EXPECT_EQ(memory.Read(0x4016) & 1, 1); // Pad didn't shift
+}
+
+TEST_F(CPUMemoryTest, Heatmap_Counts_Every_Access)
+{
+    nes::Heatmap heatmap;
+    memory.SetHeatmap(&heatmap);
+
+    memory.Write(0x0010, 1);
+    memory.Read(0x0010);
+    memory.Read(0x0010);
+    memory.Fetch(0x8000);
+    memory.SetHeatmap(nullptr);
+    memory.Read(0x0010);
+
+    EXPECT_EQ(heatmap.reads[0x0010], 2);
+    EXPECT_EQ(heatmap.writes[0x0010], 1);
+    EXPECT_EQ(heatmap.executes[0x8000], 1);
+
+    std::stringstream csv;
+    heatmap.WriteCsv(csv);
+    EXPECT_EQ(csv.str(), "address,reads,writes,executes\n$0010,2,1,0\n$8000,0,0,1\n");
+
+    std::stringstream pgm;
+    heatmap.WritePgm(pgm);
+    auto const image = pgm.str();
+    ASSERT_EQ(image.size(), 15 + 0x10000);
+    EXPECT_EQ(image.substr(0, 15), "P5\n256 256\n255\n");
+    EXPECT_EQ(static_cast<uint8_t>(image[15 + 0x10]), 255);
+    EXPECT_EQ(static_cast<uint8_t>(image[15 + 0x11]), 0);
+}
+
+TEST(ConsoleWatchTest, Catches_Program_Writing_Pad_State)
+{
+    nes::Console console(MakeTestCartridge(PadReaderProgram()));
+    console.Reset();
+
+    int writes = 0;
+    console.memory.onWatch = [&](nes::WatchHit const& hit) {
+        EXPECT_EQ(hit.address, 0x0011);
+        writes++;
+    };
+    console.memory.AddWatchpoint(0x0011, 0x0011, nes::WatchWrite);
+    console.RunFrame();
+
+    EXPECT_GT(writes, 0);
+    EXPECT_EQ(writes, console.ram[0x11] + 256 * (writes / 256)); // INC $11 once a loop
+}
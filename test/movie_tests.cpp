@@ -0,0 +1,139 @@
+#include "../src/movie.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+
+static std::array<uint8_t, 2> PadsFor(uint64_t frame)
+{
+    // Hold A for a few frames at a time so there's something for the RLE to do.
+    return { static_cast<uint8_t>((frame / 7) % 2 ? nes::Controller::A : 0), 0 };
+}
+
+static nes::Movie Record(std::shared_ptr<nes::Cartridge const> cartridge, uint64_t frames, uint32_t interval)
+{
+    nes::Console console(cartridge);
+    console.Reset();
+
+    nes::MovieRecorder recorder(console, interval);
+    for (uint64_t frame = 0; frame < frames; frame++)
+        recorder.RunFrame(PadsFor(frame));
+
+    return recorder.Recording();
+}
+
+TEST(ConsoleStateTest, Load_Restores_Exactly)
+{
+    nes::Console console(MakeTestCartridge(PadReaderProgram()));
+    console.Reset();
+    console.RunFrame();
+
+    nes::ConsoleState state;
+    console.Save(state);
+    auto const hash = console.Hash();
+
+    console.memory.controllers[0].buttons = nes::Controller::A;
+    console.RunFrame();
+    EXPECT_NE(console.Hash(), hash);
+
+    console.Load(state);
+    EXPECT_EQ(console.Hash(), hash);
+    EXPECT_EQ(console.frame, 1);
+}
+
+TEST(MovieTest, Recording_Has_Input_Hash_And_Checkpoints)
+{
+    auto movie = Record(MakeTestCartridge(PadReaderProgram()), 25, 10);
+
+    EXPECT_EQ(movie.inputs.size(), 25);
+    EXPECT_EQ(movie.hashes.size(), 25);
+    ASSERT_EQ(movie.checkpoints.size(), 3);
+    EXPECT_EQ(movie.checkpoints[0].frame, 0);
+    EXPECT_EQ(movie.checkpoints[2].frame, 20);
+    EXPECT_EQ(movie.checkpoints[2].hash, movie.hashes[19]);
+}
+
+TEST(MovieTest, Save_Load_Round_Trip)
+{
+    auto movie = Record(MakeTestCartridge(PadReaderProgram()), 40, 16);
+    auto path = (std::filesystem::temp_directory_path() / "nes_movie_test.nesm").string();
+
+    ASSERT_TRUE(movie.Save(path));
+    auto loaded = nes::Movie::Load(path);
+    std::filesystem::remove(path);
+
+    ASSERT_TRUE(loaded);
+    EXPECT_EQ(loaded->romHash, movie.romHash);
+    EXPECT_EQ(loaded->inputs, movie.inputs);
+    EXPECT_EQ(loaded->hashes, movie.hashes);
+    ASSERT_EQ(loaded->checkpoints.size(), movie.checkpoints.size());
+    EXPECT_EQ(loaded->checkpoints[1].state.ram, movie.checkpoints[1].state.ram);
+}
+
+TEST(MovieTest, Verify_Passes_Unchanged_Movie)
+{
+    auto cartridge = MakeTestCartridge(PadReaderProgram());
+    auto movie = Record(cartridge, 50, 8);
+    nes::JobScheduler scheduler(4, false);
+
+    EXPECT_FALSE(nes::VerifyMovie(movie, cartridge, scheduler));
+}
+
+TEST(MovieTest, Verify_Finds_First_Divergent_Frame)
+{
+    auto cartridge = MakeTestCartridge(PadReaderProgram());
+    auto movie = Record(cartridge, 50, 8);
+    nes::JobScheduler scheduler(4, false);
+
+    // Different input on 19 changes RAM on 19, but the segment starting at 24 still
+    // has its own good checkpoint so only the 16..23 segment should fail.
+    movie.inputs[19][0] ^= nes::Controller::A;
+    auto mismatch = nes::VerifyMovie(movie, cartridge, scheduler);
+
+    ASSERT_TRUE(mismatch);
+    EXPECT_EQ(*mismatch, 19);
+}
+
+TEST(MovieTest, Hash_Covers_The_Picture)
+{
+    auto cartridge = MakeStatusSampler();
+    auto movie = Record(cartridge, 30, 10);
+    nes::JobScheduler scheduler(2, false);
+    EXPECT_FALSE(nes::VerifyMovie(movie, cartridge, scheduler));
+
+    // Same state every frame, but nothing drawn to hash
+    nes::Console console(cartridge);
+    console.renderEvery = 0;
+    auto mismatch = nes::VerifySegment(console, movie, 1);
+    ASSERT_TRUE(mismatch);
+    EXPECT_EQ(*mismatch, 10);
+}
+
+TEST(MovieTest, Load_Rejects_Bad_Checkpoints)
+{
+    auto movie = Record(MakeTestCartridge(PadReaderProgram()), 40, 16);
+    auto path = (std::filesystem::temp_directory_path() / "nes_movie_test.nesm").string();
+
+    auto loads = [&](nes::Movie const& changed) {
+        EXPECT_TRUE(changed.Save(path));
+        return nes::Movie::Load(path).has_value();
+    };
+
+    auto none = movie;
+    none.checkpoints.clear();
+    EXPECT_FALSE(loads(none));
+
+    auto late = movie;
+    late.checkpoints[0].frame = 1;
+    EXPECT_FALSE(loads(late));
+
+    auto backwards = movie;
+    backwards.checkpoints[2].frame = backwards.checkpoints[1].frame;
+    EXPECT_FALSE(loads(backwards));
+
+    auto past = movie;
+    past.checkpoints[2].frame = 40;
+    EXPECT_FALSE(loads(past));
+
+    EXPECT_TRUE(loads(movie));
+    std::filesystem::remove(path);
+}
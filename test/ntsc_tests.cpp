@@ -0,0 +1,73 @@
+#include "../filters/ntsc.h"
+#include "../src/scheduler.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Middle of the output for a frame that's all one pixel value
+static uint32_t Solid(nes::NtscFilter& filter, nes::Pixel pixel)
+{
+    auto const frame = SolidFrame(pixel);
+
+    std::vector<uint32_t> out(filter.OutputWidth() * filter.OutputHeight());
+    filter.Apply(*frame, 0, reinterpret_cast<uint8_t*>(out.data()), filter.OutputWidth() * 4);
+    return out[(nes::FrameHeight / 2) * filter.OutputWidth() + filter.OutputWidth() / 2];
+}
+
+TEST(NtscTest, Grays_Have_No_Colour)
+{
+    nes::NtscFilter filter;
+    for (nes::Pixel pixel : { 0x00, 0x10, 0x20, 0x0F })
+    {
+        auto const rgba = Solid(filter, pixel);
+        EXPECT_NEAR(rgba & 0xFF, (rgba >> 8) & 0xFF, 1) << pixel;
+        EXPECT_NEAR(rgba & 0xFF, (rgba >> 16) & 0xFF, 1) << pixel;
+    }
+
+    EXPECT_EQ(Solid(filter, 0x0F), 0xFF000000);
+    EXPECT_EQ(Solid(filter, 0x20), 0xFFFFFFFF);
+}
+
+TEST(NtscTest, Hues_Come_Out_Roughly_Right)
+{
+    nes::NtscFilter filter;
+    auto channels = [&](nes::Pixel pixel) {
+        auto const rgba = Solid(filter, pixel);
+        return std::vector<int> { static_cast<int>(rgba & 0xFF), static_cast<int>((rgba >> 8) & 0xFF),
+                                  static_cast<int>((rgba >> 16) & 0xFF) };
+    };
+
+    auto const red = channels(0x16), green = channels(0x2A), blue = channels(0x12);
+    EXPECT_GT(red[0], red[1] + 64);
+    EXPECT_GT(green[1], green[0] + 64);
+    EXPECT_GT(blue[2], blue[0] + 64);
+}
+
+TEST(NtscTest, Simd_And_Threads_Match_Scalar)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (size_t i = 0; i < frame->size(); i++)
+        (*frame)[i] = static_cast<nes::Pixel>((i * 7 + i / nes::FrameWidth * 3) & nes::PixelMask);
+
+    for (unsigned scale : { 1u, 2u, 8u })
+    {
+        nes::NtscFilter filter({ .scale = scale, .format = nes::PixelFormat::BGRA8888, .saturation = 1.0f });
+        size_t const stride = filter.OutputWidth() * 4;
+        std::vector<uint8_t> scalar(stride * filter.OutputHeight()), simd(scalar.size()), threaded(scalar.size());
+
+        filter.ApplyScalar(*frame, 3, scalar.data(), stride);
+        filter.Apply(*frame, 3, simd.data(), stride);
+        {
+            nes::JobScheduler scheduler(3, false);
+            filter.Apply(*frame, 3, threaded.data(), stride, &scheduler);
+        }
+
+        int worst = 0;
+        for (size_t i = 0; i < scalar.size(); i++)
+            worst = std::max(worst, std::abs(scalar[i] - simd[i]));
+        EXPECT_LE(worst, 1) << "scale " << scale; // FMA rounds differently
+        EXPECT_EQ(simd, threaded) << "scale " << scale;
+    }
+}
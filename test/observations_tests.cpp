@@ -0,0 +1,205 @@
+#include "../src/console.h"
+#include "../src/observations.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+// Unique per process so parallel test runs don't trip over each other
+static std::string ExportName(char const* test)
+{
+    return "/nes_test_" + std::string(test) + "." + std::to_string(::getpid());
+}
+
+TEST(ObservationsTest, Reader_Sees_What_Was_Published)
+{
+    auto const name = ExportName("published");
+    auto exporter = nes::ObservationExport::Create(name, 3);
+    ASSERT_TRUE(exporter);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(reader->SlotCount(), 3);
+
+    auto observation = std::make_unique<nes::Observation>();
+    EXPECT_FALSE(reader->ReadNewest(*observation));
+
+    std::vector<uint8_t> ram(0x800, 0x42);
+    std::vector<nes::Pixel> pixels(nes::FrameWidth * nes::FrameHeight, 0x16);
+    exporter->Publish(7, ram, pixels);
+
+    ASSERT_TRUE(reader->ReadNewest(*observation));
+    EXPECT_EQ(observation->frame, 7);
+    EXPECT_EQ(observation->ram[0x7FF], 0x42);
+    EXPECT_EQ(observation->pixels.back(), 0x16);
+
+    uint64_t sequence = 0;
+    auto const* slot = reader->Newest(sequence);
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->observation.frame, 7);
+    EXPECT_TRUE(nes::ObservationReader::Unchanged(*slot, sequence));
+}
+
+TEST(ObservationsTest, Old_Frames_Get_Written_Over)
+{
+    auto const name = ExportName("ring");
+    auto exporter = nes::ObservationExport::Create(name, 2);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(exporter && reader);
+
+    std::vector<uint8_t> ram(0x800);
+    for (uint8_t frame = 0; frame < 5; frame++)
+    {
+        std::fill(ram.begin(), ram.end(), frame);
+        exporter->Publish(frame, ram, {});
+    }
+
+    auto observation = std::make_unique<nes::Observation>();
+    EXPECT_EQ(reader->Published(), 5);
+    EXPECT_FALSE(reader->Read(2, *observation)); // Gone round the ring since
+    EXPECT_FALSE(reader->Read(5, *observation)); // Not there yet
+    ASSERT_TRUE(reader->Read(3, *observation));
+    EXPECT_EQ(observation->ram[0], 3);
+}
+
+TEST(ObservationsTest, Open_Needs_An_Export)
+{
+    EXPECT_FALSE(nes::ObservationReader::Open(ExportName("missing")));
+}
+
+TEST(ObservationsTest, Create_Never_Takes_Over_A_Name)
+{
+    auto const name = ExportName("taken");
+    auto exporter = nes::ObservationExport::Create(name);
+    ASSERT_TRUE(exporter);
+    EXPECT_FALSE(nes::ObservationExport::Create(name));
+
+    // Still the first one's, readers are none the wiser
+    std::vector<uint8_t> ram(0x800, 0x11);
+    exporter->Publish(1, ram, {});
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(reader->Published(), 1);
+}
+
+TEST(ObservationsTest, Dead_Writer_Does_Not_Hang_Readers)
+{
+    auto const name = ExportName("dead");
+    auto exporter = nes::ObservationExport::Create(name, 2);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(exporter && reader);
+
+    std::vector<uint8_t> ram(0x800);
+    exporter->Publish(0, ram, {});
+
+    // Leave the newest slot odd, like an emulator that died half way through
+    // writing it over
+    int const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    ASSERT_GE(fd, 0);
+    size_t const bytes = sizeof(nes::ObservationHeader) + sizeof(nes::ObservationSlot);
+    void* mapping = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(mapping, MAP_FAILED);
+    auto* slot = reinterpret_cast<nes::ObservationSlot*>(static_cast<uint8_t*>(mapping) + sizeof(nes::ObservationHeader));
+    slot->sequence.store(3);
+
+    uint64_t sequence = 0;
+    EXPECT_EQ(reader->Newest(sequence), nullptr);
+    auto observation = std::make_unique<nes::Observation>();
+    EXPECT_FALSE(reader->ReadNewest(*observation));
+    ::munmap(mapping, bytes);
+}
+
+TEST(ObservationsTest, Reads_Are_Never_Torn)
+{
+    auto const name = ExportName("torn");
+    auto exporter = nes::ObservationExport::Create(name, 2);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(exporter && reader);
+
+    // Every byte of each publish is the frame number, so a read that mixes two
+    // frames shows up
+    std::atomic<bool> done { false };
+    std::thread writer([&] {
+        std::vector<uint8_t> ram(0x800);
+        for (uint64_t frame = 0; frame < 20000; frame++)
+        {
+            std::fill(ram.begin(), ram.end(), static_cast<uint8_t>(frame));
+            exporter->Publish(frame, ram, {});
+        }
+        done = true;
+    });
+
+    auto observation = std::make_unique<nes::Observation>();
+    uint64_t reads = 0;
+    while (!done || reads == 0)
+    {
+        if (!reader->ReadNewest(*observation))
+            continue;
+
+        reads++;
+        auto const expected = static_cast<uint8_t>(observation->frame);
+        ASSERT_TRUE(std::all_of(observation->ram.begin(), observation->ram.end(), [=](uint8_t b) { return b == expected; }));
+    }
+
+    writer.join();
+    EXPECT_GT(reads, 0);
+}
+
+TEST(ObservationsTest, Console_Publishes_Every_Frame)
+{
+    auto const name = ExportName("console");
+    auto exporter = nes::ObservationExport::Create(name);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(exporter && reader);
+
+    nes::Console console;
+    console.observations = exporter.get();
+    console.Reset();
+    console.ram[0x700] = 0x99;
+    for (int i = 0; i < 3; i++)
+        console.RunFrame();
+
+    auto observation = std::make_unique<nes::Observation>();
+    EXPECT_EQ(reader->Published(), 3);
+    ASSERT_TRUE(reader->ReadNewest(*observation));
+    EXPECT_EQ(observation->frame, 3);
+    EXPECT_EQ(observation->ram[0x700], 0x99);
+}
+
+// Undrawn frames go out with the last picture that was drawn, not whatever was in
+// their slot last time round
+TEST(ObservationsTest, Skipped_Frames_Repeat_The_Last_Picture)
+{
+    auto const name = ExportName("skipped");
+    auto exporter = nes::ObservationExport::Create(name, 4);
+    auto reader = nes::ObservationReader::Open(name);
+    ASSERT_TRUE(exporter && reader);
+
+    nes::Console console(MakeStatusSampler());
+    console.observations = exporter.get();
+    console.renderEvery = 2;
+    console.Reset();
+
+    std::vector<nes::FrameBuffer> drawn(10);
+    for (auto& picture : drawn)
+    {
+        console.RunFrame();
+        picture = console.ppu.frame;
+    }
+    EXPECT_NE(drawn[6], drawn[8]); // Scrolling, so every drawn picture is different
+    EXPECT_EQ(drawn[6], drawn[7]);
+
+    auto observation = std::make_unique<nes::Observation>();
+    for (uint64_t index = 6; index < drawn.size(); index++)
+    {
+        ASSERT_TRUE(reader->Read(index, *observation));
+        EXPECT_EQ(observation->pixels, drawn[index]) << index;
+    }
+}
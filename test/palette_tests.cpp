@@ -0,0 +1,90 @@
+#include "../src/palette.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+TEST(PaletteTest, Default_Matches_2C02)
+{
+    auto const palette = nes::Palette::Default();
+
+    EXPECT_EQ(palette.colors[0x00], 0x666666);
+    EXPECT_EQ(palette.colors[0x0F], 0x000000);
+    EXPECT_EQ(palette.colors[0x30], 0xFFFEFF);
+}
+
+TEST(PaletteTest, Emphasis_Dims_Other_Channels)
+{
+    auto const palette = nes::Palette::Default();
+    auto const red = palette.colors[1 << 6 | 0x30];
+
+    EXPECT_EQ(red >> 16, 0xFF);
+    EXPECT_LT((red >> 8) & 0xFF, 0xFE);
+    EXPECT_LT(red & 0xFF, 0xFF);
+    EXPECT_EQ(palette.colors[7 << 6 | 0x0F], 0x000000);
+}
+
+TEST(PaletteTest, Lut_Formats)
+{
+    auto palette = nes::Palette::Default();
+    palette.colors[1] = 0x123456;
+
+    EXPECT_EQ(nes::PaletteLut(palette, nes::PixelFormat::RGBA8888)[1], 0xFF563412);
+    EXPECT_EQ(nes::PaletteLut(palette, nes::PixelFormat::BGRA8888)[1], 0xFF123456);
+    EXPECT_EQ(nes::PaletteLut(palette, nes::PixelFormat::RGB565)[1], (0x12 >> 3) << 11 | (0x34 >> 2) << 5 | 0x56 >> 3);
+    EXPECT_EQ(nes::PaletteLut(palette, nes::PixelFormat::Gray8)[1], (77 * 0x12 + 150 * 0x34 + 29 * 0x56) >> 8);
+}
+
+TEST(PaletteTest, Load_Base_And_Full_Palettes)
+{
+    auto const path = testing::TempDir() + "palette_test.pal";
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int i = 0; i < 64; i++)
+            file.put(static_cast<char>(i)).put(static_cast<char>(i * 2)).put(static_cast<char>(i * 3));
+    }
+    auto const base = nes::Palette::Load(path);
+    ASSERT_TRUE(base);
+    EXPECT_EQ(base->colors[10], 0x0A141E);
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int i = 0; i < 512; i++)
+            file.put(static_cast<char>(i >> 1)).put(0).put(0);
+    }
+    auto const full = nes::Palette::Load(path);
+    ASSERT_TRUE(full);
+    EXPECT_EQ(full->colors[511], 0xFF0000);
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a palette";
+    }
+    EXPECT_FALSE(nes::Palette::Load(path));
+    std::remove(path.c_str());
+}
+
+// Widths that leave every size of tail after the SIMD blocks, into a padded stride.
+TEST(PaletteTest, Convert_Matches_Scalar)
+{
+    for (auto format : { nes::PixelFormat::RGBA8888, nes::PixelFormat::BGRA8888, nes::PixelFormat::RGB565,
+                         nes::PixelFormat::Gray8 })
+    {
+        nes::PaletteLut const lut(nes::Palette::Default(), format);
+        for (unsigned width : { 1u, 7u, 8u, 15u, 31u, 33u, 256u })
+        {
+            unsigned const height = 5;
+            std::vector<nes::Pixel> pixels(width * height);
+            for (size_t i = 0; i < pixels.size(); i++)
+                pixels[i] = static_cast<nes::Pixel>(i * 37 + (i >> 3) * 0x7F); // Junk above bit 8 too
+
+            size_t const stride = width * nes::BytesPerPixel(format) + 5;
+            std::vector<uint8_t> expected(stride * height, 0xCC), got(stride * height, 0xCC);
+            nes::ConvertPixelsScalar(pixels, width, lut, expected.data(), stride);
+            nes::ConvertPixels(pixels, width, lut, got.data(), stride);
+
+            EXPECT_EQ(got, expected) << "format " << static_cast<int>(format) << " width " << width;
+            EXPECT_EQ(got[stride - 1], 0xCC); // Padding left alone
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#include "../src/console.h"
+#include "../src/ppu.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+// CPU cycle that's at the start of line in a frame starting at cycle 0.
+static uint64_t LineCycle(uint32_t line)
+{
+    return (line * nes::DotsPerLine + 2) / 3;
+}
+
+TEST(PPUTest, Vblank_Set_Then_Cleared_By_Status_Read)
+{
+    uint64_t clock = 0;
+    nes::PPU ppu(clock);
+    ppu.BeginFrame(0);
+
+    clock = LineCycle(100);
+    EXPECT_EQ(ppu.ReadRegister(0x2002) & 0x80, 0);
+
+    clock = LineCycle(nes::VblankLine) + 1;
+    EXPECT_EQ(ppu.ReadRegister(0x2002) & 0x80, 0x80);
+    EXPECT_EQ(ppu.ReadRegister(0x2002) & 0x80, 0);
+}
+
+TEST(PPUTest, Vram_Reads_Come_Out_One_Behind)
+{
+    uint64_t clock = 0;
+    nes::PPU ppu(clock);
+    ppu.BeginFrame(0);
+
+    ppu.WriteRegister(0x2006, 0x24);
+    ppu.WriteRegister(0x2006, 0x10);
+    ppu.WriteRegister(0x2007, 0x55);
+    ppu.WriteRegister(0x2007, 0x66);
+
+    ppu.WriteRegister(0x2006, 0x20); // $2400 is a mirror of it, horizontal mirroring
+    ppu.WriteRegister(0x2006, 0x10);
+    ppu.ReadRegister(0x2007);
+    EXPECT_EQ(ppu.ReadRegister(0x2007), 0x55);
+    EXPECT_EQ(ppu.ReadRegister(0x2007), 0x66);
+
+    // Palette doesn't wait, and $3F10 is $3F00
+    ppu.WriteRegister(0x2006, 0x3F);
+    ppu.WriteRegister(0x2006, 0x10);
+    ppu.WriteRegister(0x2007, 0x21);
+    ppu.WriteRegister(0x2006, 0x3F);
+    ppu.WriteRegister(0x2006, 0x00);
+    EXPECT_EQ(ppu.ReadRegister(0x2007), 0x21);
+}
+
+TEST(PPUTest, Sprite0_Hit_Lands_On_Its_Line)
+{
+    uint64_t clock = 0;
+    nes::PPU ppu(clock);
+    ppu.BeginFrame(0);
+
+    // Tile 1 solid in CHR RAM, and the whole first nametable of it
+    ppu.WriteRegister(0x2006, 0x00);
+    ppu.WriteRegister(0x2006, 0x10);
+    for (int i = 0; i < 8; i++)
+        ppu.WriteRegister(0x2007, 0xFF);
+    ppu.WriteRegister(0x2006, 0x20);
+    ppu.WriteRegister(0x2006, 0x00);
+    for (int i = 0; i < 960; i++)
+        ppu.WriteRegister(0x2007, 0x01);
+
+    ppu.state.oam[0] = 49; // Top on line 50
+    ppu.state.oam[1] = 0x01;
+    ppu.state.oam[3] = 100;
+    ppu.WriteRegister(0x2006, 0x00);
+    ppu.WriteRegister(0x2006, 0x00);
+    ppu.WriteRegister(0x2001, 0x1E);
+    ppu.EndFrame(); // Pre-render line gets v from t
+
+    ppu.BeginFrame(0);
+    clock = LineCycle(50);
+    EXPECT_EQ(ppu.ReadRegister(0x2002) & 0x40, 0);
+    clock = LineCycle(51);
+    EXPECT_EQ(ppu.ReadRegister(0x2002) & 0x40, 0x40);
+    ppu.EndFrame();
+    EXPECT_EQ(ppu.state.status & 0x40, 0); // Cleared for the next frame
+}
+
+TEST(PPUTest, Nmi_Every_Vblank_When_Enabled)
+{
+    std::vector<uint8_t> program;
+    Store(program, 0x2000, 0x80);
+    auto const loop = static_cast<uint16_t>(0xC000 + program.size());
+    program.insert(program.end(), { 0x4C, static_cast<uint8_t>(loop), static_cast<uint8_t>(loop >> 8) });
+
+    nes::Console console(MakeNmiCartridge(program, { 0xE6, 0x10, 0x40 })); // INC $10, RTI
+    console.Reset();
+    for (int i = 0; i < 3; i++)
+        console.RunFrame();
+
+    EXPECT_EQ(console.ram[0x10], 3);
+    EXPECT_EQ(console.cpu.pc, loop); // Back where it was interrupted
+}
+
+TEST(PPUTest, Oam_Dma_Copies_Page_And_Stalls)
+{
+    std::vector<uint8_t> program;
+    for (uint8_t i = 0; i < 4; i++)
+        Store(program, 0x0200 + i, 0x40 + i);
+    Store(program, 0x2003, 0x00);
+    Store(program, 0x4014, 0x02);
+    Store(program, 0x2003, 0x02);
+    program.insert(program.end(), { 0xAD, 0x04, 0x20, 0x85, 0x10 }); // LDA $2004, STA $10
+    auto const loop = static_cast<uint16_t>(0xC000 + program.size());
+    program.insert(program.end(), { 0x4C, static_cast<uint8_t>(loop), static_cast<uint8_t>(loop >> 8) });
+
+    nes::Console console(MakeTestCartridge(program));
+    console.Reset();
+    console.RunFrame();
+
+    EXPECT_EQ(console.ram[0x10], 0x42);
+    EXPECT_EQ(console.ppu.state.oam[3], 0x43);
+    auto const counters = console.counters.Snapshot();
+    EXPECT_GE(counters.dmaStallCycles, 513);
+    EXPECT_LE(counters.dmaStallCycles, 514);
+}
+
+TEST(PPUTest, Skipping_Render_Leaves_Everything_Else_The_Same)
+{
+    auto const cartridge = MakeStatusSampler();
+    auto drawn = std::make_unique<nes::Console>(cartridge);
+    auto skipped = std::make_unique<nes::Console>(cartridge);
+    auto sometimes = std::make_unique<nes::Console>(cartridge);
+    skipped->renderEvery = 0;
+    sometimes->renderEvery = 3;
+    drawn->Reset();
+    skipped->Reset();
+    sometimes->Reset();
+
+    bool sawHit = false;
+    for (int i = 0; i < 30; i++)
+    {
+        drawn->RunFrame();
+        skipped->RunFrame();
+        sometimes->RunFrame();
+        ASSERT_EQ(drawn->Hash(), skipped->Hash()) << "frame " << i;
+        ASSERT_EQ(drawn->Hash(), sometimes->Hash()) << "frame " << i;
+        sawHit |= (drawn->ram[0x11] & 0x40) != 0;
+    }
+
+    EXPECT_GT(drawn->ram[0x10], 0);
+    EXPECT_TRUE(sawHit);
+
+    // Frame 29 wasn't one of sometimes' drawn ones, 27 was
+    EXPECT_EQ(skipped->ppu.frame[0], 0);
+    EXPECT_NE(drawn->ppu.frame, sometimes->ppu.frame);
+}
+
+TEST(PPUTest, Render_Draws_Tiles_And_Sprites)
+{
+    nes::Console console(MakeStatusSampler());
+    console.Reset();
+    console.RunFrame();
+    console.RunFrame(); // The first frame turns rendering on part way through
+
+    std::array<size_t, 0x40> counts {};
+    for (auto pixel : console.ppu.frame)
+        counts[pixel & nes::PixelIndexMask]++;
+
+    EXPECT_EQ(console.ppu.frame[0], 0x0F); // Backdrop above the tiles
+    for (uint8_t color : { 0x16, 0x27, 0x30, 0x1A, 0x2A, 0x3A })
+        EXPECT_GT(counts[color], 0) << "color " << int(color);
+}
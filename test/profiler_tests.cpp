@@ -0,0 +1,102 @@
+#include "../src/console.h"
+#include "../src/profiler.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(ProfilerTest, Counts_Opcodes_Cycles_And_Banks)
+{
+    nes::Profiler profiler(1);
+
+    profiler.Record(0xC000, 0xA9, 2, 0xC002);
+    profiler.Record(0xC002, 0xA9, 2, 0xC004);
+    profiler.Record(0x0400, 0x8D, 4, 0x0403);
+
+    EXPECT_EQ(profiler.Instructions(), 3);
+    EXPECT_EQ(profiler.OpcodeCount(0xA9), 2);
+    EXPECT_EQ(profiler.OpcodeCycles(0xA9), 4);
+    EXPECT_EQ(profiler.OpcodeCycles(0x8D), 4);
+    EXPECT_EQ(profiler.BankCycles(6), 4); // $C000
+    EXPECT_EQ(profiler.BankCycles(0), 4);
+    EXPECT_EQ(profiler.PcSamples(0xC002), 1);
+}
+
+TEST(ProfilerTest, Rebuilds_Call_Stacks_From_JSR_RTS)
+{
+    // JSR $D000 at $C000, JSR $E123 at $D000
+    nes::Profiler profiler(1);
+    profiler.Record(0xC000, 0x20, 6, 0xD000);
+    profiler.Record(0xD000, 0x20, 6, 0xE123);
+    profiler.Record(0xE123, 0xEA, 2, 0xE124);
+    EXPECT_EQ(profiler.Depth(), 2);
+    profiler.Record(0xE124, 0x60, 6, 0xD003);
+    profiler.Record(0xD003, 0x60, 6, 0xC003);
+    profiler.Record(0xC003, 0x60, 6, 0xC004); // Unbalanced, should be ignored
+    EXPECT_EQ(profiler.Depth(), 0);
+
+    std::stringstream stacks;
+    profiler.WriteCollapsedStacks(stacks);
+    auto const text = stacks.str();
+
+    EXPECT_NE(text.find("reset;sub_D000;sub_E123 2\n"), std::string::npos);
+    EXPECT_NE(text.find("reset;sub_D000 2\n"), std::string::npos);
+    EXPECT_NE(text.find("reset 2\n"), std::string::npos);
+}
+
+TEST(ProfilerTest, Report_Lists_Hottest_Opcode_First)
+{
+    nes::Profiler profiler(1);
+    profiler.Record(0xC000, 0xEA, 2, 0xC001);
+    profiler.Record(0xC001, 0xFE, 7, 0xC004);
+
+    std::stringstream report;
+    profiler.WriteReport(report);
+    auto const text = report.str();
+
+    EXPECT_LT(text.find("  FE "), text.find("  EA "));
+}
+
+#if NES_PROFILER
+TEST(ProfilerTest, Attached_To_CPU_Sees_Every_Instruction)
+{
+    nes::Console console(MakeTestCartridge(PadReaderProgram()));
+    nes::Profiler profiler(1);
+    console.cpu.profiler = &profiler;
+    console.Reset();
+    console.RunFrame();
+
+    EXPECT_EQ(profiler.Instructions(), console.instructions);
+    EXPECT_GT(profiler.OpcodeCount(0x4C), 0);
+}
+
+TEST(ProfilerTest, Follows_Real_Calls_And_Returns)
+{
+    std::vector<uint8_t> program(0x13, 0xEA);
+    std::vector<uint8_t> const caller = {
+        0x20, 0x10, 0xC0, // JSR $C010
+        0x4C, 0x00, 0xC0, // JMP $C000
+    };
+    std::vector<uint8_t> const callee = {
+        0xE6, 0x11,       // INC $11
+        0x60,             // RTS
+    };
+    std::copy(caller.begin(), caller.end(), program.begin());
+    std::copy(callee.begin(), callee.end(), program.begin() + 0x10);
+
+    nes::Console console(MakeTestCartridge(program));
+    nes::Profiler profiler(1);
+    console.cpu.profiler = &profiler;
+    console.Reset();
+    console.RunFrame();
+
+    EXPECT_LE(profiler.Depth(), 1u);
+
+    std::stringstream stacks;
+    profiler.WriteCollapsedStacks(stacks);
+    auto const text = stacks.str();
+
+    EXPECT_NE(text.find("reset;sub_C010 "), std::string::npos);
+    EXPECT_NE(text.find("reset "), std::string::npos);
+    EXPECT_EQ(text.find("sub_C010;sub_C010"), std::string::npos);
+}
+#endif
@@ -0,0 +1,82 @@
+#include "../src/rollback.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+
+// Changes often enough that guessing "same as last frame" goes wrong regularly,
+// then stops so the last few guesses come out right.
+static uint8_t PadFor(int player, uint64_t frame, uint64_t lastChange)
+{
+    if (frame >= lastChange)
+        return 0;
+    return ((frame + player * 3) / 5) % 2 ? nes::Controller::A : 0;
+}
+
+TEST(LoopbackLinkTest, Delivers_After_Latency)
+{
+    nes::LoopbackLink link(2);
+    nes::InputPacket packet;
+
+    link.End(0).Send({ 7, 0x42 });
+    EXPECT_FALSE(link.End(1).Receive(packet));
+    link.Advance();
+    EXPECT_FALSE(link.End(1).Receive(packet));
+    link.Advance();
+    ASSERT_TRUE(link.End(1).Receive(packet));
+    EXPECT_EQ(packet.frame, 7);
+    EXPECT_EQ(packet.buttons, 0x42);
+    EXPECT_FALSE(link.End(0).Receive(packet));
+}
+
+TEST(RollbackTest, Both_Players_End_Up_Matching_Offline_Run)
+{
+    constexpr uint64_t Frames = 120;
+    constexpr uint64_t LastChange = 100;
+    auto cartridge = MakeTestCartridge(PadReaderProgram());
+
+    nes::LoopbackLink link(3);
+    nes::Console consoles[2] = { nes::Console(cartridge), nes::Console(cartridge) };
+    consoles[0].Reset();
+    consoles[1].Reset();
+    nes::RollbackSession sessions[2] = {
+        nes::RollbackSession(consoles[0], link.End(0), 0, 8),
+        nes::RollbackSession(consoles[1], link.End(1), 1, 8),
+    };
+
+    for (uint64_t frame = 0; frame < Frames; frame++)
+    {
+        for (int player = 0; player < 2; player++)
+            ASSERT_TRUE(sessions[player].AdvanceFrame(PadFor(player, frame, LastChange)));
+        link.Advance();
+    }
+
+    // Same inputs with no network in the way
+    nes::Console offline(cartridge);
+    offline.Reset();
+    for (uint64_t frame = 0; frame < Frames; frame++)
+    {
+        offline.memory.controllers[0].buttons = PadFor(0, frame, LastChange);
+        offline.memory.controllers[1].buttons = PadFor(1, frame, LastChange);
+        offline.RunFrame();
+    }
+
+    EXPECT_EQ(consoles[0].Hash(), offline.Hash());
+    EXPECT_EQ(consoles[1].Hash(), offline.Hash());
+    EXPECT_GT(sessions[0].GetStats().rollbacks, 0);
+    EXPECT_LE(sessions[0].GetStats().maxRollbackFrames, 4);
+}
+
+TEST(RollbackTest, Stalls_When_Too_Far_Ahead)
+{
+    auto cartridge = MakeTestCartridge(PadReaderProgram());
+    nes::LoopbackLink link(10);
+    nes::Console console(cartridge);
+    console.Reset();
+    nes::RollbackSession session(console, link.End(0), 0, 4);
+
+    // Nobody on the other end, so after the window fills we have to wait
+    for (int i = 0; i < 5; i++)
+        EXPECT_TRUE(session.AdvanceFrame(0));
+    EXPECT_FALSE(session.AdvanceFrame(0));
+    EXPECT_EQ(session.Frame(), 5);
+    EXPECT_EQ(session.GetStats().stalls, 1);
+}
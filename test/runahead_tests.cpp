@@ -0,0 +1,75 @@
+#include "../src/runahead.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+
+static std::array<uint8_t, 2> PadsFor(uint64_t frame)
+{
+    return { static_cast<uint8_t>(frame % 3 == 0 ? nes::Controller::A : 0), 0 };
+}
+
+class RunAheadTests : public ::testing::TestWithParam<bool>
+{
+};
+
+TEST_P(RunAheadTests, Presents_Frames_Ahead_Of_Main)
+{
+    auto cartridge = MakeTestCartridge(PadReaderProgram());
+    nes::RunAhead runAhead(cartridge, 2, GetParam());
+    runAhead.Reset();
+
+    nes::Console reference(cartridge);
+    reference.Reset();
+
+    nes::ConsoleState state;
+    for (uint64_t frame = 0; frame < 10; frame++)
+    {
+        auto const pads = PadsFor(frame);
+        runAhead.RunFrame(pads);
+
+        reference.memory.controllers[0].buttons = pads[0];
+        reference.RunFrame();
+        EXPECT_EQ(runAhead.Main().Hash(), reference.Hash()); // Rewinding mustn't leave anything behind
+
+        // What run-ahead showed is where reference gets to if the input doesn't change.
+        reference.Save(state);
+        reference.RunFrame();
+        reference.RunFrame();
+
+        nes::Console presented(cartridge);
+        presented.Load(runAhead.Presented());
+        EXPECT_EQ(presented.Hash(), reference.Hash());
+        EXPECT_EQ(runAhead.Presented().frame, frame + 3);
+
+        reference.Load(state);
+    }
+
+    EXPECT_EQ(runAhead.GetStats().frames, 10);
+    EXPECT_GT(runAhead.GetStats().extraNanoseconds, 0);
+}
+
+TEST_P(RunAheadTests, Picture_Is_From_The_Frames_Ahead)
+{
+    // Scrolls every frame, so each picture is different
+    auto cartridge = MakeStatusSampler();
+    nes::RunAhead runAhead(cartridge, 2, GetParam());
+    runAhead.Reset();
+
+    nes::Console real(cartridge), ahead(cartridge);
+    real.Reset();
+    ahead.Reset();
+    ahead.RunFrame();
+    ahead.RunFrame();
+
+    for (int frame = 0; frame < 10; frame++)
+    {
+        runAhead.RunFrame({ 0, 0 });
+        real.RunFrame();
+        ahead.RunFrame();
+
+        EXPECT_TRUE(runAhead.Picture() == ahead.ppu.frame);
+        EXPECT_TRUE(runAhead.Main().ppu.frame == real.ppu.frame);
+        EXPECT_FALSE(runAhead.Picture() == real.ppu.frame);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(RunAhead, RunAheadTests, ::testing::Values(false, true));
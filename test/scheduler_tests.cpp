@@ -0,0 +1,124 @@
+#include "../src/host.h"
+#include "../src/scheduler.h"
+#include <gtest/gtest.h>
+
+TEST(JobSchedulerTest, Runs_Every_Job)
+{
+    nes::JobScheduler scheduler(4, false);
+    std::atomic<int> count = 0;
+
+    for (int i = 0; i < 1000; i++)
+        scheduler.Submit([&count] { count++; }, i);
+
+    scheduler.Wait();
+
+    EXPECT_EQ(count, 1000);
+}
+
+TEST(JobSchedulerTest, Jobs_Can_Submit_Jobs)
+{
+    nes::JobScheduler scheduler(2, false);
+    std::atomic<int> count = 0;
+
+    for (int i = 0; i < 10; i++)
+    {
+        scheduler.Submit([&] {
+            for (int j = 0; j < 10; j++)
+                scheduler.Submit([&count] { count++; });
+        });
+    }
+
+    // Wait has to cover jobs that were submitted by other jobs too
+    scheduler.Wait();
+
+    EXPECT_EQ(count, 100);
+}
+
+TEST(JobSchedulerTest, CurrentWorker_Is_Only_Set_On_Workers)
+{
+    nes::JobScheduler scheduler(3, false);
+    std::atomic<unsigned> seen = nes::JobScheduler::NoWorker;
+
+    scheduler.Submit([&seen] { seen = nes::JobScheduler::CurrentWorker(); }, 1);
+    scheduler.Wait();
+
+    EXPECT_EQ(nes::JobScheduler::CurrentWorker(), nes::JobScheduler::NoWorker);
+    EXPECT_LT(seen, 3u);
+}
+
+#if defined(__linux__)
+TEST(JobSchedulerTest, Pins_More_Workers_Than_Cores)
+{
+    // Workers wrap round the cores we're allowed on, so even a one core box pins them all
+    nes::JobScheduler scheduler(2, true);
+    EXPECT_EQ(scheduler.PinnedWorkers(), 2u);
+
+    nes::JobScheduler unpinned(2, false);
+    EXPECT_EQ(unpinned.PinnedWorkers(), 0u);
+}
+#endif
+
+TEST(JobSchedulerTest, ParallelFor_Covers_Every_Index_Once)
+{
+    nes::JobScheduler scheduler(3, false);
+    unsigned const bands = nes::ParallelBands(&scheduler, 100);
+    std::vector<std::atomic<int>> seen(100);
+    std::vector<std::atomic<int>> calls(bands);
+
+    nes::ParallelFor(&scheduler, 100, [&](unsigned band, unsigned first, unsigned last) {
+        calls[band]++;
+        for (unsigned i = first; i < last; i++)
+            seen[i]++;
+    });
+
+    EXPECT_EQ(bands, 7u);
+    for (auto const& count : seen)
+        EXPECT_EQ(count, 1);
+    for (auto const& count : calls)
+        EXPECT_EQ(count, 1);
+
+    // No scheduler, one band on this thread. More bands than items is never asked for.
+    EXPECT_EQ(nes::ParallelBands(nullptr, 100), 1u);
+    EXPECT_EQ(nes::ParallelBands(&scheduler, 4), 4u);
+}
+
+TEST(HostTest, RunFrames_Runs_Every_Instance)
+{
+    nes::JobScheduler scheduler(4, false);
+    nes::Host host(scheduler);
+
+    for (int i = 0; i < 8; i++)
+    {
+        auto console = std::make_unique<nes::Console>();
+        console->Reset();
+        host.Add(std::move(console));
+    }
+
+    host.RunFrames(3);
+    host.RunFrames(2);
+
+    for (size_t i = 0; i < host.InstanceCount(); i++)
+    {
+        EXPECT_EQ(host.Instance(i).frame, 5);
+        EXPECT_EQ(host.Stats(i).frames, 5);
+        EXPECT_EQ(host.Stats(i).latency.count, 5);
+    }
+
+    auto metrics = host.Metrics();
+    EXPECT_EQ(metrics.instances, 8);
+    EXPECT_EQ(metrics.frames, 40);
+    EXPECT_GT(metrics.framesPerSecond, 0);
+    EXPECT_LE(metrics.p99LatencyMicroseconds, metrics.maxLatencyMicroseconds);
+}
+
+TEST(LatencyHistogramTest, Percentile_Is_Within_Bucket_Resolution)
+{
+    nes::LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; i++)
+        histogram.Record(i * 1000);
+
+    auto p50 = histogram.Percentile(50);
+    EXPECT_GE(p50, 500000);
+    EXPECT_LE(p50, 500000 * 110 / 100);
+    EXPECT_EQ(histogram.Percentile(100), 1000000);
+}
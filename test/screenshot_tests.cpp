@@ -0,0 +1,349 @@
+#include "../src/screenshot.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <future>
+#include <latch>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Just enough inflate to read back what Deflate writes, fixed Huffman blocks only.
+static std::optional<std::vector<uint8_t>> Inflate(std::vector<uint8_t> const& stream)
+{
+    if (stream.size() < 6 || stream[0] != 0x78 || (stream[0] * 256 + stream[1]) % 31 != 0)
+        return std::nullopt;
+
+    size_t position = 16; // In bits
+    auto bit = [&] {
+        unsigned const value = (stream[position / 8] >> (position % 8)) & 1;
+        position++;
+        return value;
+    };
+    auto bits = [&](unsigned count) {
+        unsigned value = 0;
+        for (unsigned i = 0; i < count; i++)
+            value |= bit() << i;
+        return value;
+    };
+    auto huffman = [&](unsigned count) {
+        unsigned value = 0;
+        for (unsigned i = 0; i < count; i++)
+            value = (value << 1) | bit();
+        return value;
+    };
+
+    // Fixed code, RFC 1951 3.2.6: read 7 bits, then 8 or 9 depending on the range
+    auto symbol = [&]() -> unsigned {
+        unsigned code = huffman(7);
+        if (code <= 0x17)
+            return code + 256;
+        code = (code << 1) | bit();
+        if (code >= 0x30 && code <= 0xBF)
+            return code - 0x30;
+        if (code >= 0xC0 && code <= 0xC7)
+            return code - 0xC0 + 280;
+        code = (code << 1) | bit();
+        return code - 0x190 + 144;
+    };
+
+    static constexpr unsigned LengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr unsigned LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static constexpr unsigned DistanceBase[30] = { 1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                                   33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                                   1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr unsigned DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3,  3,  4,  4,  5,  5,  6,
+                                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    std::vector<uint8_t> out;
+    bool last = false;
+    while (!last)
+    {
+        last = bit();
+        if (bits(2) != 1)
+            return std::nullopt;
+
+        while (true)
+        {
+            if (position / 8 + 4 >= stream.size())
+                return std::nullopt;
+            unsigned const s = symbol();
+            if (s < 256)
+            {
+                out.push_back(static_cast<uint8_t>(s));
+                continue;
+            }
+            if (s == 256)
+                break;
+            if (s > 285)
+                return std::nullopt;
+
+            unsigned const length = LengthBase[s - 257] + bits(LengthExtra[s - 257]);
+            unsigned const code = huffman(5);
+            if (code >= 30)
+                return std::nullopt;
+            unsigned const distance = DistanceBase[code] + bits(DistanceExtra[code]);
+            if (distance > out.size())
+                return std::nullopt;
+            for (unsigned i = 0; i < length; i++)
+                out.push_back(out[out.size() - distance]);
+        }
+    }
+
+    uint32_t a = 1, b = 0;
+    for (auto byte : out)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    size_t const end = (position + 7) / 8;
+    if (end + 4 != stream.size())
+        return std::nullopt;
+    uint32_t const adler = uint32_t { stream[end] } << 24 | uint32_t { stream[end + 1] } << 16 |
+                           uint32_t { stream[end + 2] } << 8 | stream[end + 3];
+    if (adler != ((b << 16) | a))
+        return std::nullopt;
+    return out;
+}
+
+static uint32_t BigEndian(std::vector<uint8_t> const& bytes, size_t at)
+{
+    return uint32_t { bytes[at] } << 24 | uint32_t { bytes[at + 1] } << 16 | uint32_t { bytes[at + 2] } << 8 | bytes[at + 3];
+}
+
+struct Png
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t colorType = 0;
+    std::vector<uint8_t> plte;
+    std::vector<uint8_t> raw; // Inflated, filter bytes and all
+};
+
+// Walks the chunks, no CRC checking, that's covered by anything that opens them
+static std::optional<Png> ReadPng(std::vector<uint8_t> const& file)
+{
+    static constexpr uint8_t Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    if (file.size() < 8 || !std::equal(Signature, Signature + 8, file.begin()))
+        return std::nullopt;
+
+    Png png;
+    std::vector<uint8_t> idat;
+    for (size_t at = 8; at + 12 <= file.size();)
+    {
+        uint32_t const length = BigEndian(file, at);
+        std::string const type(file.begin() + at + 4, file.begin() + at + 8);
+        auto const data = file.begin() + at + 8;
+        if (type == "IHDR")
+        {
+            png.width = BigEndian(file, at + 8);
+            png.height = BigEndian(file, at + 12);
+            png.colorType = file[at + 17];
+        }
+        else if (type == "PLTE")
+            png.plte.assign(data, data + length);
+        else if (type == "IDAT")
+            idat.insert(idat.end(), data, data + length);
+        else if (type == "IEND")
+        {
+            auto raw = Inflate(idat);
+            if (!raw)
+                return std::nullopt;
+            png.raw = std::move(*raw);
+            return png;
+        }
+        at += 12 + length;
+    }
+    return std::nullopt;
+}
+
+TEST(ScreenshotTest, Deflate_Round_Trips)
+{
+    std::vector<uint8_t> data;
+    uint32_t seed = 5;
+    for (int i = 0; i < 100000; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        // Runs, repeats from far back and noise, so every length and distance range comes up
+        if (i % 5000 < 2000)
+            data.push_back(static_cast<uint8_t>(i / 700));
+        else if (i % 5000 < 3500 && i > 40000)
+            data.push_back(data[data.size() - 33000]);
+        else
+            data.push_back(static_cast<uint8_t>(seed >> 24));
+    }
+
+    auto const compressed = nes::Deflate(data);
+    EXPECT_LT(compressed.size(), data.size());
+    auto const inflated = Inflate(compressed);
+    ASSERT_TRUE(inflated);
+    EXPECT_EQ(*inflated, data);
+
+    auto const empty = Inflate(nes::Deflate({}));
+    ASSERT_TRUE(empty);
+    EXPECT_TRUE(empty->empty());
+}
+
+TEST(ScreenshotTest, Png_Has_The_Frame_In_Its_Palette)
+{
+    auto const frame = BlockFrame(0x10);
+    auto const palette = nes::Palette::Default();
+    auto const png = ReadPng(nes::EncodePng(*frame, palette));
+    ASSERT_TRUE(png);
+    EXPECT_EQ(png->width, nes::FrameWidth);
+    EXPECT_EQ(png->height, nes::FrameHeight);
+    ASSERT_EQ(png->colorType, 3);
+    ASSERT_EQ(png->raw.size(), nes::FrameHeight * (nes::FrameWidth + 1));
+
+    for (unsigned y = 0; y < nes::FrameHeight; y++)
+    {
+        ASSERT_EQ(png->raw[y * (nes::FrameWidth + 1)], 0);
+        for (unsigned x = 0; x < nes::FrameWidth; x++)
+        {
+            unsigned const entry = png->raw[y * (nes::FrameWidth + 1) + 1 + x];
+            ASSERT_LT(entry * 3 + 2, png->plte.size());
+            uint32_t const color = uint32_t { png->plte[entry * 3] } << 16 | uint32_t { png->plte[entry * 3 + 1] } << 8 |
+                                   png->plte[entry * 3 + 2];
+            ASSERT_EQ(color, palette.colors[(*frame)[y * nes::FrameWidth + x]]) << x << "," << y;
+        }
+    }
+}
+
+TEST(ScreenshotTest, Too_Many_Colours_Goes_To_Rgb)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (size_t i = 0; i < frame->size(); i++)
+        (*frame)[i] = static_cast<nes::Pixel>(i % nes::PaletteSize);
+
+    auto const palette = nes::Palette::Default();
+    auto const png = ReadPng(nes::EncodePng(*frame, palette));
+    ASSERT_TRUE(png);
+    EXPECT_EQ(png->colorType, 2);
+    EXPECT_TRUE(png->plte.empty());
+    ASSERT_EQ(png->raw.size(), nes::FrameHeight * (nes::FrameWidth * 3 + 1));
+    uint32_t const color = palette.colors[200];
+    EXPECT_EQ(png->raw[1 + 200 * 3], static_cast<uint8_t>(color >> 16));
+    EXPECT_EQ(png->raw[1 + 200 * 3 + 2], static_cast<uint8_t>(color));
+}
+
+TEST(ScreenshotTest, Thumbnail_Is_Shrunk)
+{
+    auto const png = ReadPng(nes::EncodePng(*BlockFrame(0), nes::Palette::Default(), { .shrink = 2 }));
+    ASSERT_TRUE(png);
+    EXPECT_EQ(png->width, 128);
+    EXPECT_EQ(png->height, 120);
+    EXPECT_EQ(png->raw.size(), 120 * 129);
+}
+
+TEST(ScreenshotTest, Writer_Saves_Files)
+{
+    auto const path = "/tmp/nes_screenshot_test." + std::to_string(::getpid()) + ".png";
+    {
+        nes::ScreenshotWriter writer;
+        writer.Save(path, *BlockFrame(0x20));
+        writer.Flush();
+        EXPECT_EQ(writer.Stats().encoded, 1);
+        EXPECT_EQ(writer.Stats().failed, 0);
+    }
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    ASSERT_NE(file, nullptr);
+    std::vector<uint8_t> bytes(1 << 20);
+    bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+    std::fclose(file);
+    std::remove(path.c_str());
+    EXPECT_EQ(bytes, nes::EncodePng(*BlockFrame(0x20)));
+}
+
+TEST(ScreenshotTest, Writer_Coalesces_When_Behind)
+{
+    nes::ScreenshotWriter writer(nes::Palette::Default(), 2);
+
+    // Holds the encoder thread up in the first request's callback
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    writer.Encode("blocker", *BlockFrame(0), {}, [&, released](std::vector<uint8_t> const&) {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    std::vector<std::string> done;
+    std::vector<size_t> sizes;
+    auto record = [&](std::string key) {
+        return [&, key](std::vector<uint8_t> const& png) {
+            done.push_back(key);
+            sizes.push_back(png.size());
+        };
+    };
+
+    writer.Encode("slot1", *BlockFrame(1), {}, record("slot1 old"));
+    writer.Encode("slot1", *BlockFrame(2), {}, record("slot1 new"));
+    writer.Encode("slot2", *BlockFrame(3), {}, record("slot2"));
+    writer.Encode("slot3", *BlockFrame(4), {}, record("slot3")); // Pushes slot1 out
+
+    release.set_value();
+    writer.Flush();
+
+    EXPECT_EQ(done, (std::vector<std::string> { "slot2", "slot3" }));
+    auto const stats = writer.Stats();
+    EXPECT_EQ(stats.requested, 5);
+    EXPECT_EQ(stats.encoded, 3);
+    EXPECT_EQ(stats.coalesced, 1);
+    EXPECT_EQ(stats.dropped, 1);
+    EXPECT_EQ(stats.waited, 0);
+}
+
+TEST(ScreenshotTest, Writer_Never_Drops_Files)
+{
+    nes::ScreenshotWriter writer(nes::Palette::Default(), 2);
+
+    std::latch started(1), released(1);
+    writer.Encode("blocker", *SolidFrame(0x0F), {}, [&](std::vector<uint8_t> const&) {
+        started.count_down();
+        released.wait();
+    });
+    started.wait();
+
+    // Twice as many as fit, and a thumbnail in amongst them that has nothing to push out
+    auto const base = "/tmp/nes_screenshot_test." + std::to_string(::getpid()) + ".";
+    std::vector<std::string> paths;
+    for (int i = 0; i < 4; i++)
+        paths.push_back(base + std::to_string(i) + ".png");
+    bool thumbnail = false;
+    std::thread saving([&] {
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            writer.Save(paths[i], *BlockFrame(static_cast<nes::Pixel>(i)));
+            if (i == 1)
+                writer.Encode("slot", *SolidFrame(0x30), {}, [&](std::vector<uint8_t> const&) { thumbnail = true; });
+        }
+    });
+
+    while (writer.Stats().waited == 0)
+        std::this_thread::yield();
+    released.count_down();
+    saving.join();
+    writer.Flush();
+
+    auto const stats = writer.Stats();
+    EXPECT_EQ(stats.encoded, 6);
+    EXPECT_EQ(stats.dropped, 0);
+    EXPECT_EQ(stats.failed, 0);
+    EXPECT_GT(stats.waited, 0);
+    EXPECT_TRUE(thumbnail);
+    for (auto const& path : paths)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        EXPECT_NE(file, nullptr) << path;
+        if (file)
+            std::fclose(file);
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,443 @@
+#ifndef NES_SINGLESTEP_H
+#define NES_SINGLESTEP_H
+
+// Runs the public single step 6502 tests (https://github.com/SingleStepTests/65x02,
+// the nes6502 set) against CPU::Step. One JSON file per opcode, an array of about
+// 10,000 cases like
+//
+//   { "name": "a9 2b 4c",
+//     "initial": { "pc": 1234, "s": 253, "a": 0, "x": 0, "y": 0, "p": 36, "ram": [[1234, 169], ...] },
+//     "final": { ... },
+//     "cycles": [[1234, 169, "read"], ...] }
+//
+// Their "s" is the stack pointer and "p" the status register, which we call sp and s.
+// Files are a few MB each, so they're parsed as they stream in rather than loaded.
+//
+// The cycle list is the bus access on each cycle. The count is always checked, the
+// accesses themselves only when asked, through a BusRecorder, since CPU doesn't do
+// the dummy reads yet.
+
+#include "../src/busrecorder.h"
+#include "../src/cpu.h"
+#include "../src/flatmemory.h"
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for the corpus: pull a value at a time out of a stream.
+class JsonReader
+{
+public:
+    explicit JsonReader(std::istream& stream) : stream(stream), buffer(1 << 16) {}
+
+    bool Failed() const { return failed; }
+
+    bool BeginArray() { return Begin('['); }
+    bool BeginObject() { return Begin('{'); }
+
+    // Before each array element. False, with the ']' used up, once there are no more.
+    bool NextElement()
+    {
+        if (Peek() == ']')
+        {
+            if (first.empty())
+                return Fail();
+            Get();
+            first.pop_back();
+            return false;
+        }
+
+        return Separator();
+    }
+
+    // Before each member. False, with the '}' used up, once there are no more.
+    bool NextKey(std::string& key)
+    {
+        if (Peek() == '}')
+        {
+            if (first.empty())
+                return Fail();
+            Get();
+            first.pop_back();
+            return false;
+        }
+
+        return Separator() && ReadString(key) && Expect(':');
+    }
+
+    bool ReadNumber(int64_t& value)
+    {
+        bool negative = false;
+        if (Peek() == '-')
+        {
+            negative = true;
+            Get();
+        }
+
+        int c = Peek();
+        if (c < '0' || c > '9')
+            return Fail();
+
+        value = 0;
+        while (c >= '0' && c <= '9')
+        {
+            value = value * 10 + (Get() - '0');
+            c = PeekRaw();
+        }
+
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    bool ReadString(std::string& value)
+    {
+        if (!Expect('"'))
+            return false;
+
+        value.clear();
+        for (int c = Get(); c != '"'; c = Get())
+        {
+            if (c < 0)
+                return Fail();
+            if (c == '\\')
+                c = Get(); // Nothing in the corpus needs more than this
+            value.push_back(static_cast<char>(c));
+        }
+        return true;
+    }
+
+    // Whatever the next value is, however deep.
+    bool Skip()
+    {
+        std::string key;
+        int64_t number = 0;
+        switch (Peek())
+        {
+        case '[':
+            BeginArray();
+            while (NextElement())
+                if (!Skip())
+                    return false;
+            return !failed;
+        case '{':
+            BeginObject();
+            while (NextKey(key))
+                if (!Skip())
+                    return false;
+            return !failed;
+        case '"':
+            return ReadString(key);
+        case 't': case 'f': case 'n':
+            while (PeekRaw() >= 'a' && PeekRaw() <= 'z')
+                Get();
+            return true;
+        default:
+            return ReadNumber(number);
+        }
+    }
+
+private:
+    bool Fail()
+    {
+        failed = true;
+        return false;
+    }
+
+    int PeekRaw()
+    {
+        if (position == size)
+        {
+            stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            size = static_cast<size_t>(stream.gcount());
+            position = 0;
+            if (size == 0)
+                return -1;
+        }
+        return static_cast<unsigned char>(buffer[position]);
+    }
+
+    int Peek()
+    {
+        int c = PeekRaw();
+        while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+        {
+            position++;
+            c = PeekRaw();
+        }
+        return c;
+    }
+
+    int Get()
+    {
+        int const c = PeekRaw();
+        if (c >= 0)
+            position++;
+        return c;
+    }
+
+    bool Expect(char c)
+    {
+        if (Peek() != c)
+            return Fail();
+        Get();
+        return true;
+    }
+
+    bool Begin(char c)
+    {
+        if (!Expect(c))
+            return false;
+        first.push_back(true);
+        return true;
+    }
+
+    bool Separator()
+    {
+        if (first.empty())
+            return Fail();
+        if (!first.back() && !Expect(','))
+            return false;
+        first.back() = false;
+        return true;
+    }
+
+    std::istream& stream;
+    std::vector<char> buffer;
+    size_t position = 0;
+    size_t size = 0;
+    std::vector<bool> first; // Per open array/object, no comma before the first element
+    bool failed = false;
+};
+
+struct SingleStepState
+{
+    uint16_t pc = 0;
+    uint8_t sp = 0;
+    uint8_t a = 0;
+    uint8_t x = 0;
+    uint8_t y = 0;
+    uint8_t p = 0;
+    std::vector<std::pair<uint16_t, uint8_t>> ram;
+};
+
+struct SingleStepCase
+{
+    std::string name;
+    SingleStepState initial;
+    SingleStepState final;
+    std::vector<nes::BusEvent> cycles;
+};
+
+inline bool ReadSingleStepState(JsonReader& json, SingleStepState& state)
+{
+    state.ram.clear();
+    if (!json.BeginObject())
+        return false;
+
+    std::string key;
+    int64_t value = 0;
+    while (json.NextKey(key))
+    {
+        if (key == "ram")
+        {
+            json.BeginArray();
+            while (json.NextElement())
+            {
+                int64_t address = 0, byte = 0;
+                json.BeginArray();
+                json.NextElement();
+                json.ReadNumber(address);
+                json.NextElement();
+                json.ReadNumber(byte);
+                while (json.NextElement())
+                    json.Skip();
+                state.ram.emplace_back(static_cast<uint16_t>(address), static_cast<uint8_t>(byte));
+            }
+        }
+        else if (key == "pc" || key == "s" || key == "a" || key == "x" || key == "y" || key == "p")
+        {
+            json.ReadNumber(value);
+            if (key == "pc")
+                state.pc = static_cast<uint16_t>(value);
+            else
+            {
+                auto const byte = static_cast<uint8_t>(value);
+                switch (key[0])
+                {
+                case 'p': state.p = byte; break;
+                case 's': state.sp = byte; break;
+                case 'a': state.a = byte; break;
+                case 'x': state.x = byte; break;
+                case 'y': state.y = byte; break;
+                }
+            }
+        }
+        else
+        {
+            json.Skip();
+        }
+    }
+
+    return !json.Failed();
+}
+
+// Call after NextElement said there's another case.
+inline bool ReadSingleStepCase(JsonReader& json, SingleStepCase& test)
+{
+    if (!json.BeginObject())
+        return false;
+
+    std::string key;
+    while (json.NextKey(key))
+    {
+        if (key == "name")
+            json.ReadString(test.name);
+        else if (key == "initial")
+            ReadSingleStepState(json, test.initial);
+        else if (key == "final")
+            ReadSingleStepState(json, test.final);
+        else if (key == "cycles")
+        {
+            test.cycles.clear();
+            json.BeginArray();
+            while (json.NextElement())
+            {
+                int64_t address = 0, value = 0;
+                std::string kind;
+                json.BeginArray();
+                json.NextElement();
+                json.ReadNumber(address);
+                json.NextElement();
+                json.ReadNumber(value);
+                json.NextElement();
+                json.ReadString(kind);
+                while (json.NextElement())
+                    json.Skip();
+
+                test.cycles.push_back({ test.cycles.size(), static_cast<uint16_t>(address), static_cast<uint8_t>(value),
+                                        kind == "write" ? nes::BusKind::Write : nes::BusKind::Read });
+            }
+        }
+        else
+            json.Skip();
+    }
+
+    return !json.Failed();
+}
+
+inline std::string DescribeBusEvent(std::span<nes::BusEvent const> events, size_t i)
+{
+    if (i >= events.size())
+        return "nothing";
+
+    char text[16];
+    snprintf(text, sizeof(text), "%c%04X=%02X", events[i].kind == nes::BusKind::Write ? 'w' : 'r', events[i].address,
+             events[i].value);
+    return text;
+}
+
+// Empty if it passed, otherwise what was wrong. cpu has to be on recorder, which is on memory.
+inline std::string RunSingleStepCase(nes::CPU& cpu, nes::FlatMemory& memory, nes::BusRecorder& recorder,
+                                     SingleStepCase const& test, bool checkBus)
+{
+    for (auto [address, value] : test.initial.ram)
+        memory.data[address] = value;
+
+    cpu.pc = test.initial.pc;
+    cpu.sp = test.initial.sp;
+    cpu.a = test.initial.a;
+    cpu.x = test.initial.x;
+    cpu.y = test.initial.y;
+    cpu.s = test.initial.p;
+
+    recorder.Clear();
+    size_t const cycles = cpu.Step();
+
+    std::string error;
+    char text[96];
+    auto check = [&](char const* what, unsigned got, unsigned expected) {
+        if (got != expected)
+        {
+            snprintf(text, sizeof(text), " %s %02X want %02X", what, got, expected);
+            error += text;
+        }
+    };
+
+    check("pc", cpu.pc, test.final.pc);
+    check("sp", cpu.sp, test.final.sp);
+    check("a", cpu.a, test.final.a);
+    check("x", cpu.x, test.final.x);
+    check("y", cpu.y, test.final.y);
+    check("p", cpu.s, test.final.p);
+    check("cycles", static_cast<unsigned>(cycles), static_cast<unsigned>(test.cycles.size()));
+    for (auto [address, value] : test.final.ram)
+    {
+        if (memory.data[address] != value)
+        {
+            snprintf(text, sizeof(text), " [%04X] %02X want %02X", address, memory.data[address], value);
+            error += text;
+        }
+    }
+
+    if (checkBus)
+    {
+        if (auto const first = recorder.Compare(test.cycles))
+        {
+            error += " bus cycle " + std::to_string(*first) + " " + DescribeBusEvent(recorder.Events(), *first) +
+                     " want " + DescribeBusEvent(test.cycles, *first);
+        }
+    }
+
+    // Only what this case touched, clearing all 64K every time would be most of the run
+    for (auto [address, value] : test.initial.ram)
+        memory.data[address] = 0;
+    for (auto [address, value] : test.final.ram)
+        memory.data[address] = 0;
+
+    return error.empty() ? error : test.name + ":" + error;
+}
+
+struct SingleStepResult
+{
+    size_t cases = 0;
+    size_t failures = 0;
+    bool parsed = true;
+    std::string firstFailure;
+};
+
+inline SingleStepResult RunSingleStepFile(std::istream& stream, bool checkBus = false)
+{
+    SingleStepResult result;
+    auto memory = std::make_unique<nes::FlatMemory>();
+    nes::BusRecorder recorder(*memory);
+    nes::CPU cpu(&recorder);
+
+    JsonReader json(stream);
+    SingleStepCase test;
+    if (!json.BeginArray())
+        result.parsed = false;
+
+    while (result.parsed && json.NextElement())
+    {
+        if (!ReadSingleStepCase(json, test))
+        {
+            result.parsed = false;
+            break;
+        }
+
+        result.cases++;
+        auto error = RunSingleStepCase(cpu, *memory, recorder, test, checkBus);
+        if (!error.empty() && result.failures++ == 0)
+            result.firstFailure = std::move(error);
+    }
+
+    result.parsed = result.parsed && !json.Failed();
+    return result;
+}
+
+#endif //NES_SINGLESTEP_H
@@ -0,0 +1,83 @@
+#include "singlestep.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+// Two real cases from the nes6502 corpus, reformatted, plus one that's been broken
+static char const* const LdaImmediate = R"([
+{ "name": "a9 2b 4c", "initial": { "pc": 59448, "s": 242, "a": 137, "x": 198, "y": 83, "p": 225,
+    "ram": [ [59448, 169], [59449, 43], [59450, 76] ] },
+  "final": { "pc": 59450, "s": 242, "a": 43, "x": 198, "y": 83, "p": 97,
+    "ram": [ [59448, 169], [59449, 43], [59450, 76] ] },
+  "cycles": [ [59448, 169, "read"], [59449, 43, "read"] ] },
+{ "name": "a9 00 00", "initial": { "pc": 100, "s": 253, "a": 1, "x": 0, "y": 0, "p": 36,
+    "ram": [ [100, 169], [101, 0] ] },
+  "final": { "pc": 102, "s": 253, "a": 0, "x": 0, "y": 0, "p": 38,
+    "ram": [ [100, 169], [101, 0] ] },
+  "cycles": [ [100, 169, "read"], [101, 0, "read"] ] },
+{ "name": "a9 01 broken", "initial": { "pc": 100, "s": 253, "a": 0, "x": 0, "y": 0, "p": 36,
+    "ram": [ [100, 169], [101, 1] ] },
+  "final": { "pc": 102, "s": 253, "a": 2, "x": 0, "y": 0, "p": 36,
+    "ram": [ [100, 169], [101, 1] ] },
+  "cycles": [ [100, 169, "read"], [101, 1, "read"] ] }
+])";
+
+TEST(SingleStepTest, Runs_Cases_And_Reports_First_Failure)
+{
+    std::istringstream stream(LdaImmediate);
+    auto const result = RunSingleStepFile(stream);
+
+    EXPECT_TRUE(result.parsed);
+    EXPECT_EQ(result.cases, 3);
+    EXPECT_EQ(result.failures, 1);
+    EXPECT_EQ(result.firstFailure, "a9 01 broken: a 01 want 02");
+}
+
+TEST(SingleStepTest, Bus_Check_Passes_Matching_Accesses)
+{
+    std::istringstream stream(LdaImmediate);
+    auto const result = RunSingleStepFile(stream, true);
+
+    EXPECT_EQ(result.cases, 3);
+    EXPECT_EQ(result.failures, 1);
+}
+
+// Real 6502s read the byte after an implied opcode and throw it away
+TEST(SingleStepTest, Bus_Check_Reports_Missing_Dummy_Read)
+{
+    std::istringstream stream(R"([
+{ "name": "aa", "initial": { "pc": 100, "s": 253, "a": 5, "x": 0, "y": 0, "p": 36, "ram": [ [100, 170], [101, 9] ] },
+  "final": { "pc": 101, "s": 253, "a": 5, "x": 5, "y": 0, "p": 36, "ram": [ [100, 170], [101, 9] ] },
+  "cycles": [ [100, 170, "read"], [101, 9, "read"] ] }
+])");
+    auto const result = RunSingleStepFile(stream, true);
+
+    EXPECT_EQ(result.failures, 1);
+    EXPECT_EQ(result.firstFailure, "aa: bus cycle 1 nothing want r0065=09");
+}
+
+TEST(SingleStepTest, Stops_On_Bad_Json)
+{
+    std::istringstream stream(R"([ { "name": "a9", "initial": { "pc": 1, )");
+    auto const result = RunSingleStepFile(stream);
+    EXPECT_FALSE(result.parsed);
+}
+
+TEST(JsonReaderTest, Skips_Anything)
+{
+    std::istringstream stream(R"({ "a": [1, -2, {"b": "c\"d"}], "t": true, "n": null, "z": 3 })");
+    JsonReader json(stream);
+
+    std::string key;
+    int64_t value = 0;
+    ASSERT_TRUE(json.BeginObject());
+    while (json.NextKey(key))
+    {
+        if (key == "z")
+            json.ReadNumber(value);
+        else
+            json.Skip();
+    }
+
+    EXPECT_FALSE(json.Failed());
+    EXPECT_EQ(value, 3);
+}
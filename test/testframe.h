@@ -0,0 +1,50 @@
+#ifndef NES_TESTFRAME_H
+#define NES_TESTFRAME_H
+
+#include "../src/frame.h"
+#include <cstdint>
+#include <memory>
+
+// Frames for the filter and screenshot tests. On the heap, they're 120KB.
+
+inline std::unique_ptr<nes::FrameBuffer> SolidFrame(nes::Pixel pixel)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    frame->fill(pixel);
+    return frame;
+}
+
+// pick turns a new number from an LCG into each pixel, so the same seed always makes
+// the same frame.
+template <typename Pick>
+inline std::unique_ptr<nes::FrameBuffer> RandomFrame(uint32_t seed, Pick pick)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (auto& pixel : *frame)
+    {
+        seed = seed * 1664525 + 1013904223;
+        pixel = pick(seed);
+    }
+    return frame;
+}
+
+// Every index and emphasis bit in there somewhere.
+inline std::unique_ptr<nes::FrameBuffer> NoiseFrame(uint32_t seed)
+{
+    return RandomFrame(seed, [](uint32_t random) { return static_cast<nes::Pixel>((random >> 16) & nes::PixelMask); });
+}
+
+// Blocks of colour 8 wide and 16 tall, like tiles without the detail, all of them
+// moved along by base.
+inline std::unique_ptr<nes::FrameBuffer> BlockFrame(nes::Pixel base)
+{
+    auto frame = std::make_unique<nes::FrameBuffer>();
+    for (unsigned y = 0; y < nes::FrameHeight; y++)
+    {
+        for (unsigned x = 0; x < nes::FrameWidth; x++)
+            (*frame)[y * nes::FrameWidth + x] = static_cast<nes::Pixel>((base + x / 8 + (y / 16) * 3) & nes::PixelIndexMask);
+    }
+    return frame;
+}
+
+#endif //NES_TESTFRAME_H
@@ -0,0 +1,118 @@
+#ifndef NES_TESTROM_H
+#define NES_TESTROM_H
+
+#include "../src/cartridge.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// 16K NROM cart with program at $C000 and the reset vector pointing at it. Rest of
+// PRG is NOPs.
+inline std::shared_ptr<nes::Cartridge const> MakeTestCartridge(std::vector<uint8_t> const& program)
+{
+    nes::Cartridge cartridge = {};
+    cartridge.header = { { 'N', 'E', 'S', 0x1A }, 1, 0, 0, 0, 0, 0, 0, { 0 } };
+    cartridge.prgRom.assign(nes::ProgRomBankSize, 0xEA);
+    std::copy(program.begin(), program.end(), cartridge.prgRom.begin());
+    cartridge.prgRom[0x3FFC] = 0x00;
+    cartridge.prgRom[0x3FFD] = 0xC0;
+
+    return std::make_shared<nes::Cartridge const>(std::move(cartridge));
+}
+
+// Reads pad 1 in a loop, adds the A bit into $10 and counts loops in $11.
+// Anything that gets input wrong shows up in RAM straight away.
+inline std::vector<uint8_t> PadReaderProgram()
+{
+    return {
+        0xA9, 0x01,       // LDA #1
+        0x8D, 0x16, 0x40, // STA $4016
+        0xA9, 0x00,       // LDA #0
+        0x8D, 0x16, 0x40, // STA $4016
+        0xAD, 0x16, 0x40, // LDA $4016
+        0x65, 0x10,       // ADC $10
+        0x85, 0x10,       // STA $10
+        0xE6, 0x11,       // INC $11
+        0x4C, 0x00, 0xC0, // JMP $C000
+    };
+}
+
+// LDA #value, STA address
+inline void Store(std::vector<uint8_t>& program, uint16_t address, uint8_t value)
+{
+    // A byte at a time, GCC 12 thinks inserting a list into an empty vector overflows
+    for (uint8_t byte : { uint8_t { 0xA9 }, value, uint8_t { 0x8D }, static_cast<uint8_t>(address), static_cast<uint8_t>(address >> 8) })
+        program.push_back(byte);
+}
+
+// Program at $C000 like MakeTestCartridge, with the NMI vector pointing at handler,
+// which goes at $C800.
+inline std::shared_ptr<nes::Cartridge const> MakeNmiCartridge(std::vector<uint8_t> const& program,
+                                                              std::vector<uint8_t> const& handler)
+{
+    auto cartridge = *MakeTestCartridge(program);
+    std::copy(handler.begin(), handler.end(), cartridge.prgRom.begin() + 0x800);
+    cartridge.prgRom[0x3FFA] = 0x00;
+    cartridge.prgRom[0x3FFB] = 0xC8;
+    return std::make_shared<nes::Cartridge const>(std::move(cartridge));
+}
+
+// Sets up a picture with sprite 0 over the background, turns on NMIs, then samples
+// $2002 into RAM as fast as it can, so anything about when vblank and sprite 0 land
+// shows up in the hash.
+inline std::shared_ptr<nes::Cartridge const> MakeStatusSampler()
+{
+    std::vector<uint8_t> program;
+    Store(program, 0x2006, 0x3F);
+    Store(program, 0x2006, 0x00);
+    for (int palette = 0; palette < 8; palette++)
+    {
+        // All the background palettes the same, and all the sprite ones
+        std::vector<uint8_t> const colors = palette < 4 ? std::vector<uint8_t> { 0x0F, 0x16, 0x27, 0x30 }
+                                                        : std::vector<uint8_t> { 0x0F, 0x1A, 0x2A, 0x3A };
+        for (auto color : colors)
+            Store(program, 0x2007, color);
+    }
+
+    Store(program, 0x2006, 0x00);
+    Store(program, 0x2006, 0x10);
+    for (uint8_t row : { 0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0x7E, 0x3C, 0x18, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0xFF })
+        Store(program, 0x2007, row);
+
+    Store(program, 0x2006, 0x21);
+    Store(program, 0x2006, 0x00);
+    for (int i = 0; i < 64; i++)
+        Store(program, 0x2007, 0x01);
+
+    Store(program, 0x0200, 0x3F); // Sprite 0 on lines 64-71, over the tiles in row 8
+    Store(program, 0x0201, 0x01);
+    Store(program, 0x0202, 0x00);
+    Store(program, 0x0203, 0x30);
+    Store(program, 0x4014, 0x02);
+
+    Store(program, 0x2005, 0x03);
+    Store(program, 0x2005, 0x00);
+    Store(program, 0x2000, 0x80);
+    Store(program, 0x2001, 0x1E);
+
+    auto const loop = static_cast<uint16_t>(0xC000 + program.size());
+    program.insert(program.end(), {
+        0xAD, 0x02, 0x20, // LDA $2002
+        0x9D, 0x00, 0x03, // STA $0300,X
+        0xE8,             // INX
+        0x4C, static_cast<uint8_t>(loop), static_cast<uint8_t>(loop >> 8),
+    });
+
+    // Keeps the status at vblank and scrolls a pixel further every frame
+    return MakeNmiCartridge(program, {
+        0xAD, 0x02, 0x20, // LDA $2002
+        0x85, 0x11,       // STA $11
+        0xE6, 0x10,       // INC $10
+        0xA5, 0x10,       // LDA $10
+        0x8D, 0x05, 0x20, // STA $2005
+        0x8D, 0x05, 0x20, // STA $2005
+        0x40,             // RTI
+    });
+}
+
+#endif //NES_TESTROM_H
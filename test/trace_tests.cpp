@@ -0,0 +1,254 @@
+#include "../src/console.h"
+#include "../src/disassembler.h"
+#include "../src/trace.h"
+#include "testrom.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+
+static std::string TracePath(char const* name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+TEST(DisassemblerTest, Formats_Each_Address_Mode)
+{
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x4C, 0xF5, 0xC5), "JMP $C5F5");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0xA9, 0x00, 0x00), "LDA #$00");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0xB1, 0x80, 0x00), "LDA ($80),Y");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x81, 0x10, 0x00), "STA ($10,X)");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x9D, 0x00, 0x02), "STA $0200,X");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0xB6, 0x44, 0x00), "LDX $44,Y");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x6C, 0xFF, 0x02), "JMP ($02FF)");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x0A, 0x00, 0x00), "ASL A");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0xEA, 0x00, 0x00), "NOP");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x02, 0x00, 0x00), "???");
+}
+
+TEST(DisassemblerTest, Branches_Show_Target)
+{
+    EXPECT_EQ(nes::Disassemble(0xC000, 0xD0, 0xFE, 0x00), "BNE $C000");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x10, 0x10, 0x00), "BPL $C012");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x24, 0x10, 0x00), "BIT $10");
+    EXPECT_EQ(nes::Disassemble(0xC000, 0x00, 0x00, 0x00), "BRK");
+}
+
+TEST(TraceTest, Formats_Like_Nestest)
+{
+    nes::TraceRecord record {};
+    record.pc = 0xC000;
+    record.opcode = 0x4C;
+    record.operands[0] = 0xF5;
+    record.operands[1] = 0xC5;
+    record.p = 0x24;
+    record.sp = 0xFD;
+
+    EXPECT_EQ(nes::FormatNestest(record, 7),
+              "C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7");
+}
+
+// Small ring so the writer wraps and the producer has to wait on it, and enough
+// records for several blocks and a cycle wrap.
+TEST(TraceTest, Round_Trips_Through_File)
+{
+    auto const path = TracePath("nes_trace_test.bin");
+    uint64_t const count = 3 * nes::Tracer::BlockRecords + 123;
+
+    {
+        nes::Tracer tracer(path, 64);
+        ASSERT_TRUE(tracer.IsOpen());
+        tracer.SetCycle(0xFFFF0000);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            nes::TraceRecord record {};
+            record.pc = static_cast<uint16_t>(0xC000 + i % 37);
+            record.opcode = static_cast<uint8_t>(i);
+            record.a = static_cast<uint8_t>(i * 7);
+            record.cycle = static_cast<uint32_t>(0xFFFF0000 + i * 3);
+            tracer.Push(record);
+        }
+        EXPECT_EQ(tracer.Records(), count);
+    }
+
+    auto reader = nes::TraceReader::Open(path);
+    ASSERT_TRUE(reader.has_value());
+
+    nes::TraceRecord record;
+    uint64_t cycle;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        ASSERT_TRUE(reader->Next(record, cycle)) << i;
+        EXPECT_EQ(record.pc, 0xC000 + i % 37);
+        EXPECT_EQ(record.opcode, static_cast<uint8_t>(i));
+        EXPECT_EQ(record.a, static_cast<uint8_t>(i * 7));
+        EXPECT_EQ(cycle, 0xFFFF0000 + i * 3);
+    }
+    EXPECT_FALSE(reader->Next(record, cycle));
+
+    std::filesystem::remove(path);
+}
+
+TEST(TraceTest, Rejects_Other_Files)
+{
+    auto const path = TracePath("nes_trace_test.txt");
+    {
+        std::ofstream file(path);
+        file << "not a trace";
+    }
+
+    EXPECT_FALSE(nes::TraceReader::Open(path).has_value());
+    std::filesystem::remove(path);
+}
+
+#if NES_TRACER
+TEST(TraceTest, Records_Every_Instruction_Before_It_Runs)
+{
+    auto const path = TracePath("nes_trace_cpu.bin");
+    nes::Console console(MakeTestCartridge(PadReaderProgram()));
+    console.Reset();
+
+    {
+        nes::Tracer tracer(path);
+        console.cpu.tracer = &tracer;
+        console.RunFrame();
+        console.cpu.tracer = nullptr;
+        EXPECT_EQ(tracer.Records(), console.instructions);
+    }
+
+    auto reader = nes::TraceReader::Open(path);
+    ASSERT_TRUE(reader.has_value());
+
+    nes::TraceRecord record;
+    uint64_t cycle;
+    ASSERT_TRUE(reader->Next(record, cycle));
+    EXPECT_EQ(nes::FormatNestest(record, cycle).substr(0, 32), "C000  A9 01     LDA #$01        ");
+    EXPECT_EQ(cycle, 0);
+
+    ASSERT_TRUE(reader->Next(record, cycle));
+    EXPECT_EQ(record.pc, 0xC002);
+    EXPECT_EQ(record.a, 0x01); // After the LDA
+    EXPECT_EQ(cycle, 2);
+
+    uint64_t records = 2;
+    while (reader->Next(record, cycle))
+        records++;
+    EXPECT_EQ(records, console.instructions);
+
+    std::filesystem::remove(path);
+}
+
+TEST(TraceTest, Records_Operands_For_Every_Official_Opcode)
+{
+    auto const path = TracePath("nes_trace_operands.bin");
+    std::vector<uint8_t> program(0x12, 0xEA);
+    program[0x00] = 0x20; // JSR $C010
+    program[0x01] = 0x10;
+    program[0x02] = 0xC0;
+    program[0x10] = 0xD0; // BNE +5, not in the CPU table yet
+    program[0x11] = 0x05;
+
+    nes::Console console(MakeTestCartridge(program));
+    console.Reset();
+    {
+        nes::Tracer tracer(path);
+        console.cpu.tracer = &tracer;
+        console.RunFrame();
+        console.cpu.tracer = nullptr;
+    }
+
+    auto reader = nes::TraceReader::Open(path);
+    ASSERT_TRUE(reader.has_value());
+
+    nes::TraceRecord record;
+    uint64_t cycle;
+    ASSERT_TRUE(reader->Next(record, cycle));
+    EXPECT_EQ(nes::FormatNestest(record, cycle).substr(0, 32), "C000  20 10 C0  JSR $C010       ");
+
+    ASSERT_TRUE(reader->Next(record, cycle));
+    EXPECT_EQ(record.pc, 0xC010);
+    EXPECT_EQ(record.operands[0], 0x05);
+    EXPECT_EQ(record.operands[1], 0x00); // Two byte instruction, the NOP after isn't part of it
+
+    std::filesystem::remove(path);
+}
+
+// NMIs and DMA stalls aren't instructions, but their cycles still have to show up
+TEST(TraceTest, Cycles_Include_Nmi_And_Dma)
+{
+    auto const path = TracePath("nes_trace_nmi.bin");
+    std::vector<uint8_t> program;
+    Store(program, 0x2000, 0x80); // NMI on
+    program.insert(program.end(), { 0x4C, 0x05, 0xC0 }); // JMP to itself
+
+    std::vector<uint8_t> handler;
+    Store(handler, 0x4014, 0x02); // OAM DMA from $0200
+    handler.push_back(0x40);      // RTI
+
+    nes::Console console(MakeNmiCartridge(program, handler));
+    console.Reset();
+    console.RunFrame();
+
+    uint64_t const start = console.cycles;
+    {
+        nes::Tracer tracer(path);
+        tracer.SetCycle(start);
+        console.cpu.tracer = &tracer;
+        console.RunFrame();
+        console.RunFrame();
+        console.cpu.tracer = nullptr;
+    }
+
+    auto reader = nes::TraceReader::Open(path);
+    ASSERT_TRUE(reader.has_value());
+
+    // Instruction cycles from the table, stalls as the gaps between records
+    nes::TraceRecord record, last {};
+    uint64_t cycle, lastCycle = 0;
+    uint64_t nmis = 0, dmas = 0;
+    while (reader->Next(record, cycle))
+    {
+        if (record.pc == 0xC800)
+        {
+            nmis++;
+            EXPECT_EQ(cycle - lastCycle, 3 + 7u); // The JMP, then the NMI
+        }
+        if (last.pc == 0xC802)
+        {
+            dmas++;
+            auto const stall = cycle - lastCycle - 4; // The STA
+            EXPECT_TRUE(stall == 513 || stall == 514) << stall;
+        }
+        last = record;
+        lastCycle = cycle;
+    }
+    EXPECT_EQ(nmis, 2);
+    EXPECT_EQ(dmas, 2);
+
+    // The next instruction would have been recorded at wherever the console is now
+    EXPECT_EQ(lastCycle + 3, console.cycles);
+
+    std::filesystem::remove(path);
+}
+
+// The tracer reading the instruction bytes mustn't look like the program reading them
+TEST(TraceTest, Tracing_Is_Invisible_To_The_Bus)
+{
+    auto const reads = [](bool trace) {
+        nes::Console console(MakeTestCartridge(PadReaderProgram()));
+        size_t hits = 0;
+        console.memory.AddWatchpoint(0x0000, 0xFFFF, nes::WatchRead | nes::WatchExecute);
+        console.memory.onWatch = [&hits](nes::WatchHit const&) { hits++; };
+        console.Reset();
+
+        nes::Tracer tracer(TracePath("nes_trace_bus.bin"));
+        console.cpu.tracer = trace ? &tracer : nullptr;
+        console.RunFrame();
+        console.cpu.tracer = nullptr;
+        return hits;
+    };
+
+    auto const untraced = reads(false);
+    EXPECT_GT(untraced, 0);
+    EXPECT_EQ(reads(true), untraced);
+    std::filesystem::remove(TracePath("nes_trace_bus.bin"));
+}
+#endif
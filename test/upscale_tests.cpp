@@ -0,0 +1,81 @@
+#include "../filters/upscale.h"
+#include "../src/scheduler.h"
+#include "testframe.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Mostly black with some red and white, so matching neighbours turn up often
+// enough for every rule to get its turn
+static std::unique_ptr<nes::FrameBuffer> Shapes(uint32_t seed)
+{
+    return RandomFrame(seed, [](uint32_t random) {
+        return static_cast<nes::Pixel>((random >> 28) < 10 ? 0x0F : (random >> 29) == 7 ? 0x16 : 0x30);
+    });
+}
+
+static std::vector<uint32_t> Upscale(nes::Upscaler& upscaler, nes::FrameBuffer const& frame, bool simd,
+                                     nes::JobScheduler* scheduler = nullptr)
+{
+    std::vector<uint32_t> out(upscaler.OutputWidth() * upscaler.OutputHeight());
+    auto* bytes = reinterpret_cast<uint8_t*>(out.data());
+    if (simd)
+        upscaler.Apply(frame, bytes, upscaler.OutputWidth() * 4, scheduler);
+    else
+        upscaler.ApplyScalar(frame, bytes, upscaler.OutputWidth() * 4);
+    return out;
+}
+
+TEST(UpscaleTest, Solid_Stays_Solid)
+{
+    auto const frame = SolidFrame(0x21);
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::RGBA8888);
+    for (unsigned scale : { 2u, 3u, 4u })
+    {
+        nes::Upscaler upscaler({ .scale = scale });
+        EXPECT_EQ(upscaler.OutputWidth(), nes::FrameWidth * scale);
+        auto const out = Upscale(upscaler, *frame, true);
+        EXPECT_TRUE(std::all_of(out.begin(), out.end(), [&](uint32_t p) { return p == lut[0x21]; })) << scale;
+    }
+}
+
+TEST(UpscaleTest, Scale2x_Rounds_Off_Corners)
+{
+    // Row 9 and the pixel left of (10, 10) are white, so (10, 10) has a white
+    // corner top left and nowhere else
+    auto frame = SolidFrame(0x0F);
+    std::fill_n(frame->begin() + 9 * nes::FrameWidth, nes::FrameWidth, 0x30);
+    (*frame)[10 * nes::FrameWidth + 9] = 0x30;
+
+    nes::Upscaler upscaler;
+    nes::PaletteLut const lut(nes::Palette::Default(), nes::PixelFormat::RGBA8888);
+    auto const out = Upscale(upscaler, *frame, true);
+    auto at = [&](unsigned x, unsigned y) { return out[y * upscaler.OutputWidth() + x]; };
+    EXPECT_EQ(at(20, 20), lut[0x30]);
+    EXPECT_EQ(at(21, 20), lut[0x0F]);
+    EXPECT_EQ(at(20, 21), lut[0x0F]);
+    EXPECT_EQ(at(21, 21), lut[0x0F]);
+    EXPECT_EQ(at(40, 20), lut[0x0F]); // Under a straight edge, nothing
+}
+
+TEST(UpscaleTest, Simd_Matches_Scalar)
+{
+    auto const frame = Shapes(7);
+    for (unsigned scale : { 2u, 3u, 4u })
+    {
+        nes::Upscaler upscaler({ .scale = scale });
+        EXPECT_EQ(Upscale(upscaler, *frame, true), Upscale(upscaler, *frame, false)) << scale;
+    }
+}
+
+TEST(UpscaleTest, Bands_Match_One_Thread)
+{
+    auto const frame = Shapes(8);
+    nes::JobScheduler scheduler(3, false);
+    for (unsigned scale : { 2u, 3u, 4u })
+    {
+        nes::Upscaler upscaler({ .scale = scale });
+        EXPECT_EQ(Upscale(upscaler, *frame, true, &scheduler), Upscale(upscaler, *frame, true)) << scale;
+    }
+}
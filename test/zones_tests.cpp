@@ -0,0 +1,67 @@
+#include "../src/zones.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+static size_t Count(std::string const& text, std::string const& what)
+{
+    size_t count = 0;
+    for (auto at = text.find(what); at != std::string::npos; at = text.find(what, at + 1))
+        count++;
+    return count;
+}
+
+TEST(ZonesTest, Exports_Each_Thread_With_Its_Zones)
+{
+    nes::ClearZones();
+
+    nes::NameZoneThread("main \"test\"");
+    nes::RecordZone("outer", 1000, 5000);
+
+    std::thread other([] {
+        nes::NameZoneThread("other");
+        nes::RecordZone("inner", 2000, 3000);
+        nes::RecordZone("inner", 3000, 4000);
+    });
+    other.join();
+
+    std::stringstream stream;
+    nes::WriteZoneTrace(stream);
+    auto const json = stream.str();
+
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0);
+    EXPECT_EQ(Count(json, "\"name\":\"outer\",\"ph\":\"X\""), 1);
+    EXPECT_EQ(Count(json, "\"name\":\"inner\",\"ph\":\"X\""), 2);
+    EXPECT_NE(json.find("\"args\":{\"name\":\"main \\\"test\\\"\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"name\":\"other\"}"), std::string::npos);
+    EXPECT_EQ(nes::DroppedZones(), 0);
+}
+
+TEST(ZonesTest, Drops_When_Full)
+{
+    nes::ClearZones();
+
+    std::thread thread([] {
+        for (size_t i = 0; i < nes::ZoneBufferCapacity + 10; i++)
+            nes::RecordZone("spin", i, i + 1);
+    });
+    thread.join();
+
+    EXPECT_EQ(nes::DroppedZones(), 10);
+    nes::ClearZones();
+    EXPECT_EQ(nes::DroppedZones(), 0);
+}
+
+#if NES_ENABLE_ZONES
+TEST(ZonesTest, Macro_Records_Scope)
+{
+    nes::ClearZones();
+    {
+        NES_ZONE("scoped");
+    }
+
+    std::stringstream stream;
+    nes::WriteZoneTrace(stream);
+    EXPECT_EQ(Count(stream.str(), "\"name\":\"scoped\""), 1);
+}
+#endif
@@ -0,0 +1,630 @@
+// Headless batch runner. Loads ROMs, runs them all at once across every core and
+// reports how fast each one went. This is the number we plan capacity from, so
+// keep anything that isn't emulation out of the timed part.
+//
+//   NES_Runner [--frames N | --cycles N] [--instances N] [--threads N]
+//              [--input script.txt] [--render-every N] [--no-pin] rom.nes [rom.nes ...]
+//
+// --render-every N only draws every Nth frame, 0 for none, which is all the same to
+// the CPU and RAM and a lot quicker.
+//
+// Movies, one ROM at a time:
+//
+//   NES_Runner --record movie.nesm [--frames N] [--input script.txt] rom.nes
+//   NES_Runner --verify movie.nesm [--threads N] rom.nes
+//
+// Cost of run-ahead, also one ROM:
+//
+//   NES_Runner --run-ahead N [--second-instance] [--frames N] [--input script.txt] rom.nes
+//
+// Memory access heatmap of each frame, prefix_00000.pgm and .csv and so on:
+//
+//   NES_Runner --heatmap prefix [--frames N] [--input script.txt] rom.nes
+//
+// Raw video and audio, streamed from a writer thread, one ROM. Either can be - for
+// stdout, to pipe into ffmpeg or mpv, and then everything else goes to stderr:
+//
+//   NES_Runner [--y4m video.y4m] [--wav audio.wav] [--frames N] [--input script.txt] rom.nes
+//
+// PNG screenshots of every Nth frame, prefix_00000.png and so on, encoded on a
+// background thread. --thumbnails makes them 128x120:
+//
+//   NES_Runner --screenshots prefix [--screenshot-every N] [--thumbnails] [--frames N] rom.nes
+//
+// --counters prints every instance's perf counters at the end, one key=value line each.
+//
+// --export name puts every instance's RAM and picture in POSIX shared memory as a
+// batch runs, /name.0, /name.1 and so on, --export-slots frames deep. See
+// observations.h for how to read them.
+//
+// In builds with NES_PROFILER=ON, --profile prefix profiles the first instance of a
+// batch run and writes prefix.txt (report) and prefix.folded (collapsed stacks for flamegraphs).
+//
+// In builds with NES_TRACER=ON, --trace file writes an instruction trace of the first
+// instance of a batch run. NES_TraceDecode turns it into a nestest style log.
+//
+// In builds with NES_ZONES=ON (not Release), --zones file.json writes where host
+// time went on each thread of a batch run, for chrome://tracing or ui.perfetto.dev.
+
+#include "capture.h"
+#include "cartridge.h"
+#include "console.h"
+#include "heatmap.h"
+#include "host.h"
+#include "inputscript.h"
+#include "movie.h"
+#include "observations.h"
+#include "profiler.h"
+#include "runahead.h"
+#include "scheduler.h"
+#include "screenshot.h"
+#include "trace.h"
+#include "zones.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#define NES_THREAD_CLOCK 1
+#endif
+
+struct Options
+{
+    uint64_t frames = 600;
+    uint64_t cycles = 0; // Asked for with --cycles, run as whole frames
+    uint32_t instancesPerRom = 1;
+    unsigned threads = 0;
+    bool pin = true;
+    std::string inputFile;
+    std::string recordFile;
+    std::string verifyFile;
+    std::string profilePrefix;
+    std::string heatmapPrefix;
+    std::string traceFile;
+    std::string zonesFile;
+    std::string y4mFile;
+    std::string wavFile;
+    std::string screenshotPrefix;
+    uint64_t screenshotEvery = 60;
+    bool thumbnails = false;
+    std::string exportName;
+    uint32_t exportSlots = 4;
+    uint32_t renderEvery = 1;
+    uint32_t runAhead = 0;
+    bool secondInstance = false;
+    bool counters = false;
+    std::vector<std::string> roms;
+};
+
+static void Usage()
+{
+    fprintf(stderr, "usage: NES_Runner [--frames N | --cycles N] [--instances N] [--threads N]\n"
+                    "                  [--input script.txt] [--render-every N] [--no-pin] [--counters]\n"
+                    "                  [--export name [--export-slots N]]\n"
+                    "                  rom.nes [rom.nes ...]\n"
+                    "       NES_Runner --record movie.nesm [--frames N] [--input script.txt] rom.nes\n"
+                    "       NES_Runner --verify movie.nesm [--threads N] rom.nes\n"
+                    "       NES_Runner --run-ahead N [--second-instance] [--frames N] [--input script.txt] rom.nes\n"
+                    "       NES_Runner --heatmap prefix [--frames N] [--input script.txt] rom.nes\n"
+                    "       NES_Runner [--y4m video.y4m] [--wav audio.wav] [--frames N] [--input script.txt] rom.nes\n"
+                    "       NES_Runner --screenshots prefix [--screenshot-every N] [--thumbnails] [--frames N] rom.nes\n");
+}
+
+// Modes that work on one console rather than a host full of them.
+static bool SingleRom(Options const& options)
+{
+    return !options.recordFile.empty() || !options.verifyFile.empty() || options.runAhead > 0 ||
+           !options.heatmapPrefix.empty() || !options.y4mFile.empty() || !options.wavFile.empty() ||
+           !options.screenshotPrefix.empty();
+}
+
+static void PrintCounters(size_t instance, nes::PerfCounterValues const& counters)
+{
+    static char const* const Regions[] = { "ram", "ppu", "io", "cart", "prg" };
+    auto number = [](uint64_t value) { return static_cast<unsigned long long>(value); };
+
+    printf("instance=%zu frames=%llu instructions=%llu cycles=%llu page_crossings=%llu dma_stall_cycles=%llu"
+           " fast_accesses=%llu slow_accesses=%llu last_frame_ns=%llu total_frame_ns=%llu",
+           instance, number(counters.frames), number(counters.instructions), number(counters.cycles),
+           number(counters.pageCrossings), number(counters.dmaStallCycles), number(counters.fastAccesses),
+           number(counters.slowAccesses), number(counters.lastFrameNanoseconds), number(counters.totalFrameNanoseconds));
+    for (size_t region = 0; region < nes::BusRegionCount; region++)
+        printf(" reads_%s=%llu writes_%s=%llu", Regions[region], number(counters.reads[region]), Regions[region],
+               number(counters.writes[region]));
+    printf("\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool const hasValue = i + 1 < argc;
+
+        if (arg == "--frames" && hasValue)
+        {
+            options.frames = std::strtoull(argv[++i], nullptr, 10);
+            options.cycles = 0;
+        }
+        else if (arg == "--cycles" && hasValue)
+        {
+            options.cycles = std::strtoull(argv[++i], nullptr, 10);
+            options.frames = (options.cycles + nes::CyclesPerFrame - 1) / nes::CyclesPerFrame;
+        }
+        else if (arg == "--instances" && hasValue)
+            options.instancesPerRom = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && hasValue)
+            options.threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--input" && hasValue)
+            options.inputFile = argv[++i];
+        else if (arg == "--record" && hasValue)
+            options.recordFile = argv[++i];
+        else if (arg == "--verify" && hasValue)
+            options.verifyFile = argv[++i];
+        else if (arg == "--run-ahead" && hasValue)
+            options.runAhead = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--second-instance")
+            options.secondInstance = true;
+        else if (arg == "--heatmap" && hasValue)
+            options.heatmapPrefix = argv[++i];
+        else if (arg == "--profile" && hasValue)
+            options.profilePrefix = argv[++i];
+        else if (arg == "--trace" && hasValue)
+            options.traceFile = argv[++i];
+        else if (arg == "--zones" && hasValue)
+            options.zonesFile = argv[++i];
+        else if (arg == "--y4m" && hasValue)
+            options.y4mFile = argv[++i];
+        else if (arg == "--wav" && hasValue)
+            options.wavFile = argv[++i];
+        else if (arg == "--screenshots" && hasValue)
+            options.screenshotPrefix = argv[++i];
+        else if (arg == "--screenshot-every" && hasValue)
+            options.screenshotEvery = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--thumbnails")
+            options.thumbnails = true;
+        else if (arg == "--export" && hasValue)
+            options.exportName = argv[++i];
+        else if (arg == "--export-slots" && hasValue)
+            options.exportSlots = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--render-every" && hasValue)
+            options.renderEvery = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--counters")
+            options.counters = true;
+        else if (arg == "--no-pin")
+            options.pin = false;
+        else if (!arg.empty() && arg[0] != '-')
+            options.roms.push_back(arg);
+        else
+            return false;
+    }
+
+    if (SingleRom(options) && options.roms.size() != 1)
+        return false;
+
+    // Hooks go on the batch run, the single ROM modes never look at them
+    if (SingleRom(options) && (!options.profilePrefix.empty() || !options.traceFile.empty() || !options.zonesFile.empty() ||
+                               options.counters || !options.exportName.empty()))
+    {
+        fprintf(stderr, "--profile, --trace, --zones, --counters and --export only work on a batch run, not the one ROM modes\n");
+        return false;
+    }
+
+    // Both on stdout would interleave into something nothing can read
+    if (options.y4mFile == "-" && options.wavFile == "-")
+    {
+        fprintf(stderr, "--y4m and --wav can't both go to stdout\n");
+        return false;
+    }
+
+    return !options.roms.empty() && options.frames > 0 && options.instancesPerRom > 0 && options.exportSlots > 0 &&
+           options.screenshotEvery > 0;
+}
+
+// Null after saying why if it can't be run.
+static std::shared_ptr<nes::Cartridge const> LoadCartridge(std::string const& path)
+{
+    auto cartridge = nes::Cartridge::Load(path);
+    if (!cartridge)
+    {
+        fprintf(stderr, "Couldn't load %s, is it an iNES ROM?\n", path.c_str());
+        return nullptr;
+    }
+    if (auto const reason = cartridge->Unsupported())
+    {
+        fprintf(stderr, "Can't run %s, %s\n", path.c_str(), reason);
+        return nullptr;
+    }
+    return std::make_shared<nes::Cartridge const>(std::move(*cartridge));
+}
+
+static int Record(Options const& options, std::shared_ptr<nes::Cartridge const> cartridge, nes::InputScript const* script)
+{
+    nes::Console console(cartridge);
+    console.Reset();
+
+    nes::MovieRecorder recorder(console);
+    for (uint64_t frame = 0; frame < options.frames; frame++)
+        recorder.RunFrame(script ? script->At(frame) : std::array<uint8_t, 2> { 0, 0 });
+
+    if (!recorder.Recording().Save(options.recordFile))
+    {
+        fprintf(stderr, "Couldn't write %s\n", options.recordFile.c_str());
+        return 1;
+    }
+
+    printf("Recorded %zu frames to %s, final hash %016llx\n", recorder.Recording().inputs.size(),
+           options.recordFile.c_str(), static_cast<unsigned long long>(recorder.Recording().hashes.back()));
+    return 0;
+}
+
+static int Verify(Options const& options, std::shared_ptr<nes::Cartridge const> cartridge)
+{
+    auto movie = nes::Movie::Load(options.verifyFile);
+    if (!movie)
+    {
+        fprintf(stderr, "Couldn't read movie %s\n", options.verifyFile.c_str());
+        return 1;
+    }
+
+    if (movie->romHash != cartridge->Hash())
+    {
+        fprintf(stderr, "%s was recorded against a different ROM\n", options.verifyFile.c_str());
+        return 1;
+    }
+
+    nes::JobScheduler scheduler(options.threads, options.pin);
+    auto const mismatch = nes::VerifyMovie(*movie, cartridge, scheduler);
+    if (mismatch)
+    {
+        fprintf(stderr, "Diverged at frame %llu\n", static_cast<unsigned long long>(*mismatch));
+        return 1;
+    }
+
+    printf("%zu frames match, %zu segments on %u threads\n", movie->inputs.size(), movie->checkpoints.size(),
+           scheduler.WorkerCount());
+    return 0;
+}
+
+static int RunAhead(Options const& options, std::shared_ptr<nes::Cartridge const> cartridge, nes::InputScript const* script)
+{
+    nes::RunAhead runAhead(cartridge, options.runAhead, options.secondInstance);
+    runAhead.Reset();
+
+    for (uint64_t frame = 0; frame < options.frames; frame++)
+        runAhead.RunFrame(script ? script->At(frame) : std::array<uint8_t, 2> { 0, 0 });
+
+    auto const& stats = runAhead.GetStats();
+    double const real = static_cast<double>(stats.realNanoseconds) / stats.frames;
+    double const extra = static_cast<double>(stats.extraNanoseconds) / stats.frames;
+    printf("run-ahead %u frames, %s: real frame %.1fus, added %.1fus (%.0f ticks) per frame, %.2fx host cost\n",
+           options.runAhead, options.secondInstance ? "second instance" : "single instance",
+           real / 1000.0, extra / 1000.0, static_cast<double>(stats.extraTicks) / stats.frames,
+           real > 0 ? (real + extra) / real : 0.0);
+    return 0;
+}
+
+static int Heatmaps(Options const& options, std::shared_ptr<nes::Cartridge const> cartridge, nes::InputScript const* script)
+{
+    nes::Console console(cartridge);
+    console.inputScript = script;
+    console.Reset();
+
+    nes::Heatmap heatmap;
+    console.memory.SetHeatmap(&heatmap);
+
+    for (uint64_t frame = 0; frame < options.frames; frame++)
+    {
+        heatmap.Clear();
+        console.RunFrame();
+
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), "_%05llu", static_cast<unsigned long long>(frame));
+        std::ofstream pgm(options.heatmapPrefix + suffix + ".pgm", std::ios::binary);
+        std::ofstream csv(options.heatmapPrefix + suffix + ".csv");
+        heatmap.WritePgm(pgm);
+        heatmap.WriteCsv(csv);
+        if (!pgm || !csv)
+        {
+            fprintf(stderr, "Couldn't write %s%s\n", options.heatmapPrefix.c_str(), suffix);
+            return 1;
+        }
+    }
+
+    printf("Wrote %llu heatmaps to %s_*\n", static_cast<unsigned long long>(options.frames), options.heatmapPrefix.c_str());
+    return 0;
+}
+
+// CPU time this thread has had, which unlike the wall clock leaves out the time
+// other threads had the same core. 0 where there's no way to ask.
+static double ThreadSeconds()
+{
+#if NES_THREAD_CLOCK
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<double>(now.tv_sec) + now.tv_nsec * 1e-9;
+#else
+    return 0;
+#endif
+}
+
+static int Capture(Options const& options, std::shared_ptr<nes::Cartridge const> cartridge, nes::InputScript const* script)
+{
+    std::unique_ptr<nes::StreamWriter> videoOut, audioOut;
+    if (!options.y4mFile.empty() && !(videoOut = nes::StreamWriter::Open(options.y4mFile)))
+    {
+        fprintf(stderr, "Couldn't write %s\n", options.y4mFile.c_str());
+        return 1;
+    }
+    if (!options.wavFile.empty() && !(audioOut = nes::StreamWriter::Open(options.wavFile)))
+    {
+        fprintf(stderr, "Couldn't write %s\n", options.wavFile.c_str());
+        return 1;
+    }
+
+    std::optional<nes::Y4mWriter> video;
+    std::optional<nes::WavWriter> audio;
+    std::optional<nes::ScreenshotWriter> screenshots;
+    if (videoOut)
+        video.emplace(*videoOut);
+    if (audioOut)
+        audio.emplace(*audioOut);
+    if (!options.screenshotPrefix.empty())
+        screenshots.emplace();
+
+    nes::Console console(cartridge);
+    console.inputScript = script;
+    console.Reset();
+
+    // No APU yet, so the sound is silence, but it comes out at the right rate and
+    // stays in sync with the picture
+    std::vector<int16_t> samples;
+    double owedSamples = 0;
+
+    // What the emulation thread spends handing frames over is all capture should
+    // cost it, the rest is on the writer threads
+    double capturing = 0;
+    double const startCpu = ThreadSeconds();
+    auto const start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < options.frames; i++)
+    {
+        console.RunFrame();
+        double const ran = ThreadSeconds();
+        if (video)
+            video->WriteFrame(console.ppu.frame);
+        if (screenshots && i % options.screenshotEvery == 0)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), "_%05llu.png", static_cast<unsigned long long>(i));
+            screenshots->Save(options.screenshotPrefix + suffix, console.ppu.frame, { .shrink = options.thumbnails ? 2u : 1u });
+        }
+        if (audio)
+        {
+            owedSamples += audio->SampleRate() / nes::NtscFrameRate;
+            samples.assign(static_cast<size_t>(owedSamples), 0);
+            owedSamples -= samples.size();
+            audio->WriteSamples(samples);
+        }
+        capturing += ThreadSeconds() - ran;
+    }
+    double const emulating = ThreadSeconds() - startCpu;
+    if (audio)
+        audio->Finish();
+    if (videoOut)
+        videoOut->Flush();
+    if (screenshots)
+        screenshots->Flush();
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool failed = (videoOut && videoOut->Failed()) || (audioOut && audioOut->Failed());
+    fprintf(stderr, "Captured %llu frames in %.3fs (%.1f frames/s), %llu video and %llu audio bytes, %llu stalls%s\n",
+            static_cast<unsigned long long>(options.frames), seconds, seconds > 0 ? options.frames / seconds : 0.0,
+            static_cast<unsigned long long>(videoOut ? videoOut->BytesWritten() : 0),
+            static_cast<unsigned long long>(audioOut ? audioOut->BytesWritten() : 0),
+            static_cast<unsigned long long>((videoOut ? videoOut->Stalls() : 0) + (audioOut ? audioOut->Stalls() : 0)),
+            failed ? ", WRITE FAILED" : "");
+    fprintf(stderr, "Emulation thread %.3fs CPU, %.3fs (%.1f%%) of it handing frames over\n", emulating, capturing,
+            emulating > 0 ? 100 * capturing / emulating : 0.0);
+    if (screenshots)
+    {
+        auto const stats = screenshots->Stats();
+        fprintf(stderr, "%llu screenshots, %llu coalesced, %llu dropped, %llu waited for the encoder%s\n",
+                static_cast<unsigned long long>(stats.encoded), static_cast<unsigned long long>(stats.coalesced),
+                static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.waited),
+                stats.failed ? ", WRITE FAILED" : "");
+        failed |= stats.failed > 0;
+    }
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        Usage();
+        return 1;
+    }
+
+    std::optional<nes::InputScript> script;
+    if (!options.inputFile.empty())
+    {
+        script = nes::InputScript::Load(options.inputFile);
+        if (!script)
+        {
+            fprintf(stderr, "Couldn't read input script %s\n", options.inputFile.c_str());
+            return 1;
+        }
+    }
+
+    if (options.cycles > 0)
+    {
+        fprintf(stderr, "%llu cycles is %llu whole frames, running %llu cycles\n", static_cast<unsigned long long>(options.cycles),
+               static_cast<unsigned long long>(options.frames), static_cast<unsigned long long>(options.frames * nes::CyclesPerFrame));
+    }
+
+    if (SingleRom(options))
+    {
+        auto shared = LoadCartridge(options.roms[0]);
+        if (!shared)
+            return 1;
+
+        if (!options.y4mFile.empty() || !options.wavFile.empty() || !options.screenshotPrefix.empty())
+            return Capture(options, shared, script ? &*script : nullptr);
+        if (!options.heatmapPrefix.empty())
+            return Heatmaps(options, shared, script ? &*script : nullptr);
+        if (options.runAhead > 0)
+            return RunAhead(options, shared, script ? &*script : nullptr);
+        if (!options.recordFile.empty())
+            return Record(options, shared, script ? &*script : nullptr);
+        return Verify(options, shared);
+    }
+
+    nes::JobScheduler scheduler(options.threads, options.pin);
+    if (options.pin && scheduler.PinnedWorkers() < scheduler.WorkerCount())
+        fprintf(stderr, "Only pinned %u of %u workers, the rest can wander\n", scheduler.PinnedWorkers(), scheduler.WorkerCount());
+
+    nes::Host host(scheduler);
+
+    for (auto const& rom : options.roms)
+    {
+        auto shared = LoadCartridge(rom);
+        if (!shared)
+            return 1;
+
+        for (uint32_t i = 0; i < options.instancesPerRom; i++)
+        {
+            auto console = std::make_unique<nes::Console>(shared);
+            console->inputScript = script ? &*script : nullptr;
+            console->renderEvery = options.renderEvery;
+            console->Reset();
+            host.Add(std::move(console));
+        }
+    }
+
+    std::optional<nes::Profiler> profiler;
+    if (!options.profilePrefix.empty())
+    {
+#if NES_PROFILER
+        host.Instance(0).cpu.profiler = &profiler.emplace();
+#else
+        fprintf(stderr, "--profile needs a build configured with -DNES_PROFILER=ON\n");
+        return 1;
+#endif
+    }
+
+    std::optional<nes::Tracer> tracer;
+    if (!options.traceFile.empty())
+    {
+#if NES_TRACER
+        tracer.emplace(options.traceFile);
+        if (!tracer->IsOpen())
+        {
+            fprintf(stderr, "Couldn't write %s\n", options.traceFile.c_str());
+            return 1;
+        }
+        host.Instance(0).cpu.tracer = &*tracer;
+#else
+        fprintf(stderr, "--trace needs a build configured with -DNES_TRACER=ON\n");
+        return 1;
+#endif
+    }
+
+    std::vector<std::unique_ptr<nes::ObservationExport>> exports;
+    if (!options.exportName.empty())
+    {
+        auto const prefix = options.exportName[0] == '/' ? options.exportName : "/" + options.exportName;
+        for (size_t index = 0; index < host.InstanceCount(); index++)
+        {
+            auto const name = prefix + "." + std::to_string(index);
+            exports.push_back(nes::ObservationExport::Create(name, options.exportSlots));
+            if (!exports.back())
+            {
+                fprintf(stderr, "Couldn't make shared memory %s, is it already in use?\n", name.c_str());
+                return 1;
+            }
+            host.Instance(index).observations = exports.back().get();
+        }
+    }
+
+#if !NES_ENABLE_ZONES
+    if (!options.zonesFile.empty())
+    {
+        fprintf(stderr, "--zones needs a non-Release build configured with -DNES_ZONES=ON\n");
+        return 1;
+    }
+#endif
+
+    host.RunFrames(options.frames);
+
+    if (!options.zonesFile.empty())
+    {
+        std::ofstream zones(options.zonesFile);
+        nes::WriteZoneTrace(zones);
+        if (nes::DroppedZones() > 0)
+            fprintf(stderr, "%zu zones dropped, buffers were full\n", nes::DroppedZones());
+    }
+
+    if (tracer)
+    {
+        auto const records = tracer->Records();
+        auto const stalls = tracer->Stalls();
+        tracer.reset(); // Finishes writing
+        printf("Traced %llu instructions to %s, %llu stalls\n", static_cast<unsigned long long>(records),
+               options.traceFile.c_str(), static_cast<unsigned long long>(stalls));
+    }
+
+    if (profiler)
+    {
+        std::ofstream report(options.profilePrefix + ".txt");
+        std::ofstream stacks(options.profilePrefix + ".folded");
+        profiler->WriteReport(report);
+        profiler->WriteCollapsedStacks(stacks);
+    }
+
+    // Per ROM numbers are per instance, from the time each one actually spent running,
+    // so they don't depend on how many other things were sharing the box.
+    printf("%-32s %10s %12s %14s %12s\n", "rom", "frames", "frames/s", "instr/s", "cycles/instr");
+    for (size_t r = 0; r < options.roms.size(); r++)
+    {
+        uint64_t frames = 0, instructions = 0, nanoseconds = 0, ticks = 0;
+        for (uint32_t i = 0; i < options.instancesPerRom; i++)
+        {
+            auto const index = r * options.instancesPerRom + i;
+            frames += host.Stats(index).frames;
+            instructions += host.Instance(index).instructions;
+            nanoseconds += host.Stats(index).busyNanoseconds;
+            ticks += host.Stats(index).busyTicks;
+        }
+
+        double const seconds = nanoseconds / 1e9;
+        printf("%-32s %10llu %12.1f %14.0f %12.2f\n", options.roms[r].c_str(),
+               static_cast<unsigned long long>(frames),
+               seconds > 0 ? frames / seconds : 0.0,
+               seconds > 0 ? instructions / seconds : 0.0,
+               instructions ? static_cast<double>(ticks) / instructions : 0.0);
+    }
+
+    if (options.counters)
+    {
+        printf("\n");
+        for (size_t index = 0; index < host.InstanceCount(); index++)
+            PrintCounters(index, host.Instance(index).counters.Snapshot());
+    }
+
+    auto const metrics = host.Metrics();
+    printf("\n%llu instances on %u threads, %.3fs wall\n", static_cast<unsigned long long>(metrics.instances),
+           scheduler.WorkerCount(), metrics.seconds);
+    printf("total %.1f frames/s, frame latency mean %.1fus p99 %.1fus max %.1fus, %llu steals, %llu migrations\n",
+           metrics.framesPerSecond, metrics.meanLatencyMicroseconds, metrics.p99LatencyMicroseconds,
+           metrics.maxLatencyMicroseconds, static_cast<unsigned long long>(metrics.steals),
+           static_cast<unsigned long long>(metrics.migrations));
+
+    return 0;
+}
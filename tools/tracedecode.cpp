@@ -0,0 +1,51 @@
+// Turns a binary trace from Tracer back into text, one nestest.log style line per
+// instruction, so it can be diffed against another emulator's log.
+//
+//   NES_TraceDecode trace.bin [out.log]
+//
+// Writes to stdout without an output file.
+
+#include "trace.h"
+#include <cstdio>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        printf("usage: NES_TraceDecode trace.bin [out.log]\n");
+        return 1;
+    }
+
+    auto reader = nes::TraceReader::Open(argv[1]);
+    if (!reader)
+    {
+        printf("Couldn't read trace %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        printf("Couldn't write %s\n", argv[2]);
+        return 1;
+    }
+
+    nes::TraceRecord record;
+    uint64_t cycle;
+    uint64_t count = 0;
+    while (reader->Next(record, cycle))
+    {
+        auto const line = nes::FormatNestest(record, cycle);
+        fwrite(line.data(), 1, line.size(), out);
+        fputc('\n', out);
+        count++;
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+        printf("%llu instructions\n", static_cast<unsigned long long>(count));
+    }
+    return 0;
+}